@@ -0,0 +1,68 @@
+#ifndef _CENTER_OF_PRESSURE_HPP
+#define _CENTER_OF_PRESSURE_HPP
+
+#include <QPointF>
+#include <QVector>
+#include <QtGlobal>
+
+
+#define COP_DEFAULT_TRAIL_LENGTH 200 // frames
+#define COP_DEFAULT_MIN_WEIGHT	 1	 // summed weight of a foot below which it is considered lifted
+
+typedef enum {
+	COP_FOOT_LEFT,
+	COP_FOOT_RIGHT,
+	NUM_OF_COP_FOOT,
+} CopFoot;
+
+// fixed size ring of points, stored twice so the points from oldest to newest are always contiguous for drawPolyline
+class CopTrajectory {
+public:
+	CopTrajectory(int capacity = COP_DEFAULT_TRAIL_LENGTH);
+	~CopTrajectory();
+
+	void setCapacity(int capacity); // drops all points
+	void push(const QPointF& point);
+	void clear();
+
+	int capacity() const;
+	int size() const;
+	bool isEmpty() const;
+	const QPointF* data() const; // size() points, oldest first
+	const QPointF& last() const;
+
+private:
+	QVector<QPointF> buffer; // 2 * capacity, point i is written at i and i + capacity
+	int m_capacity = 0;
+	int head = 0, count = 0;
+};
+
+/*
+Center of pressure of each foot: the pressure weighted centroid of the sensor positions, accumulated sensor by sensor
+between begin() and end() so a frame needs no storage besides the running sums.
+*/
+class CenterOfPressure {
+public:
+	CenterOfPressure();
+	~CenterOfPressure();
+
+	void setTrailLength(int frames); // drops the trajectories
+	void setMinWeight(qreal weight);
+
+	void begin();
+	void add(CopFoot foot, qreal x, qreal y, qreal weight); // weight is the pressure of the sensor at x, y
+	void end(); // appends the centroid of every foot with enough weight to its trajectory
+	void clear();
+
+	bool isValid(CopFoot foot) const; // the foot had enough weight in the last frame
+	QPointF current(CopFoot foot) const;
+	const CopTrajectory& trajectory(CopFoot foot) const;
+
+private:
+	qreal sum_x[NUM_OF_COP_FOOT], sum_y[NUM_OF_COP_FOOT], sum_weight[NUM_OF_COP_FOOT];
+	bool valid[NUM_OF_COP_FOOT];
+	CopTrajectory trajectories[NUM_OF_COP_FOOT];
+	qreal min_weight = COP_DEFAULT_MIN_WEIGHT;
+};
+
+#endif // _CENTER_OF_PRESSURE_HPP
@@ -0,0 +1,51 @@
+#ifndef _CHART_AUTOSCALE_HPP
+#define _CHART_AUTOSCALE_HPP
+
+#include "sensor_pipeline.hpp"
+#include "window_minmax.hpp"
+
+#include <QString>
+#include <QtGlobal>
+#include <QtTypes>
+
+
+typedef enum {
+	CHART_AUTOSCALE_FIXED,		// configured range, never moves
+	CHART_AUTOSCALE_WINDOWED,	// min and max of the samples in the chart window
+	CHART_AUTOSCALE_PERCENTILE, // low and high percentile of the window, single spikes are clipped
+	NUM_OF_CHART_AUTOSCALE,
+} ChartAutoscale;
+
+// "fixed", "windowed" or "percentile", anything else falls back to fallback
+ChartAutoscale chartAutoscaleFromString(const QString& name, ChartAutoscale fallback = CHART_AUTOSCALE_WINDOWED);
+
+// y axis range of one chart, fed with every value appended to the chart window
+class ChartAutoscaler {
+public:
+	ChartAutoscaler(int window = 1);
+	~ChartAutoscaler();
+	Q_DISABLE_COPY(ChartAutoscaler)
+
+	void setWindow(int window); // samples, same as the chart window
+	void setPolicy(ChartAutoscale policy);
+	ChartAutoscale policy() const;
+	void setFixedRange(qreal lo, qreal hi);
+	void setPercentile(qreal percent); // 1 uses the 1st and 99th percentile
+
+	void push(qreal value);
+	void clear();
+
+	bool range(qreal& lo, qreal& hi) const; // false if there is no data yet
+
+private:
+	ChartAutoscale m_policy = CHART_AUTOSCALE_WINDOWED;
+	qreal fixed_lo = -SENSOR_VALUE_SCALE, fixed_hi = SENSOR_VALUE_SCALE;
+	qreal percent = 1;
+	int window;
+	WindowMinMax minmax;				   // sized only for CHART_AUTOSCALE_WINDOWED
+	WindowHistogram* histogram = nullptr; // 256 KB of bins, allocated only for CHART_AUTOSCALE_PERCENTILE
+
+	void allocate();
+};
+
+#endif // _CHART_AUTOSCALE_HPP
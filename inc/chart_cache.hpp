@@ -0,0 +1,59 @@
+#ifndef _CHART_CACHE_HPP
+#define _CHART_CACHE_HPP
+
+#include "chart_autoscale.hpp"
+#include "chart_decimation.hpp"
+#include "chart_series_buffer.hpp"
+#include "settings_io.hpp"
+
+#include <QtGlobal>
+#include <QtTypes>
+
+
+#define CHART_DEFAULT_WINDOW_SIZE 3000
+
+typedef struct {
+	int capacity; // samples per sensor
+	int display_target;
+	ChartDecimation decimation[3];
+	ChartAutoscale autoscale[3];
+	qreal fixed_lo, fixed_hi;
+	qreal percentile;
+} ChartCacheConfig;
+
+/*
+chart options in settings, every per chart option is either one value or an array for the X/Y/Z charts:
+	"chart_window_size": 3000,
+	"chart_decimation": "minmax" | "lttb" | "none",
+	"chart_autoscale": "windowed" | "percentile" | "fixed",
+	"chart_fixed_range": [-600, 600],
+	"chart_percentile": 1
+*/
+ChartCacheConfig loadChartCacheConfig(Settings* settings);
+
+// display ready X/Y/Z chart state of one sensor, kept up to date for every sensor so selecting one is a pointer swap
+class ChartSensorCache {
+public:
+	ChartSensorCache(const ChartCacheConfig& config);
+	~ChartSensorCache();
+	Q_DISABLE_COPY(ChartSensorCache)
+
+	bool append(qreal time_sec, qreal X, qreal Y, qreal Z); // false if time_sec is not after the last sample
+	void clear();
+
+	void setDisplayTarget(int target);
+	void resyncDisplay();
+
+	ChartSeriesBuffer& series(int axis);
+	const ChartAutoscaler& range(int axis) const;
+	bool isEmpty() const;
+	qreal firstTime() const;
+	qreal lastTime() const;
+
+private:
+	ChartSeriesBuffer data[3];
+	ChartAutoscaler ranges[3];
+	ChartDecimation decimation[3];
+};
+
+#endif // _CHART_CACHE_HPP
@@ -0,0 +1,26 @@
+#ifndef _CHART_DECIMATION_HPP
+#define _CHART_DECIMATION_HPP
+
+#include <QList>
+#include <QPointF>
+#include <QString>
+
+
+typedef enum {
+	CHART_DECIMATION_NONE,
+	CHART_DECIMATION_MINMAX, // min and max of each pixel column, keeps every spike
+	CHART_DECIMATION_LTTB,	 // largest triangle three buckets, keeps the visual shape with fewer points
+	NUM_OF_CHART_DECIMATION,
+} ChartDecimation;
+
+#define CHART_DECIMATION_POINTS_PER_PIXEL 2
+
+// "none", "minmax" or "lttb", anything else falls back to fallback
+ChartDecimation chartDecimationFromString(const QString& name, ChartDecimation fallback = CHART_DECIMATION_MINMAX);
+
+// points must be sorted by x, out is cleared first and keeps its capacity, so reusing it does not allocate
+void decimateMinMax(const QPointF* points, int n, int target, QList<QPointF>& out);
+void decimateLttb(const QPointF* points, int n, int target, QList<QPointF>& out);
+void decimate(ChartDecimation mode, const QList<QPointF>& points, int target, QList<QPointF>& out);
+
+#endif // _CHART_DECIMATION_HPP
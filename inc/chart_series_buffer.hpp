@@ -0,0 +1,84 @@
+#ifndef _CHART_SERIES_BUFFER_HPP
+#define _CHART_SERIES_BUFFER_HPP
+
+#include "chart_decimation.hpp"
+
+#include <QList>
+#include <QPointF>
+#include <QVector>
+#include <QtTypes>
+
+
+/*
+Fixed capacity window of chart points plus the decimated points that are actually shown.
+
+Both live in ring buffers, so appending a point never shifts the window. The shown points are decimated on a fixed x
+grid while they stream in: a bucket is turned into display points once a point of the next bucket arrives, and display
+points fall off the front together with the window. The renderer therefore only needs the points removed from the
+front and the points appended to the back since its last sync, see takeDisplayChanges(). The x axis range follows
+first() and last(), which is the only view transform needed for the ring.
+*/
+
+class ChartSeriesBuffer {
+public:
+	ChartSeriesBuffer(int capacity = 1);
+	~ChartSeriesBuffer();
+
+	void setCapacity(int capacity);						  // drops all points
+	void setDecimation(ChartDecimation mode, int target); // target number of shown points, rebuilt only on change
+
+	bool append(qreal x, qreal y); // x must not decrease, otherwise the window starts over and false is returned
+	void clear();
+
+	int size() const;
+	bool isEmpty() const;
+	const QPointF& at(int index) const; // 0 is the oldest point
+	const QPointF& first() const;
+	const QPointF& last() const;
+
+	int displaySize() const;
+	// points to drop from the front of the renderer and points to append since the last call, returns false if the
+	// renderer has to replace everything with appended instead
+	bool takeDisplayChanges(int& removed, QList<QPointF>& appended);
+	void resyncDisplay(); // the next takeDisplayChanges returns everything, e.g. after the renderer showed another buffer
+
+private:
+	// values are copied, a bucket can outlive its oldest raw points when it gets more points than the window holds
+	typedef struct {
+		qint64 index;				// floor((x - bucket_origin) / bucket_width)
+		qint64 first_seq, end_seq;	// raw points of the bucket
+		QPointF first, min, max;	// for lttb and min/max
+		qint64 min_seq, max_seq;	// order of min and max
+		qreal sum_x, sum_y;			// for the average used by lttb
+	} Bucket;
+
+	QVector<QPointF> points;
+	int head = 0, count = 0;
+	qint64 next_seq = 0; // sequence number of the next appended point, the oldest one is next_seq - count
+
+	QVector<QPointF> display;
+	int display_head = 0, display_count = 0;
+	int display_synced = 0;	 // points at the front of display that the renderer already has
+	int display_removed = 0; // synced points dropped since the last takeDisplayChanges
+	bool display_reset = true;
+
+	ChartDecimation mode = CHART_DECIMATION_NONE;
+	int target = 0;
+	bool bucketed = false;
+	qreal bucket_origin = 0, bucket_width = 0;
+	Bucket open, prev;
+	bool has_open = false, has_prev = false;
+	QPointF last_selected; // previous lttb point
+	bool has_selected = false;
+
+	const QPointF& pointAt(qint64 seq) const;
+	const QPointF& displayAt(int index) const;
+	void pushDisplay(const QPointF& point);
+	void popDisplay();
+	void feedBucket(qint64 seq);
+	void closeBucket();
+	bool canBucket() const;
+	void rebuildDisplay();
+};
+
+#endif // _CHART_SERIES_BUFFER_HPP
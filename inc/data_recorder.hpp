@@ -2,16 +2,12 @@
 #define _DATA_RECORDER_HPP
 
 #include "macro_utils.h"
+#include "pretrigger_ring.hpp"
+#include "recording_file.hpp"
 
-#include <QJsonArray>
-#include <QJsonDocument>
-#include <QJsonObject>
-#include <QJsonParseError>
-#include <QJsonValue>
 #include <QThread>
 #include <Qtmqtt/QMqttClient>
 #include <qdatetime.h>
-#include <qjsonarray.h>
 
 
 #define RECORDER_STATE_TABLE(X) \
@@ -41,25 +37,6 @@ private:
 	bool reply_running = true;
 };
 
-class JsonArrIterator {
-public:
-	JsonArrIterator(QString key_, QJsonArray arr_);
-	~JsonArrIterator();
-
-	bool hasNext();
-	QJsonValue peekNext();
-	void rmNext();
-	QJsonValue next();
-
-	QString getKey();
-
-private:
-	QString key;
-	QJsonArray arr;
-	int index;
-};
-
-
 class DataRecorder : public QObject {
 	Q_OBJECT
 public:
@@ -71,6 +48,8 @@ public:
 	bool startRecording();
 	bool stopRecording();
 
+	void setPretrigger(qint64 window_ms, int max_sample_rate);
+
 	void dataRecord(QString key, qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z);
 
 	bool startReplaying(QString path);
@@ -87,13 +66,19 @@ private slots:
 	void deleteReplayThread();
 
 private:
+	void clearReplay();
+	void startReplayThread(qint64 data_start_time);
+
 	RecorderState state = RecorderStateIdle;
-	QJsonObject* obj = nullptr;
+	RecordingWriter writer;
+	RecordingReader reader;
+	PretriggerRing pretrigger; // filled while idle, spilled into the file when recording starts
 	DataReplayThread* replay_thread = nullptr;
 
 	// for replay control
 	QDateTime replay_start_time, replay_data_start_time;
-	QList<JsonArrIterator*> replay_its;
+	QList<RecordingColumns*> replay_columns; // legacy json recordings are decoded into columns
+	QList<RecordingCursor*> replay_cursors;
 	bool replay_started_do_once = false, replay_finished_do_once = false;
 };
 
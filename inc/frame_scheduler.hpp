@@ -0,0 +1,83 @@
+#ifndef _FRAME_SCHEDULER_HPP
+#define _FRAME_SCHEDULER_HPP
+
+#include <QElapsedTimer>
+#include <QObject>
+#include <QPointer>
+#include <QTimer>
+#include <QWidget>
+#include <QWindow>
+
+
+#define FRAME_DEFAULT_FPS			60
+#define FRAME_STATS_INTERVAL_MS		5000
+#define FRAME_FALLBACK_REFRESH_RATE 60
+
+typedef enum {
+	FRAME_VIEW_CHART,
+	FRAME_VIEW_GRAPHICS,
+	FRAME_VIEW_TRACE,
+	NUM_OF_FRAME_VIEWS
+} FrameView;
+
+typedef struct {
+	int frames;		   // frames run in the interval
+	int missed;		   // refresh intervals a dirty view waited past its frame
+	qreal fps;		   // frames per second over the interval
+	qreal avg_frame_ms; // time spent in sig_frame
+	qreal max_frame_ms;
+} FrameStats;
+
+/*
+One frame clock for every view of the main window.
+
+Views mark themselves dirty, the next frame is then requested from the window with QWindow::requestUpdate(), which
+follows the display refresh on platforms that support it and runs right before the window repaints, so all views
+update in the same frame. Nothing is scheduled while no view is dirty, and frames are spaced by at least
+1 / min(target fps, screen refresh rate).
+*/
+class FrameScheduler : public QObject {
+	Q_OBJECT
+public:
+	FrameScheduler(QWidget* widget, QObject* parent = nullptr);
+	~FrameScheduler();
+
+	void setTargetFps(int fps);
+	int targetFps() const;
+
+	void markDirty(FrameView view);
+
+Q_SIGNALS:
+	void sig_frame(int dirty_views); // bit (1 << FrameView) of every view to update, emitted on the GUI thread
+	void sig_stats(const FrameStats& stats);
+
+protected:
+	bool eventFilter(QObject* object, QEvent* event) override;
+
+private slots:
+	void requestFrame();
+
+private:
+	QWidget* widget;
+	QPointer<QWindow> window; // resolved once the widget is shown
+	QTimer* pace_timer;		  // waits out the rest of the frame interval before requesting the next frame
+	QElapsedTimer clock;
+
+	int target_fps = FRAME_DEFAULT_FPS;
+	int dirty_views = 0;
+	bool frame_requested = false;
+	qint64 last_frame_ns = 0;
+	qint64 dirty_since_ns = 0; // first markDirty after the last frame
+
+	// stats of the current interval
+	qint64 stats_start_ns = 0;
+	int stats_frames = 0, stats_missed = 0;
+	qint64 stats_total_ns = 0, stats_max_ns = 0;
+
+	qint64 frameIntervalNs() const;
+	void attachWindow();
+	void scheduleFrame();
+	void runFrame();
+};
+
+#endif // _FRAME_SCHEDULER_HPP
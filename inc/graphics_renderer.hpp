@@ -0,0 +1,154 @@
+#ifndef _GRAPHICS_RENDERER_HPP
+#define _GRAPHICS_RENDERER_HPP
+
+#include "center_of_pressure.hpp"
+#include "heatmap_colormap.hpp"
+#include "heatmap_grid.hpp"
+#include "settings_io.hpp"
+
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QLineF>
+#include <QRect>
+#include <QString>
+#include <QStringList>
+#include <tuple>
+#include <vector>
+
+
+#define GRAPHICS_CELL_SIZE		  5	 // pixels per heatmap cell
+#define GRAPHICS_RADIATION_DECAY  50
+#define GRAPHICS_ARROW_LENGTH	  50 // pixels of a full scale X/Y reading
+
+typedef struct {
+	int blur_radius; // cells, 0 to disable
+	HeatmapColormap colormap;
+	HeatmapTemporal temporal;
+	qreal tau_ms, hold_ms;
+	HeatmapFieldMethod field;
+	qreal field_radius, field_power;
+	int cop_trail_length; // frames, 0 hides the center of pressure
+} GraphicsRendererConfig;
+
+/*
+heatmap options in settings, settings may be null for the defaults:
+	"heatmap_blur_radius": 2,
+	"heatmap_colormap": "yellow_red" | "viridis" | "inferno" | "turbo",
+	"heatmap_temporal": "none" | "smooth" | "decay" | "peak_hold", "heatmap_tau_ms": 300, "heatmap_hold_ms": 500,
+	"heatmap_field": "idw" | "rbf" | "off", "heatmap_field_radius": 30, "heatmap_field_power": 2,
+	"cop_trail_length": 200
+*/
+GraphicsRendererConfig loadGraphicsRendererConfig(Settings* settings);
+
+// arrow head triangle at the tip of line, and its color on the white to black gradient along the line
+void graphicsArrowHead(const QLineF& line, QPointF head[3], QColor& color);
+
+// averaged sensor values of one frame, X/Y/Z divided by SENSOR_VALUE_SCALE
+typedef struct {
+	QString name;
+	qreal x, y, z;
+} GraphicsSample;
+
+// everything drawn on top of the insole, produced by GraphicsRenderer and only read by the GUI
+typedef struct {
+	QImage heatmap; // one pixel per cell
+	QRect dirty;	// cells changed since the last frame taken by the GUI
+
+	std::vector<QLineF> arrows; // sensor to tip, one per sensor
+	std::vector<QPointF> cop[NUM_OF_COP_FOOT];
+	bool cop_valid[NUM_OF_COP_FOOT];
+} GraphicsFrame;
+
+// heatmap cells with their colors, no GUI dependency besides QImage
+class HeatmapManager {
+public:
+	HeatmapManager(int width, int height, int cellSize, int radiation_decay = 0);
+	~HeatmapManager();
+	void setCellScalar(int xPos, int yPos, const int scalar);
+	void setCellScalarBatch(const std::vector<std::tuple<int, int, int>>& cells, qint64 dt_ms = 0);
+	void clear();
+	void setBlurRadius(int radius);
+	void setColormap(HeatmapColormap colormap);
+	void buildField(HeatmapFieldMethod method, const std::vector<HeatmapFieldSensor>& sensors, qreal radius,
+					qreal power);
+	void setFieldValues(const std::vector<int>& values, qint64 dt_ms = 0);
+	void setTemporal(HeatmapTemporal mode, qreal tau_ms, qreal hold_ms);
+	bool isSettling() const;
+	int cellSize() const;
+	int width() const;
+	int height() const;
+
+	const QImage& image() const;
+	QRect takeDirtyImage(); // cells of image() rewritten since the last call
+
+private:
+	HeatmapGrid m_grid;
+	QImage m_image; // one pixel per cell, blitted scaled by cellSize
+	QRect m_dirty;
+	HeatmapColormap m_colormap = HEATMAP_COLORMAP_YELLOW_RED;
+
+	// rewrites the changed cells, or all of them with force
+	void syncImage(const QRect& cells, bool force = false);
+};
+
+/*
+Heatmap, arrows and center of pressure of all sensors. Owned by a single thread, the GUI only ever sees the copies
+written by snapshot(), so the math runs the same in the app and headless.
+*/
+class GraphicsRenderer {
+public:
+	GraphicsRenderer(int width, int height, int cellSize = GRAPHICS_CELL_SIZE,
+					 int radiation_decay = GRAPHICS_RADIATION_DECAY);
+	~GraphicsRenderer();
+
+	// positions in insole coordinates, x of the right foot is mirrored into the right half of the scene
+	void addSensor(const QString& name, int x, int y, int x_to, int y_to, bool is_left);
+	void removeSensor(const QString& name);
+	void setSensorPos(const QString& name, int x, int y, bool is_left, bool need_flip_arrow);
+	void setArrowPointingTo(const QString& name, int x, int y);
+	void setArrowRot90(const QString& name, int num_of_90);
+	void clear(); // sensors, heatmap and trajectories
+
+	void setConfig(const GraphicsRendererConfig& config);
+	void setHeatmapBlurRadius(int radius);
+	void setHeatmapColormap(HeatmapColormap colormap);
+	void setHeatmapTemporal(HeatmapTemporal mode, qreal tau_ms, qreal hold_ms);
+	void setHeatmapField(HeatmapFieldMethod method, qreal radius, qreal power);
+	void setCopTrailLength(int frames);
+
+	// one frame of sensor values, dt_ms since the previous one drives the temporal accumulation
+	void process(const std::vector<GraphicsSample>& samples, qint64 dt_ms);
+	// copies the current state into frame, reusing its buffers
+	void snapshot(GraphicsFrame& frame);
+	bool isSettling() const;
+
+	int width() const;
+	int height() const;
+
+private:
+	typedef struct {
+		QLineF arrow;
+		int scalar;
+		int x, y; // scene coordinates
+		bool is_left;
+	} Sensor;
+
+	HeatmapManager m_heatmap;
+	QHash<QString, Sensor> m_sensors;
+	HeatmapTemporal m_heatmap_temporal = HEATMAP_TEMPORAL_NONE;
+	HeatmapFieldMethod m_field_method = HEATMAP_FIELD_OFF;
+	qreal m_field_radius = HEATMAP_FIELD_DEFAULT_RADIUS;
+	qreal m_field_power = HEATMAP_FIELD_DEFAULT_POWER;
+	bool m_field_stale = true; // sensors moved, added or removed since the weights were built
+	QStringList m_field_keys;  // sensor index of the field weights
+	std::vector<std::tuple<int, int, int>> m_batch_cells; // reused by every frame
+	std::vector<int> m_field_values;
+	CenterOfPressure m_cop;
+	int m_cop_trail_length = COP_DEFAULT_TRAIL_LENGTH;
+
+	void rebuildField();
+	int sceneX(int x, bool is_left) const;
+};
+
+#endif // _GRAPHICS_RENDERER_HPP
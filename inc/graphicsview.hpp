@@ -1,65 +1,63 @@
 #ifndef _GRAPHICSVIEW_HPP
 #define _GRAPHICSVIEW_HPP
 
+#include "graphics_renderer.hpp"
+
+#include <QElapsedTimer>
 #include <QGraphicsItem>
-#include <QGraphicsLineItem>
 #include <QGraphicsView>
+#include <QImage>
 #include <QMap>
+#include <QMutex>
+#include <QPen>
 #include <QOpenGLWidget>
 #include <QPixmap>
 #include <QThread>
 #include <qobject.h>
 #include <qtmetamacros.h>
+#include <atomic>
+#include <functional>
 #include <tuple>
 
-class ArrowItem : public QObject {
-	Q_OBJECT
+// arrows of all sensors in flat arrays, recomputed in one batch per frame and painted in one call
+class SensorOverlayItem : public QGraphicsItem {
 public:
-	ArrowItem(QLineF line);
-	~ArrowItem();
-	void updateColor(QColor startColor, QColor endColor);
-	void updateArrowHead();
-
-	QGraphicsPolygonItem* arrowHead() const { return m_arrowHead; }
-	QGraphicsLineItem* lineItem() const { return m_lineItem; }
-	QLineF line() const { return m_lineItem->line(); }
-
-public slots:
-	void setLine(const QLineF line);
+	SensorOverlayItem();
+	~SensorOverlayItem();
+	QRectF boundingRect() const override;
+	void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
+	void setArrows(const std::vector<QLineF>& arrows); // repaints only if an arrow moved
 
 private:
-	QColor m_startColor;
-	QColor m_endColor;
-	QGraphicsPolygonItem* m_arrowHead;
-	QGraphicsLineItem* m_lineItem;
+	std::vector<QLineF> m_lines;
+	std::vector<QPointF> m_heads;		// 3 points per arrow
+	std::vector<QColor> m_head_colors; // of the white to black gradient along the line, taken at the head
+	QRectF m_bounds;
+	QPen m_pen;
 };
 
-typedef enum {
-	HEATMAP_FRAME_NEXT,
-	HEATMAP_FRAME_CURRENT,
-	NUM_OF_HEATMAP_FRAME,
-} HeatmapFrame_t;
-
-class HeatmapManager : public QGraphicsItem {
+// heatmap and center of pressure of the frame last taken from the render thread
+class HeatmapFrameItem : public QGraphicsItem {
 public:
-	HeatmapManager(int width, int height, int cellSize, int radiation_decay = 0);
-	~HeatmapManager();
+	HeatmapFrameItem(int width, int height, int cellSize);
+	~HeatmapFrameItem();
 	QRectF boundingRect() const override;
-	QColor cvtColor(const int scalar) const;
 	void paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) override;
-	void setCellScalar(int xPos, int yPos, const int scalar);
-	void setCellScalarBatch(const std::vector<std::tuple<int, int, int>>& cells);
-	void clear();
-	int cellSize() const;
+	void setFrame(const GraphicsFrame* frame); // repaints the changed cells and the trails
 
 private:
-	int m_width;
-	int m_height;
+	const GraphicsFrame* m_frame = nullptr;
+	QRectF m_bounds;
 	int m_cellSize;
-	int m_radiation_decay;
-	int** m_cellScalars[NUM_OF_HEATMAP_FRAME];
+	QRectF m_trail_rect; // area of the trails of m_frame
+	QPen m_pens[NUM_OF_COP_FOOT];
 };
 
+/*
+Scene of the insole. The heatmap, arrow and center of pressure state lives in a GraphicsRenderer on a render thread,
+every call here is posted to it. A rendered frame is handed back through three buffers: the render thread fills one,
+the GUI paints another and the third holds the latest complete frame, so the GUI only swaps an index and blits.
+*/
 class GraphicsManager : public QObject {
 	Q_OBJECT
 public:
@@ -71,30 +69,51 @@ public:
 	void setSpherePos(QString name, int x, int y, bool is_left, bool need_flip_arrow);
 	void setArrowPointingTo(QString name, int x, int y);
 	void setArrowRot90(QString name, int num_of_90);
+	void setRendererConfig(const GraphicsRendererConfig& config);
+	bool isHeatmapSettling() const; // heatmap or pressure dot still change without data, keep scheduling frames
+
+	// one frame of sensor values, queues at most one render until the render thread picks them up
+	void submitSamples(const std::vector<GraphicsSample>& samples);
 
 	int width() const;
 	int height() const;
 
 	void clear();
 
-public Q_SLOTS:
-	void setArrowPointingToScalar(QString name, qreal sca_x, qreal sca_y);
-	void setDefaultSphereColorScalar(QString name, qreal scalar);
-	void setDefaultSphereColorScalarBatch(const std::vector<std::tuple<QString, qreal>>& data);
-	void updateHeatmap(void);
+private Q_SLOTS:
+	void presentFrame();
 
 private:
 	QGraphicsView* m_view;
 	QGraphicsScene* m_scene;
 	QPixmap m_bgPixmap;
-	QHash<QString, std::tuple<ArrowItem*, int, int, int, bool>> m_objects;
-	HeatmapManager* m_heatmap;
+	HeatmapFrameItem* m_frame_item;
+	SensorOverlayItem* m_overlay_item;
 	int m_width;
 	int m_height;
+
+	// only touched on the render thread once it runs
 	QThread* m_thread;
+	QObject* m_render_context; // lives on m_thread, receives the posted work
+	GraphicsRenderer* m_renderer;
+	QElapsedTimer m_frame_timer; // time between frames for the temporal accumulation
+	std::atomic<bool> m_settling{false};
+
+	QMutex m_input_mutex;
+	std::vector<GraphicsSample> m_pending; // submitted since the last render, guarded by m_input_mutex
+	std::vector<GraphicsSample> m_samples; // being rendered
+	bool m_render_posted = false;
+
+	QMutex m_frame_mutex; // guards the buffer indices
+	GraphicsFrame m_frames[3];
+	int m_back = 0, m_ready = 1, m_front = 2;
+	bool m_has_ready = false;
+	std::atomic<bool> m_present_posted{false};
 
 	void createBackground();
-	void wrap_x(int& x, bool is_left);
+	void post(std::function<void()> work); // runs work on the render thread and publishes the result
+	void renderPending();
+	void publishFrame();
 };
 
 #endif // _GRAPHICSVIEW_HPP
\ No newline at end of file
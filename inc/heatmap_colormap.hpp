@@ -0,0 +1,107 @@
+#ifndef _HEATMAP_COLORMAP_HPP
+#define _HEATMAP_COLORMAP_HPP
+
+#include "heatmap_grid.hpp"
+
+#include <QString>
+#include <array>
+#include <stdint.h>
+
+
+typedef enum {
+	HEATMAP_COLORMAP_YELLOW_RED, // the original ramp, 204 steps yellow fade then 255 steps red fade
+	HEATMAP_COLORMAP_VIRIDIS,
+	HEATMAP_COLORMAP_INFERNO,
+	HEATMAP_COLORMAP_TURBO,
+	NUM_OF_HEATMAP_COLORMAP,
+} HeatmapColormap;
+
+#define HEATMAP_COLORMAP_SIZE		 512
+#define HEATMAP_COLORMAP_ALPHA		 128 // the heatmap is drawn at half opacity over the insole
+#define HEATMAP_COLORMAP_INDEX_SHIFT 16
+#define HEATMAP_COLORMAP_INDEX_SCALE (((HEATMAP_COLORMAP_SIZE - 1) << HEATMAP_COLORMAP_INDEX_SHIFT) / HEATMAP_SCALAR_MAX)
+
+// "yellow_red", "viridis", "inferno" or "turbo", anything else falls back to fallback
+HeatmapColormap heatmapColormapFromString(const QString& name,
+										  HeatmapColormap fallback = HEATMAP_COLORMAP_YELLOW_RED);
+
+// premultiplied ARGB of scalars clamped to [0, HEATMAP_SCALAR_MAX], a branch free gather the compiler can vectorize
+void heatmapColormapApply(const uint32_t* table, const int* scalars, uint32_t* out, int n);
+
+/* compile time tables */
+static constexpr double heatmapColormapClamp(double v) { return v < 0 ? 0 : (v > 1 ? 1 : v); }
+
+static constexpr uint32_t heatmapColormapArgb(double r, double g, double b) {
+	// premultiplied by HEATMAP_COLORMAP_ALPHA, the layout of QImage::Format_ARGB32_Premultiplied
+	const uint32_t a = HEATMAP_COLORMAP_ALPHA;
+	const uint32_t r8 = (uint32_t)(heatmapColormapClamp(r) * a + 0.5);
+	const uint32_t g8 = (uint32_t)(heatmapColormapClamp(g) * a + 0.5);
+	const uint32_t b8 = (uint32_t)(heatmapColormapClamp(b) * a + 0.5);
+	return a << 24 | r8 << 16 | g8 << 8 | b8;
+}
+
+// degree 6 polynomial fits of the matplotlib maps, coefficients from constant to t^6
+static constexpr double heatmapColormapPoly(const double (&c)[7], double t) {
+	return c[0] + t * (c[1] + t * (c[2] + t * (c[3] + t * (c[4] + t * (c[5] + t * c[6])))));
+}
+
+static constexpr uint32_t heatmapColormapColor(HeatmapColormap map, double t) {
+	constexpr double viridis[3][7] = {
+		{0.2777273272234177, 0.1050930431085774, -0.3308618287255563, -4.634230498983486, 6.228269936347081,
+		 4.776384997670288, -5.435455855934631},
+		{0.005407344544966578, 1.404613529898575, 0.214847559468213, -5.799100973351585, 14.17993336680509,
+		 -13.74514537774601, 4.645852612178535},
+		{0.3340998053353061, 1.384590162594685, 0.09509516302823659, -19.33244095627987, 56.69055260068105,
+		 -65.35303263337234, 26.3124352495832},
+	};
+	constexpr double inferno[3][7] = {
+		{0.0002189403691192265, 0.1065134194856116, 11.60249308247187, -41.70399613139459, 77.162935699427,
+		 -71.31942824499214, 25.13112622477341},
+		{0.001651004631001012, 0.5639564367884091, -3.972853965665698, 17.43639888205313, -33.40235894210092,
+		 32.62606426397723, -12.24266895238567},
+		{-0.01948089843709184, 3.932712388889277, -15.9423941062914, 44.35414519872813, -81.80730925738993,
+		 73.20951985803202, -23.07032500287172},
+	};
+	// turbo is a degree 5 fit
+	constexpr double turbo[3][7] = {
+		{0.13572138, 4.61539260, -42.66032258, 132.13108234, -152.94239396, 59.28637943, 0},
+		{0.09140261, 2.19418839, 4.84296658, -14.18503333, 4.27729857, 2.82956604, 0},
+		{0.10667330, 12.64194608, -60.58204836, 110.36276771, -89.90310912, 27.34824973, 0},
+	};
+
+	switch (map) {
+		case HEATMAP_COLORMAP_VIRIDIS:
+			return heatmapColormapArgb(heatmapColormapPoly(viridis[0], t), heatmapColormapPoly(viridis[1], t),
+									   heatmapColormapPoly(viridis[2], t));
+		case HEATMAP_COLORMAP_INFERNO:
+			return heatmapColormapArgb(heatmapColormapPoly(inferno[0], t), heatmapColormapPoly(inferno[1], t),
+									   heatmapColormapPoly(inferno[2], t));
+		case HEATMAP_COLORMAP_TURBO:
+			return heatmapColormapArgb(heatmapColormapPoly(turbo[0], t), heatmapColormapPoly(turbo[1], t),
+									   heatmapColormapPoly(turbo[2], t));
+		default: {
+			const int scalar = (int)(t * HEATMAP_SCALAR_MAX + 0.5);
+			if (scalar <= 204) {
+				return heatmapColormapArgb(1, 1, (204 - scalar) / 255.0);
+			}
+			return heatmapColormapArgb(1, (scalar - 204 > 255 ? 0 : 255 - (scalar - 204)) / 255.0, 0);
+		}
+	}
+}
+
+static constexpr std::array<uint32_t, HEATMAP_COLORMAP_SIZE> heatmapColormapTable(HeatmapColormap map) {
+	std::array<uint32_t, HEATMAP_COLORMAP_SIZE> table = {};
+	for (int i = 0; i < HEATMAP_COLORMAP_SIZE; i++) {
+		table[i] = heatmapColormapColor(map, (double)i / (HEATMAP_COLORMAP_SIZE - 1));
+	}
+	return table;
+}
+
+inline constexpr std::array<uint32_t, HEATMAP_COLORMAP_SIZE> HEATMAP_COLORMAP_TABLES[NUM_OF_HEATMAP_COLORMAP] = {
+	heatmapColormapTable(HEATMAP_COLORMAP_YELLOW_RED),
+	heatmapColormapTable(HEATMAP_COLORMAP_VIRIDIS),
+	heatmapColormapTable(HEATMAP_COLORMAP_INFERNO),
+	heatmapColormapTable(HEATMAP_COLORMAP_TURBO),
+};
+
+#endif // _HEATMAP_COLORMAP_HPP
@@ -0,0 +1,67 @@
+#ifndef _HEATMAP_FIELD_HPP
+#define _HEATMAP_FIELD_HPP
+
+#include <QRect>
+#include <QString>
+#include <QThreadPool>
+#include <QtGlobal>
+#include <vector>
+
+
+typedef enum {
+	HEATMAP_FIELD_OFF,	// a blob around every sensor, see HeatmapGrid::setCellScalar
+	HEATMAP_FIELD_IDW,	// inverse distance weighting, local modified Shepard weights
+	HEATMAP_FIELD_RBF,	// radial basis function interpolation with a compactly supported Wendland kernel
+	NUM_OF_HEATMAP_FIELD,
+} HeatmapFieldMethod;
+
+#define HEATMAP_FIELD_DEFAULT_RADIUS 30			 // cells
+#define HEATMAP_FIELD_DEFAULT_POWER	 2
+#define HEATMAP_FIELD_PARALLEL_MIN	 (1 << 15) // weights below which evaluate() stays on the calling thread
+
+typedef struct {
+	int column, row; // cell of the sensor
+	int group;		 // 0 left foot, 1 right foot, a sensor only reaches the cells of its own half
+} HeatmapFieldSensor;
+
+// "off", "idw" or "rbf", anything else falls back to fallback
+HeatmapFieldMethod heatmapFieldFromString(const QString& name, HeatmapFieldMethod fallback = HEATMAP_FIELD_OFF);
+
+/*
+Pressure surface interpolated between the sensors as a sparse matrix times the vector of sensor values.
+
+build() runs whenever the sensor positions change and stores the weight of every sensor for every cell in CSR form,
+so evaluate() costs the same for every method: one multiply-add per stored weight, split into row tiles on a
+thread pool. Cells beyond the radius of every sensor of their half stay 0, which outlines the covered part of the
+insole.
+*/
+class HeatmapField {
+public:
+	HeatmapField();
+	~HeatmapField();
+	Q_DISABLE_COPY(HeatmapField)
+
+	void build(HeatmapFieldMethod method, int columns, int rows, const std::vector<HeatmapFieldSensor>& sensors,
+			   qreal radius = HEATMAP_FIELD_DEFAULT_RADIUS, qreal power = HEATMAP_FIELD_DEFAULT_POWER);
+	void clear();
+
+	bool isEmpty() const;
+	QRect bounds() const; // cells with weights, evaluate() writes exactly these
+
+	// values by sensor index of build(), out is row-major with stride cells per row
+	void evaluate(const std::vector<int>& values, int* out, int stride);
+
+private:
+	QRect m_bounds;
+	std::vector<int> m_row_ptr; // one matrix row per cell of m_bounds, row by row like the grid
+	std::vector<int> m_sensor;
+	std::vector<float> m_weight;
+	int m_num_sensors = 0;
+	QThreadPool m_pool;
+
+	void buildIdw(const std::vector<HeatmapFieldSensor>& sensors, int split_column, qreal radius, qreal power);
+	void buildRbf(const std::vector<HeatmapFieldSensor>& sensors, int split_column, qreal radius);
+	void evaluateRows(const std::vector<int>& values, int* out, int stride, int first, int last) const;
+};
+
+#endif // _HEATMAP_FIELD_HPP
@@ -0,0 +1,95 @@
+#ifndef _HEATMAP_GRID_HPP
+#define _HEATMAP_GRID_HPP
+
+#include "heatmap_field.hpp"
+
+#include <QRect>
+#include <QString>
+#include <stdint.h>
+#include <tuple>
+#include <vector>
+
+#define HEATMAP_SCALAR_MAX	 459 // 204 steps yellow fade + 255 steps red fade, see heatmap_colormap.hpp
+#define HEATMAP_KERNEL_SHIFT 12	 // fixed point of the radiation kernels, scalar * weight stays in 32 bit
+
+#define HEATMAP_TEMPORAL_VALUE_SHIFT 8	// fixed point of the accumulated cells
+#define HEATMAP_TEMPORAL_COEF_SHIFT	 14 // fixed point of the per frame coefficients, value * coef stays in 32 bit
+#define HEATMAP_TEMPORAL_DEFAULT_TAU 300 // ms
+#define HEATMAP_TEMPORAL_DEFAULT_HOLD 500 // ms
+
+typedef enum {
+	HEATMAP_FRAME_NEXT,
+	HEATMAP_FRAME_CURRENT,
+	NUM_OF_HEATMAP_FRAME,
+} HeatmapFrame_t;
+
+typedef enum {
+	HEATMAP_TEMPORAL_NONE,		// every frame replaces the previous one
+	HEATMAP_TEMPORAL_SMOOTH,	// exponential moving average with time constant tau
+	HEATMAP_TEMPORAL_DECAY,		// rises at once, falls exponentially with tau
+	HEATMAP_TEMPORAL_PEAK_HOLD, // like decay, but a new peak is held for hold ms first
+	NUM_OF_HEATMAP_TEMPORAL,
+} HeatmapTemporal;
+
+// "none", "smooth", "decay" or "peak_hold", anything else falls back to fallback
+HeatmapTemporal heatmapTemporalFromString(const QString& name, HeatmapTemporal fallback = HEATMAP_TEMPORAL_NONE);
+
+// cell scalars of the heatmap, no GUI dependency so it can run headless
+class HeatmapGrid {
+public:
+	HeatmapGrid(int width, int height, int cellSize, int radiation_decay = 0);
+	~HeatmapGrid();
+
+	void setCellScalar(int xPos, int yPos, const int scalar);
+	void setCellScalarBatch(const std::vector<std::tuple<int, int, int>>& cells, qint64 dt_ms = 0);
+	void clear();
+
+	void setBlurRadius(int radius); // separable box blur in cells after every batch, 0 to disable
+	int blurRadius() const;
+
+	// interpolated pressure field instead of blobs, sensors in scene coordinates, group 0 left foot and 1 right foot
+	void buildField(HeatmapFieldMethod method, const std::vector<HeatmapFieldSensor>& sensors,
+					qreal radius = HEATMAP_FIELD_DEFAULT_RADIUS, qreal power = HEATMAP_FIELD_DEFAULT_POWER);
+	bool hasField() const;
+	// replaces the frame, values by sensor index of buildField
+	void setFieldValues(const std::vector<int>& values, qint64 dt_ms = 0);
+
+	// accumulation of the batches over time, dt_ms of a batch is the time since the previous one
+	void setTemporal(HeatmapTemporal mode, qreal tau_ms = HEATMAP_TEMPORAL_DEFAULT_TAU,
+					 qreal hold_ms = HEATMAP_TEMPORAL_DEFAULT_HOLD);
+	bool isSettling() const; // accumulated cells are not 0 yet, more batches change the frame even without data
+
+	int width() const;
+	int height() const;
+	int cellSize() const;
+	int columns() const;
+	int rows() const;
+	int* cells(HeatmapFrame_t frame); // row-major, cell (column, row) at row * columns() + column
+	const int* cells(HeatmapFrame_t frame) const;
+	QRect takeDirtyCells(); // cells of HEATMAP_FRAME_NEXT written or cleared since the last call
+
+private:
+	int m_width;
+	int m_height;
+	int m_cellSize;
+	int m_radiation_decay;
+	std::vector<int> m_cellScalars[NUM_OF_HEATMAP_FRAME];
+	QRect m_touched; // cells of HEATMAP_FRAME_NEXT that may be non zero
+	QRect m_dirty;
+	std::vector<std::vector<int32_t>> m_kernels; // radiation falloff by radius, (2r + 1)^2 weights, built on first use
+	int m_blur_radius = 0;
+	std::vector<int> m_blur_buffer;
+	std::vector<int64_t> m_blur_sums;
+	HeatmapField m_field;
+	HeatmapTemporal m_temporal = HEATMAP_TEMPORAL_NONE;
+	qreal m_tau_ms = HEATMAP_TEMPORAL_DEFAULT_TAU, m_hold_ms = HEATMAP_TEMPORAL_DEFAULT_HOLD;
+	std::vector<int32_t> m_accum; // row-major like the frames, value << HEATMAP_TEMPORAL_VALUE_SHIFT
+	std::vector<int32_t> m_hold;  // ms a peak is still held
+	QRect m_accum_area;			  // cells of m_accum that may be non zero
+
+	const std::vector<int32_t>& kernel(int radius);
+	void blur();
+	void applyTemporal(qint64 dt_ms);
+};
+
+#endif // _HEATMAP_GRID_HPP
@@ -0,0 +1,102 @@
+#ifndef _JSON_RECORDING_PARSER_HPP
+#define _JSON_RECORDING_PARSER_HPP
+
+#include "recording_file.hpp"
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QtTypes>
+#include <stdint.h>
+
+
+/*
+Single pass parser for legacy json recordings written by the old DataRecorder:
+
+	{"init_time": 0, {sensor_id}: [[timestamp, T, X, Y, Z], ...], ...}
+
+Only this schema is accepted. Numbers are decoded straight into 64 bit timestamps and int16 values and handed to a
+JsonRecordingHandler row by row, so no DOM is ever built.
+*/
+
+class JsonRecordingHandler {
+public:
+	virtual ~JsonRecordingHandler() {}
+
+	virtual void initTime(qint64 init_time) = 0;
+	virtual void sensorBegin(const QString& key) = 0;
+	virtual void sample(qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z) = 0;
+	virtual void sensorEnd() = 0;
+};
+
+class JsonRecordingParser {
+public:
+	JsonRecordingParser();
+	~JsonRecordingParser();
+
+	bool parse(const char* begin, const char* end, JsonRecordingHandler& handler);
+	bool parseFile(const QString& path, JsonRecordingHandler& handler);
+
+	QString errorString() const;
+	qint64 errorOffset() const;
+	qint64 sampleCount() const;
+
+private:
+	const char* begin = nullptr;
+	const char* p = nullptr;
+	const char* end = nullptr;
+	QString error;
+	qint64 error_offset = -1;
+	qint64 sample_count = 0;
+
+	bool fail(const QString& message);
+	void skipWhitespace();
+	bool expect(char c);
+	bool parseString(QString& out);
+	bool parseNumber(qint64& value);
+	bool parseSensor(JsonRecordingHandler& handler);
+};
+
+
+// collects every sensor into in-memory columns, used for replay
+class RecordingColumnsBuilder : public JsonRecordingHandler {
+public:
+	RecordingColumnsBuilder();
+	~RecordingColumnsBuilder();
+
+	void initTime(qint64 init_time) override;
+	void sensorBegin(const QString& key) override;
+	void sample(qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z) override;
+	void sensorEnd() override;
+
+	qint64 getInitTime() const;
+	QStringList keys() const;
+	QList<RecordingColumns*> takeColumns(); // caller owns the returned columns
+
+private:
+	qint64 init_time = 0;
+	QStringList sensor_keys;
+	QList<RecordingColumns*> columns;
+	RecordingColumns* current = nullptr;
+};
+
+// streams every sample into a binary recording, used for conversion
+class RecordingWriterSink : public JsonRecordingHandler {
+public:
+	RecordingWriterSink(RecordingWriter& writer_);
+	~RecordingWriterSink();
+
+	void initTime(qint64 init_time) override;
+	void sensorBegin(const QString& key) override;
+	void sample(qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z) override;
+	void sensorEnd() override;
+
+private:
+	RecordingWriter& writer;
+	int sensor = 0;
+};
+
+bool convertJsonRecording(const QString& json_path, const QString& binary_path, QString* error = nullptr,
+						  qint64* sample_count = nullptr);
+
+#endif // _JSON_RECORDING_PARSER_HPP
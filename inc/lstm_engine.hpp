@@ -0,0 +1,116 @@
+#ifndef _LSTM_ENGINE_HPP
+#define _LSTM_ENGINE_HPP
+
+#include <QString>
+#include <QtTypes>
+#include <vector>
+
+
+/*
+Weights file (*.islm) written by model/export_weights.py, little endian:
+
+	LstmWeightsHeader
+	LstmDenseHeader * num_dense
+	float32 LSTM kernel (input_size, 4 * units), recurrent kernel (units, 4 * units), bias (4 * units)
+	float32 per dense layer: kernel (inputs, outputs), bias (outputs)
+
+Matrices are row major as Keras stores them, the LSTM gates are in Keras order i, f, c, o.
+*/
+
+#define LSTM_WEIGHTS_MAGIC	 "ISLM"
+#define LSTM_WEIGHTS_VERSION 1
+#define LSTM_WEIGHTS_SUFFIX	 "islm"
+#define LSTM_MAX_DENSE		 8
+
+typedef enum {
+	LSTM_ACTIVATION_LINEAR,
+	LSTM_ACTIVATION_RELU,
+	LSTM_ACTIVATION_SOFTMAX,
+	NUM_OF_LSTM_ACTIVATION,
+} LstmActivation;
+
+typedef enum {
+	LSTM_KERNEL_SCALAR,
+	LSTM_KERNEL_AVX2, // x86 with AVX2 and FMA, checked at runtime
+	LSTM_KERNEL_NEON, // every aarch64 CPU
+	NUM_OF_LSTM_KERNEL,
+} LstmKernel;
+
+typedef struct {
+	char magic[4];
+	quint32 version;
+	quint32 input_size;
+	quint32 units;
+	quint32 num_dense;
+	quint32 reserved[3];
+} LstmWeightsHeader;
+
+typedef struct {
+	quint32 inputs;
+	quint32 outputs;
+	quint32 activation; // LstmActivation
+	quint32 reserved;
+} LstmDenseHeader;
+
+static_assert(sizeof(LstmWeightsHeader) == 32, "LstmWeightsHeader layout changed");
+static_assert(sizeof(LstmDenseHeader) == 16, "LstmDenseHeader layout changed");
+
+/*
+LSTM followed by dense layers without TensorFlow, the model of model/model.py.
+
+The input and recurrent kernels are stacked into one matrix, so a step computes all four gates in a single pass over
+[x, h], every row padded to the SIMD width. Gate activations use the exact std::exp and std::tanh, only the matrix
+products are vectorized, which keeps the results within float rounding of TensorFlow.
+
+Not thread safe, the scratch buffers are shared by all calls.
+*/
+class LstmEngine {
+public:
+	LstmEngine();
+	~LstmEngine();
+
+	bool load(const QString& path);
+	bool isLoaded() const;
+	QString errorString() const;
+
+	int inputSize() const;
+	int units() const;
+	int outputSize() const;
+
+	static LstmKernel bestKernel(); // fastest kernel this CPU runs
+	static const char* kernelName(LstmKernel kernel);
+	LstmKernel kernel() const;
+	void setKernel(LstmKernel kernel); // falls back to scalar if the CPU lacks it
+
+	// one timestep of inputSize() floats, h and c of units() floats are updated in place
+	void step(const float* frame, float* h, float* c);
+	// dense layers on the LSTM output h, probs gets outputSize() floats
+	void classify(const float* h, float* probs);
+	// timesteps frames from zero state, the same as the Keras model on the whole window
+	void run(const float* frames, int timesteps, float* probs);
+
+private:
+	typedef struct {
+		int inputs, outputs, stride;
+		LstmActivation activation;
+		std::vector<float> weights; // inputs rows of stride
+		std::vector<float> bias;	// stride
+	} Dense;
+
+	QString error;
+	LstmKernel m_kernel;
+	int input_size = 0, m_units = 0;
+	int gate_stride = 0;			  // 4 * units rounded up to the SIMD width
+	std::vector<float> lstm_weights;  // (input_size + units) rows of gate_stride, input then recurrent kernel
+	std::vector<float> lstm_bias;	  // gate_stride
+	std::vector<Dense> dense;
+	std::vector<float> xh, gates;	  // step scratch
+	std::vector<float> run_h, run_c;  // run state
+	std::vector<float> dense_out[2];  // ping pong between dense layers
+
+	// out[0, stride) = bias + sum of x[r] * weights[r * stride, +stride) over rows
+	void matvec(const float* x, int rows, const float* weights, int stride, const float* bias, float* out) const;
+	bool fail(const QString& message);
+};
+
+#endif // _LSTM_ENGINE_HPP
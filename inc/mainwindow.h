@@ -1,11 +1,16 @@
 #ifndef _MAINWINDOW_H
 #define _MAINWINDOW_H
 
+#include "chart_cache.hpp"
 #include "data_container.hpp"
 #include "data_recorder.hpp"
+#include "frame_scheduler.hpp"
 #include "graphicsview.hpp"
 #include "mqtt_app.hpp"
+#include "sensor_accumulator.hpp"
+#include "sensor_pipeline.hpp"
 #include "settings_io.hpp"
+#include "trace_view.hpp"
 #include "worker/chart_worker.hpp"
 #include "worker/classification_worker.hpp"
 #include "worker/graphics_worker.hpp"
@@ -32,17 +37,10 @@ namespace Ui {
 QT_END_NAMESPACE
 
 typedef struct {
+	ChartSensorCache* cache;
 	qreal time_sec, X, Y, Z;
 } DataPoint;
 
-typedef enum {
-	ROT_0,
-	ROT_90,
-	ROT_180,
-	ROT_270,
-	NUM_OF_ROTATION,
-} Rotation;
-
 class MainWindow : public QMainWindow {
 	Q_OBJECT
 
@@ -51,7 +49,7 @@ public:
 	~MainWindow();
 
 private:
-	const int data_series_size = 200;
+	int data_series_size = 3000; // samples kept per sensor and shown in the charts, "chart_window_size" in settings
 
 	Ui::MainWindow* ui;
 
@@ -66,20 +64,19 @@ private:
 	QChartView* chartView[3];
 	QChart* chart[3];
 	QLineSeries* series[3];
-	QList<QPointF> chart_data[3];
-	std::tuple<qreal, qreal> chart_range_y[3];
+	ChartCacheConfig chart_config;
+	QHash<QString, ChartSensorCache*> chart_caches; // every sensor, guarded by data_queue_mutex
+	ChartSensorCache* chart_cache = nullptr;		// selected sensor, shown in the charts
+	QList<QPointF> chart_appended;					// scratch for syncChartSeries
+
+	TraceView* trace_view; // all sensors at once, shown instead of the charts
+	QPushButton* trace_btn;
 
-	QTimer* chart_update_timer;
-	QThread* chart_update_thread;
 	QQueue<DataPoint> data_queue;
 	bool is_data_queue_updated;
 	QMutex data_queue_mutex;
 
-	QTimer* graphics_update_timer;
-	QThread* graphics_update_thread;
-	QHash<QString, std::tuple<qreal, qreal, qreal>> graphics_data;
-	QHash<QString, qreal> graphics_data_num;
-	QMutex graphics_mutex;
+	SensorAccumulators graphics_accumulators; // filled by processData, drained by GraphicsWorker
 
 	QTimer* classification_timer;
 	QThread* classification_update_thread;
@@ -108,6 +105,10 @@ private:
 	Settings* settings;
 
 	DataRecorder recorder;
+	QTimer* auto_record_timer; // stops a recording started by auto_record_label
+	QString auto_record_label;
+
+	FrameScheduler* frame_scheduler; // drives ChartWorker, GraphicsWorker and the trace view
 
 	const qint64 getNowNanoSec() const;
 	const qint64 getNowMicroSec() const;
@@ -131,8 +132,11 @@ private slots:
 
 	void updateChartSelect(int index);
 	void reloadChart();
+	void syncChartSeries();
+	void updateChartAxes(int i);
 
-	void addChartData(time_t timestamp, int16_t X, int16_t Y, int16_t Z);
+	ChartSensorCache* chartCache(const QString& key); // created on first use, caller holds data_queue_mutex
+	void addChartData(const QString& key, qint64 timestamp, int16_t X, int16_t Y, int16_t Z);
 
 	// void updateChartData();
 	// void updateGraphicsData();
@@ -144,11 +148,13 @@ private slots:
 	// replay related
 	void mqttStateBtnClicked();
 	void startStopBtnClicked();
+	void traceBtnClicked();
 	void replayFinished();
 
 	void updateEspStatus(const QString esp_id, bool status);
 
-	void updateClassificationResult(const QString& result);
+	void updateClassificationResults(const QStringList& sessions, const QStringList& results);
+	void updateClassificationResult(const QString& result); // auto record
 
 	void clear();
 };
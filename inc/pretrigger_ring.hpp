@@ -0,0 +1,56 @@
+#ifndef _PRETRIGGER_RING_HPP
+#define _PRETRIGGER_RING_HPP
+
+#include "recording_file.hpp"
+
+#include <QHash>
+#include <QString>
+#include <QVector>
+#include <QtTypes>
+#include <stdint.h>
+
+
+#define PRETRIGGER_DEFAULT_SEC	5
+#define PRETRIGGER_DEFAULT_RATE 200 // upper bound of samples per second per sensor, sizes the rings
+
+typedef struct {
+	qint64 timestamp;
+	int16_t T, X, Y, Z;
+} PretriggerSample;
+
+static_assert(sizeof(PretriggerSample) == 16, "PretriggerSample layout changed");
+
+// last few seconds of every sensor, kept while not recording so a recording can start before the button is pressed
+class PretriggerRing {
+public:
+	PretriggerRing();
+	~PretriggerRing();
+
+	void configure(qint64 window_ms, int capacity); // capacity in samples per sensor, 0 disables, drops all samples
+	bool isEnabled() const;
+	qint64 windowMs() const;
+
+	// O(1), only the first sample of a new sensor allocates its ring
+	void push(const QString& key, qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z);
+
+	// writes the samples of every sensor newer than window_ms before its own latest one into writer, oldest first,
+	// then empties the rings
+	qint64 spill(RecordingWriter& writer);
+	void clear();
+
+private:
+	typedef struct {
+		QString key;
+		QVector<PretriggerSample> samples;
+		int head; // next slot to write
+		int count;
+		qint64 latest_time; // per sensor, the clocks of different insoles are not aligned
+	} SensorRing;
+
+	qint64 window_ms = 0;
+	int capacity = 0;
+	QHash<QString, int> sensor_ids;
+	QVector<SensorRing> sensors;
+};
+
+#endif // _PRETRIGGER_RING_HPP
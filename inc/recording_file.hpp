@@ -0,0 +1,179 @@
+#ifndef _RECORDING_FILE_HPP
+#define _RECORDING_FILE_HPP
+
+#include <QFile>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QtTypes>
+#include <stdint.h>
+
+
+/*
+Binary recording file (*.isrec), little endian, every section 8 bytes aligned:
+
+	RecordingFileHeader
+	block: qint64 timestamp[n], int16 T[n], int16 X[n], int16 Y[n], int16 Z[n]
+	block: ...
+	sensor table: {uint16 len, utf8 key[len]} * sensor_count, padded to 8
+	RecordingBlockIndex * block_count
+	RecordingFileFooter
+
+Each block holds up to RECORDING_BLOCK_SAMPLES samples of a single sensor in timestamp order. The footer has a fixed
+size, so a reader locates the index from the end of the file without scanning any block.
+*/
+
+#define RECORDING_FILE_MAGIC	"ISRC"
+#define RECORDING_INDEX_MAGIC	"ISRI"
+#define RECORDING_FILE_VERSION	1
+#define RECORDING_FILE_SUFFIX	"isrec"
+#define RECORDING_BLOCK_SAMPLES 1024
+#define RECORDING_SAMPLE_BYTES	(sizeof(qint64) + 4 * sizeof(int16_t))
+
+typedef struct {
+	char magic[4];
+	quint32 version;
+	qint64 init_time;
+	quint32 block_samples;
+	quint32 reserved[3];
+} RecordingFileHeader;
+
+typedef struct {
+	quint32 sensor;
+	quint32 count;
+	quint64 offset;
+	qint64 first_time;
+	qint64 last_time;
+} RecordingBlockIndex;
+
+typedef struct {
+	quint64 sensor_table_offset;
+	quint64 index_offset;
+	quint32 sensor_count;
+	quint32 block_count;
+	char magic[4];
+	quint32 reserved;
+} RecordingFileFooter;
+
+static_assert(sizeof(RecordingFileHeader) == 32, "RecordingFileHeader layout changed");
+static_assert(sizeof(RecordingBlockIndex) == 32, "RecordingBlockIndex layout changed");
+static_assert(sizeof(RecordingFileFooter) == 32, "RecordingFileFooter layout changed");
+
+// column pointers of one block, pointing either into a mapped file or into RecordingColumns
+typedef struct {
+	const qint64* timestamps;
+	const int16_t *T, *X, *Y, *Z;
+	int count;
+} RecordingBlockView;
+
+// in-memory columns of one sensor, for recordings that are not memory mapped
+typedef struct {
+	QVector<qint64> timestamps;
+	QVector<int16_t> T, X, Y, Z;
+} RecordingColumns;
+
+
+class RecordingWriter {
+public:
+	RecordingWriter();
+	~RecordingWriter();
+
+	bool open(const QString& path, qint64 init_time);
+	bool close(); // flush pending blocks, write sensor table, index and footer
+	bool isOpen() const;
+
+	void setInitTime(qint64 init_time); // header is rewritten on close
+	int sensorId(const QString& key);	// registers the sensor on first use
+	void append(int sensor, qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z);
+	void append(const QString& key, qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z);
+
+	qint64 sampleCount() const;
+	QString errorString() const;
+
+private:
+	typedef struct {
+		qint64 timestamps[RECORDING_BLOCK_SAMPLES];
+		int16_t T[RECORDING_BLOCK_SAMPLES], X[RECORDING_BLOCK_SAMPLES], Y[RECORDING_BLOCK_SAMPLES],
+			Z[RECORDING_BLOCK_SAMPLES];
+		int count;
+	} PendingBlock;
+
+	QFile file;
+	QHash<QString, int> sensor_ids;
+	QStringList sensor_keys;
+	QVector<PendingBlock*> pending;
+	QVector<RecordingBlockIndex> index;
+	qint64 init_time = 0;
+	qint64 sample_count = 0;
+	bool write_failed = false;
+
+	bool writeHeader();
+	bool flushBlock(int sensor);
+	bool writePadding();
+};
+
+
+class RecordingReader {
+public:
+	RecordingReader();
+	~RecordingReader();
+
+	bool open(const QString& path);
+	void close();
+	bool isOpen() const;
+
+	qint64 initTime() const;
+	qint64 firstTimestamp() const;
+	qint64 lastTimestamp() const;
+	qint64 fileSize() const;
+
+	int sensorCount() const;
+	QString sensorKey(int sensor) const;
+	qint64 sampleCount(int sensor) const;
+	const QVector<RecordingBlockIndex>& sensorBlocks(int sensor) const;
+
+	// pointer arithmetic only, pages of the block are faulted in when the view is read
+	RecordingBlockView block(const RecordingBlockIndex& index) const;
+
+	QString errorString() const;
+
+private:
+	QFile file;
+	const uchar* data = nullptr;
+	qint64 size = 0;
+	qint64 init_time = 0;
+	qint64 first_time = 0, last_time = 0;
+	QStringList sensor_keys;
+	QVector<QVector<RecordingBlockIndex>> blocks; // [sensor][block], in timestamp order
+	QVector<qint64> sample_counts;
+	QString error;
+
+	bool fail(const QString& message);
+};
+
+
+class RecordingCursor {
+public:
+	RecordingCursor(QString key_, QVector<RecordingBlockView> blocks_);
+	~RecordingCursor();
+
+	bool hasNext() const;
+	qint64 peekTimestamp() const;
+	void next(qint64& timestamp, int16_t& T, int16_t& X, int16_t& Y, int16_t& Z);
+
+	QString getKey() const;
+
+private:
+	QString key;
+	QVector<RecordingBlockView> blocks;
+	int block_index;
+	int row;
+};
+
+// replay cursors of a binary or json recording, json is parsed into columns that must outlive the cursors
+bool loadRecordingCursors(const QString& path, RecordingReader& reader, QList<RecordingColumns*>& columns,
+						  QList<RecordingCursor*>& cursors, QString& error);
+
+#endif // _RECORDING_FILE_HPP
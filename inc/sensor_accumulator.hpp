@@ -0,0 +1,54 @@
+#ifndef _SENSOR_ACCUMULATOR_HPP
+#define _SENSOR_ACCUMULATOR_HPP
+
+#include <QHash>
+#include <QString>
+#include <QtGlobal>
+#include <atomic>
+#include <memory>
+#include <stdint.h>
+#include <vector>
+
+
+#define SENSOR_ACCUMULATOR_CAPACITY	  256 // sensors, the slots are allocated once and never move
+#define SENSOR_ACCUMULATOR_COUNT_SHIFT 40  // an axis word is count << 40 plus the sum of the readings
+#define SENSOR_ACCUMULATOR_LINE		  64  // cache line, every sensor gets its own
+
+/*
+Running X/Y/Z sums of every sensor between two frames, shared by the ingest side and the graphics worker without a lock.
+
+Each axis is one 64 bit word holding the number of readings in the top 24 bits and their sum below, so adding a
+reading is a single fetch_add and taking the sums is a single exchange that always sees matching count and sum.
+Sensors get a slot on first sight, the slot index is the sensor ID used from then on.
+
+slot() and register only run on the ingest thread, accumulate() on any thread, size(), key() and take() on the
+draining thread. A slot holds at most 2^23 readings per axis between two take() calls.
+*/
+class SensorAccumulators {
+public:
+	SensorAccumulators(int capacity = SENSOR_ACCUMULATOR_CAPACITY);
+	~SensorAccumulators();
+	Q_DISABLE_COPY(SensorAccumulators)
+
+	int slot(const QString& key); // registers unknown keys, -1 when all slots are taken
+	void accumulate(int slot, int16_t X, int16_t Y, int16_t Z);
+
+	int size() const; // registered slots
+	QString key(int slot) const;
+	// means since the previous call, false and untouched x, y, z without readings, an axis a reading has not
+	// reached yet reads 0
+	bool take(int slot, qreal& x, qreal& y, qreal& z);
+
+private:
+	struct alignas(SENSOR_ACCUMULATOR_LINE) Slot {
+		std::atomic<int64_t> axis[3];
+	};
+
+	int capacity;
+	std::unique_ptr<Slot[]> sensor_slots; // not "slots", Qt defines that as a keyword
+	std::vector<QString> keys;			  // capacity entries, a key is written before count publishes it
+	std::atomic<int> count{0};
+	QHash<QString, int> sensor_ids; // ingest thread only
+};
+
+#endif // _SENSOR_ACCUMULATOR_HPP
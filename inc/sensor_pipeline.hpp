@@ -0,0 +1,34 @@
+#ifndef _SENSOR_PIPELINE_HPP
+#define _SENSOR_PIPELINE_HPP
+
+#include "settings_io.hpp"
+
+#include <QString>
+#include <stdint.h>
+
+#define SENSOR_VALUE_SCALE 600 // raw reading that maps to full scale on the arrows and the heatmap
+
+typedef enum {
+	ROT_0,
+	ROT_90,
+	ROT_180,
+	ROT_270,
+	NUM_OF_ROTATION,
+} Rotation;
+
+typedef struct {
+	bool is_left;
+	int x, y;
+	Rotation rot;
+} SensorConfig;
+
+// placement saved by the position editor as [x, y, is_left(, rot)], defaults if not configured
+SensorConfig loadSensorConfig(Settings* settings, const QString& key);
+
+// mirror right foot sensors and apply the mounting rotation (clockwise)
+void orientSensorData(int16_t& X, int16_t& Y, bool is_left, Rotation rot);
+
+// x is given in the left half of the insole image, right foot sensors are mirrored to the right half
+int sensorSceneX(int x, bool is_left, int scene_width);
+
+#endif // _SENSOR_PIPELINE_HPP
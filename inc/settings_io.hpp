@@ -10,7 +10,8 @@
 
 class Settings {
 public:
-	Settings();
+	// read_only_ keeps the file as it is, for tools that only take their configuration from it
+	Settings(const QString& path_ = "settings.json", bool read_only_ = false);
 	~Settings();
 
 	void load();
@@ -23,6 +24,8 @@ public:
 	QJsonValueRef operator[](const QString& key);
 
 private:
+	QString path;
+	bool read_only;
 	QJsonDocument* doc;
 	QJsonObject* obj;
 };
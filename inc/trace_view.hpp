@@ -0,0 +1,59 @@
+#ifndef _TRACE_VIEW_HPP
+#define _TRACE_VIEW_HPP
+
+#include "frame_scheduler.hpp"
+#include "worker/trace_worker.hpp"
+
+#include <QImage>
+#include <QThread>
+#include <QWidget>
+#include <stdint.h>
+
+
+#define TRACE_DEFAULT_WINDOW_MS 10000
+
+// raster line strips of every sensor at once, frames are rendered into a QImage by TraceWorker on its own thread
+// and requested on the frame clock of the main window
+class TraceView : public QWidget {
+	Q_OBJECT
+public:
+	TraceView(int capacity, FrameScheduler* scheduler, QWidget* parent = nullptr);
+	~TraceView();
+
+	void append(const QString& key, qint64 timestamp, int16_t X, int16_t Y, int16_t Z);
+	void clearSensor(const QString& key);
+	void clear();
+
+	void setTraceLayout(TraceLayout layout);
+	TraceLayout traceLayout() const;
+	void setWindowMs(qint64 window_ms);
+
+	void requestFrame(); // called on FRAME_VIEW_TRACE, renders a new frame if anything changed
+
+Q_SIGNALS:
+	void sig_render(QSize size, int layout, qint64 window_ms);
+
+protected:
+	void paintEvent(QPaintEvent* event) override;
+	void resizeEvent(QResizeEvent* event) override;
+	void showEvent(QShowEvent* event) override;
+
+private slots:
+	void frameReady(const QImage& frame);
+
+private:
+	TraceStore store;
+	TraceWorker* worker;
+	QThread* render_thread;
+	FrameScheduler* scheduler;
+	QImage frame;
+
+	TraceLayout layout = TRACE_LAYOUT_SMALL_MULTIPLES;
+	qint64 window_ms = TRACE_DEFAULT_WINDOW_MS;
+	bool dirty = true;		   // new samples or settings since the last requested frame
+	bool render_busy = false; // a frame is being rendered, skip frames instead of queueing them
+
+	void markDirty();
+};
+
+#endif // _TRACE_VIEW_HPP
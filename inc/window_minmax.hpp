@@ -0,0 +1,66 @@
+#ifndef _WINDOW_MINMAX_HPP
+#define _WINDOW_MINMAX_HPP
+
+#include <QVector>
+#include <QtTypes>
+#include <stdint.h>
+
+
+// minimum and maximum of the last `window` pushed values, amortized O(1) per push with two monotonic deques
+class WindowMinMax {
+public:
+	WindowMinMax(int window = 1);
+	~WindowMinMax();
+
+	void setWindow(int window); // drops all values
+	void push(qreal value);
+	void clear();
+
+	bool isEmpty() const;
+	qreal min() const; // only valid if not empty
+	qreal max() const;
+
+private:
+	typedef struct {
+		qint64 seq;
+		qreal value;
+	} Entry;
+
+	// fixed capacity deque, a monotonic deque never holds more than `window` entries
+	typedef struct {
+		QVector<Entry> ring;
+		int head, count;
+	} Deque;
+
+	Deque min_deque, max_deque;
+	qint64 next_seq = 0;
+	int window = 1;
+
+	static void expire(Deque& deque, qint64 oldest_seq);
+	static void pushBack(Deque& deque, const Entry& entry);
+	static const Entry& front(const Deque& deque);
+	static const Entry& back(const Deque& deque);
+};
+
+
+// quantiles of the last `window` int16 values, O(1) per push and at most 512 bins scanned per query
+class WindowHistogram {
+public:
+	WindowHistogram(int window = 1);
+	~WindowHistogram();
+
+	void setWindow(int window); // drops all values
+	void push(int16_t value);
+	void clear();
+
+	int size() const;
+	int16_t quantile(qreal q) const; // q in [0, 1], only valid if size() > 0
+
+private:
+	QVector<int16_t> values; // ring of the window, to know which value leaves it
+	int head = 0, count = 0;
+	QVector<int> coarse; // 256 bins of 256 values each
+	QVector<int> fine;	 // 65536 bins
+};
+
+#endif // _WINDOW_MINMAX_HPP
@@ -1,11 +1,19 @@
 #ifndef _CLASSIFICATION_WORKER_HPP
 #define _CLASSIFICATION_WORKER_HPP
 
+#include "lstm_engine.hpp"
+
 #include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QStringView>
 #include <QVector>
 #include <QtCore/QObject>
 #include <QtCore/QThread>
+#ifdef WITH_TENSORFLOW
 #include <tensorflow/c/c_api.h>
+#endif
+#include <vector>
 
 /*
 	[
@@ -19,41 +27,143 @@
 	]
 */
 
+#define CLASSIFICATION_NUM_SENSORS	5
+#define CLASSIFICATION_NUM_FEATURES 3
+#define CLASSIFICATION_BUCKET_SLACK 5 // timesteps a session gives up to share a batch with a longer one
+
+typedef enum {
+	CLASSIFICATION_MODE_WINDOW,	   // whole window per classifyCurrentSlot, model.pb
+	CLASSIFICATION_MODE_STREAMING, // one LSTM step per aligned frame, model_step.pb from model/train.py
+	NUM_OF_CLASSIFICATION_MODE,
+} ClassificationMode;
+
+typedef enum {
+	CLASSIFICATION_BACKEND_TENSORFLOW, // SavedModel through the TF C API, only with WITH_TENSORFLOW
+	CLASSIFICATION_BACKEND_NATIVE,	   // LstmEngine on model.islm from model/export_weights.py, both modes
+	NUM_OF_CLASSIFICATION_BACKEND,
+} ClassificationBackend;
+
+#ifdef WITH_TENSORFLOW
+#define CLASSIFICATION_DEFAULT_BACKEND CLASSIFICATION_BACKEND_TENSORFLOW
+#else
+#define CLASSIFICATION_DEFAULT_BACKEND CLASSIFICATION_BACKEND_NATIVE
+#endif
+
 typedef struct {
 	float X, Y, Z;
 } ClassificationDataPoint;
 
+typedef QHash<QString, QVector<ClassificationDataPoint>> ClassificationQueue;
+
+// sensors of one insole in a window, keyed "<esp id>_<sensor>" like the MQTT topics
+typedef struct {
+	QStringView id; // esp id, points into the queue keys
+	ClassificationQueue::iterator sensors[CLASSIFICATION_NUM_SENSORS]; // key order
+	int num_sensors;
+	int timesteps;
+} ClassificationSession;
+
 class ClassificationWorker : public QObject {
 	Q_OBJECT
 public:
 	ClassificationWorker(QObject* parent = nullptr);
 	~ClassificationWorker();
-	void init(std::string model_path, std::string label_path);
+	// model_path is a SavedModel directory for TensorFlow and a weights file for the native backend
+	void init(std::string model_path, std::string label_path, ClassificationMode mode = CLASSIFICATION_MODE_WINDOW,
+			  ClassificationBackend backend = CLASSIFICATION_DEFAULT_BACKEND);
+	bool isReady() const;
+	ClassificationMode mode() const;
+	ClassificationBackend backend() const;
+
+	// TensorFlow backend only, every run is repeated on LstmEngine and the probabilities compared
+	bool setNativeCheck(const std::string& weights_path);
+	float nativeCheckMaxDiff() const; // largest absolute probability difference so far
+	int nativeCheckRuns() const;
+	int nativeCheckMismatches() const; // runs where the two backends picked different labels
 
 	void addData(QString key, float X, float Y, float Z);
 
 public slots:
 	void classify(int index);
 	void classifyCurrentSlot();
+	void step(); // streaming, advances the LSTM over every frame completed since the last call
 
 Q_SIGNALS:
 	void sig_classify(int index);
-	void sig_classificationResult(const QString& result);
+	void sig_step();
+	void sig_classificationResult(const QString& result); // once per session
+	void sig_classificationResults(const QStringList& sessions, const QStringList& results); // once per run
 
 private:
+	ClassificationBackend m_backend = CLASSIFICATION_DEFAULT_BACKEND;
+	ClassificationMode m_mode = CLASSIFICATION_MODE_WINDOW;
+	QVector<QString> labels;
+
+#ifdef WITH_TENSORFLOW
 	TF_Graph* graph;
 	TF_Session* session;
 	TF_Status* status;
 	TF_Buffer* run_options;
 	TF_Buffer* run_metadata;
-	TF_Output input_op;
-	TF_Output output_op;
-	QVector<QString> labels;
+	TF_Output input_op;  // resolved once by init
+	TF_Output output_op; // resolved once by init
+	std::vector<TF_Tensor*> input_tensors; // one per timestep count, index timesteps - 1, allocated by init
+	QHash<int, TF_Tensor*> batch_tensors;  // batch > 1, allocated on first use, key batch * 256 + timesteps
+
+	// streaming, the LSTM state lives in step_state and is fed back on every step
+	TF_Output step_inputs[3];  // frame, h, c
+	TF_Output step_outputs[3]; // c, h, probabilities
+	TF_Tensor* step_frame = nullptr;
+	TF_Tensor* step_state[2] = {nullptr, nullptr}; // h, c
+
+	bool initTensorflow(const std::string& model_path);
+	bool initTensorflowWindow();
+	bool initTensorflowStreaming();
+	bool runTensorflowWindow(const float* input, int batch, int timesteps, int* results);
+	int runTensorflowStep(const float* frame);
+#endif
+
+	// native backend, or the reference of the native check
+	LstmEngine engine;
+	bool native_check = false;
+	float native_check_max_diff = 0;
+	int native_check_runs = 0, native_check_mismatches = 0;
+	std::vector<float> native_input; // windows or frame when TensorFlow does not own the input, grows with the batch
+	std::vector<float> native_probs;
+	std::vector<float> native_h, native_c;
 
-	QHash<QString, QVector<ClassificationDataPoint>> data_queue[2];
+	ClassificationQueue data_queue[2];
 	int data_queue_index = 0;
 	bool data_queue_available[2] = {true, true};
 	const int max_data_size = 50;
+
+	// one entry per insole of the window being classified, reused by every classify
+	std::vector<ClassificationSession> sessions;
+	std::vector<int> batch_results;
+	QStringList result_sessions, result_labels;
+
+	QString stream_id;		 // esp id of the insole being streamed, addData thread only
+	QStringList stream_keys; // sorted, addData thread only
+	ClassificationDataPoint stream_frame[CLASSIFICATION_NUM_SENSORS];
+	int stream_seen = 0;	// bit per sensor of stream_frame
+	int stream_stalled = 0; // readings of any insole since the last complete frame
+
+	QMutex stream_mutex;
+	std::vector<ClassificationDataPoint> stream_pending; // complete frames, guarded by stream_mutex
+	bool stream_posted = false;							 // sig_step queued, guarded by stream_mutex
+	bool stream_reset = false;							 // sensors changed, guarded by stream_mutex
+	std::vector<ClassificationDataPoint> stream_work;	 // step() only
+
+	bool initNative(const std::string& weights_path);
+	int collectSessions(ClassificationQueue& queue);
+	float* windowInput(int batch, int timesteps);
+	float* stepInput();
+	// batch windows of timesteps frames back to back, results gets a label index per window
+	bool runWindow(const float* input, int batch, int timesteps, int* results);
+	int runStep(const float* frame);
+	void resetState();
+	int compareNative(const float* probs, int num_outputs); // label index of probs
+	void addStreamData(const QString& key, float X, float Y, float Z);
 };
 
 #endif // _CLASSIFICATION_WORKER_HPP
@@ -1,7 +1,10 @@
 #ifndef _GRAPHICS_WORKER_H
 #define _GRAPHICS_WORKER_H
 
+#include "graphics_renderer.hpp"
+
 #include <QtCore/QObject>
+#include <vector>
 
 class GraphicsWorker : public QObject {
 	Q_OBJECT
@@ -14,6 +17,7 @@ public Q_SLOTS:
 
 private:
 	void* main_window;
+	std::vector<GraphicsSample> samples; // averaged sensor values of the current frame
 };
 
 #endif // _GRAPHICS_WORKER_H
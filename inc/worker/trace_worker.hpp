@@ -0,0 +1,67 @@
+#ifndef _TRACE_WORKER_HPP
+#define _TRACE_WORKER_HPP
+
+#include <QColor>
+#include <QHash>
+#include <QImage>
+#include <QMutex>
+#include <QRect>
+#include <QSize>
+#include <QStringList>
+#include <QVector>
+#include <QtCore/QObject>
+#include <stdint.h>
+
+
+typedef enum {
+	TRACE_LAYOUT_SMALL_MULTIPLES, // one cell per sensor, X/Y/Z overlaid in each cell
+	TRACE_LAYOUT_OVERLAY,		  // one row per axis, every sensor overlaid in each row
+	NUM_OF_TRACE_LAYOUT,
+} TraceLayout;
+
+typedef struct {
+	QVector<qint64> timestamps;
+	QVector<int16_t> values[3]; // X, Y, Z
+	int head, count;
+	qint64 latest_time; // per sensor, the clocks of different insoles are not aligned
+} TraceRing;
+
+// samples written by the GUI thread and read by TraceWorker, every access holds mutex
+typedef struct {
+	QMutex mutex;
+	QHash<QString, TraceRing*> rings;
+	QStringList keys; // sorted, same order as the combo box
+	int capacity;
+} TraceStore;
+
+class TraceWorker : public QObject {
+	Q_OBJECT
+public:
+	TraceWorker(TraceStore* store, QObject* parent = nullptr);
+	~TraceWorker();
+
+public Q_SLOTS:
+	void render(QSize size, int layout, qint64 window_ms);
+
+Q_SIGNALS:
+	void frameReady(const QImage& frame);
+
+private:
+	// per pixel column min/max of one trace, reused between frames
+	typedef struct {
+		QVector<int16_t> min, max;
+		QVector<bool> has;
+		int16_t lo, hi;
+		bool any;
+	} TraceColumns;
+
+	TraceStore* store;
+	QVector<TraceColumns> columns; // [sensor * 3 + axis]
+	QStringList keys;
+
+	void reduce(int width, qint64 window_ms);
+	// writes the pixels directly, no QPainter may be active on image
+	void drawTrace(QImage& image, QRect rect, const TraceColumns& trace, int lo, int hi, QRgb color) const;
+};
+
+#endif // _TRACE_WORKER_HPP
@@ -0,0 +1,84 @@
+import struct
+import sys
+
+import numpy as np
+
+# layout mirrors inc/lstm_engine.hpp
+LSTM_WEIGHTS_MAGIC = b"ISLM"
+LSTM_WEIGHTS_VERSION = 1
+ACTIVATIONS = {"linear": 0, "relu": 1, "softmax": 2}
+# windows and the probabilities Keras gives for them, checked by tests/tst_lstm_engine.cpp
+LSTM_REFERENCE_MAGIC = b"ISLR"
+
+
+def write_weights(path, lstm, dense):
+    """Write the LSTM and dense layers for LstmEngine.
+
+    lstm is (kernel, recurrent_kernel, bias) with the gates in Keras order i, f, c, o,
+    dense is a list of (kernel, bias, activation name).
+    """
+    kernel, recurrent_kernel, bias = (np.asarray(w, dtype="<f4") for w in lstm)
+    input_size, units = kernel.shape[0], recurrent_kernel.shape[0]
+    with open(path, "wb") as f:
+        f.write(
+            struct.pack("<4s7I", LSTM_WEIGHTS_MAGIC, LSTM_WEIGHTS_VERSION, input_size, units, len(dense), 0, 0, 0)
+        )
+        for w, b, activation in dense:
+            f.write(struct.pack("<4I", w.shape[0], w.shape[1], ACTIVATIONS[activation], 0))
+        for w in (kernel, recurrent_kernel, bias):
+            f.write(np.ascontiguousarray(w).tobytes())
+        for w, b, _ in dense:
+            f.write(np.ascontiguousarray(w, dtype="<f4").tobytes())
+            f.write(np.ascontiguousarray(b, dtype="<f4").tobytes())
+
+
+def write_reference(path, frames, probs):
+    """Write input windows (n, timesteps, 5, 3) and the model's probabilities (n, classes) for them.
+
+    Header is magic, n, timesteps, floats per timestep and classes, followed by the float32 windows and
+    probabilities, row major.
+    """
+    frames = np.asarray(frames, dtype="<f4")
+    probs = np.asarray(probs, dtype="<f4")
+    n, timesteps = frames.shape[:2]
+    with open(path, "wb") as f:
+        f.write(struct.pack("<4s7I", LSTM_REFERENCE_MAGIC, n, timesteps, frames[0, 0].size, probs.shape[1], 0, 0, 0))
+        f.write(np.ascontiguousarray(frames).tobytes())
+        f.write(np.ascontiguousarray(probs).tobytes())
+
+
+def export_reference(model, path, windows=4, timesteps=20, seed=0):
+    """Fixed random windows through the Keras model, LstmEngine has to give the same probabilities"""
+    frames = np.random.default_rng(seed).uniform(-1, 1, (windows, timesteps, 5, 3)).astype("<f4")
+    write_reference(path, frames, model.predict(frames, verbose=0))
+
+
+def export_model(model, path):
+    """Weights of a trained model.create_model for the app's native classification backend"""
+    import tensorflow as tf
+
+    lstm = next(layer for layer in model.layers if isinstance(layer, tf.keras.layers.LSTM))
+    if lstm.activation.__name__ != "tanh" or lstm.recurrent_activation.__name__ != "sigmoid":
+        raise ValueError("LstmEngine only implements the default tanh / sigmoid LSTM")
+    if not lstm.use_bias:
+        raise ValueError("LstmEngine expects an LSTM with bias")
+    dense = [
+        (*layer.get_weights(), layer.activation.__name__)
+        for layer in model.layers
+        if isinstance(layer, tf.keras.layers.Dense)
+    ]
+    write_weights(path, lstm.get_weights(), dense)
+
+
+if __name__ == "__main__":
+    # python export_weights.py model.pb model.islm [reference.bin]
+    import tensorflow as tf
+
+    src = sys.argv[1] if len(sys.argv) > 1 else "model.pb"
+    dst = sys.argv[2] if len(sys.argv) > 2 else "model.islm"
+    model = tf.keras.models.load_model(src)
+    export_model(model, dst)
+    print(f"{src} exported to {dst}")
+    if len(sys.argv) > 3:
+        export_reference(model, sys.argv[3])
+        print(f"Reference windows written to {sys.argv[3]}")
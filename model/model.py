@@ -16,6 +16,34 @@ def create_model(num_classes: int) -> tf.keras.Model:
     return model
 
 
+def create_step_model(model: tf.keras.Model) -> tf.keras.Model:
+    """One LSTM timestep of a trained create_model, sharing its weights.
+
+    Inputs are one frame (1, 5, 3) and the LSTM state h, c (1, units), outputs are sorted by name so the
+    SavedModel signature is StatefulPartitionedCall:0 = step_c, :1 = step_h, :2 = step_probs.
+    Zero state followed by n steps gives the same probabilities as the full model on those n frames.
+    """
+    lstm = next(layer for layer in model.layers if isinstance(layer, tf.keras.layers.LSTM))
+    dense = [layer for layer in model.layers if isinstance(layer, tf.keras.layers.Dense)]
+
+    frame = tf.keras.Input(shape=(5, 3), batch_size=1, name="step_frame")
+    h = tf.keras.Input(shape=(lstm.units,), batch_size=1, name="step_h")
+    c = tf.keras.Input(shape=(lstm.units,), batch_size=1, name="step_c")
+    x = tf.keras.layers.Flatten()(frame)
+    x, (h_out, c_out) = lstm.cell(x, states=[h, c])
+    for layer in dense:
+        x = layer(x)
+
+    return tf.keras.Model(
+        inputs=[frame, h, c],
+        outputs=[
+            tf.keras.layers.Activation("linear", name="step_c")(c_out),
+            tf.keras.layers.Activation("linear", name="step_h")(h_out),
+            tf.keras.layers.Activation("linear", name="step_probs")(x),
+        ],
+    )
+
+
 if __name__ == "__main__":
     model = create_model(num_classes=2)
     model.summary()
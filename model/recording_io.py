@@ -0,0 +1,94 @@
+import json
+import os
+
+import numpy as np
+
+# layout mirrors inc/recording_file.hpp
+RECORDING_FILE_MAGIC = b"ISRC"
+RECORDING_INDEX_MAGIC = b"ISRI"
+RECORDING_FILE_VERSION = 1
+
+HEADER_DTYPE = np.dtype(
+    [
+        ("magic", "S4"),
+        ("version", "<u4"),
+        ("init_time", "<i8"),
+        ("block_samples", "<u4"),
+        ("reserved", "<u4", 3),
+    ]
+)
+INDEX_DTYPE = np.dtype(
+    [
+        ("sensor", "<u4"),
+        ("count", "<u4"),
+        ("offset", "<u8"),
+        ("first_time", "<i8"),
+        ("last_time", "<i8"),
+    ]
+)
+FOOTER_DTYPE = np.dtype(
+    [
+        ("sensor_table_offset", "<u8"),
+        ("index_offset", "<u8"),
+        ("sensor_count", "<u4"),
+        ("block_count", "<u4"),
+        ("magic", "S4"),
+        ("reserved", "<u4"),
+    ]
+)
+
+
+def load_binary_recording(path):
+    """Return {"init_time": int, sensor_id: int64 array of shape (n, 5)} from a *.isrec file"""
+    buf = np.memmap(path, dtype=np.uint8, mode="r")
+    header = np.frombuffer(buf, HEADER_DTYPE, count=1)[0]
+    footer = np.frombuffer(buf[-FOOTER_DTYPE.itemsize :], FOOTER_DTYPE, count=1)[0]
+    if header["magic"] != RECORDING_FILE_MAGIC or footer["magic"] != RECORDING_INDEX_MAGIC:
+        raise ValueError(f"{path}: not a recording file or recording incomplete")
+    if header["version"] != RECORDING_FILE_VERSION:
+        raise ValueError(f"{path}: unsupported recording version {header['version']}")
+
+    keys = []
+    pos = int(footer["sensor_table_offset"])
+    for _ in range(int(footer["sensor_count"])):
+        length = int(np.frombuffer(buf, "<u2", count=1, offset=pos)[0])
+        keys.append(bytes(buf[pos + 2 : pos + 2 + length]).decode("utf-8"))
+        pos += 2 + length
+
+    index = np.frombuffer(
+        buf, INDEX_DTYPE, count=int(footer["block_count"]), offset=int(footer["index_offset"])
+    )
+    parts = {sensor: [] for sensor in range(len(keys))}
+    for entry in index:
+        n, offset = int(entry["count"]), int(entry["offset"])
+        block = np.empty((n, 5), dtype=np.int64)
+        block[:, 0] = np.frombuffer(buf, "<i8", count=n, offset=offset)
+        cols = np.frombuffer(buf, "<i2", count=4 * n, offset=offset + 8 * n).reshape(4, n)
+        block[:, 1:] = cols.T
+        parts[int(entry["sensor"])].append(block)
+
+    data = {"init_time": int(header["init_time"])}
+    for sensor, key in enumerate(keys):
+        blocks = parts[sensor]
+        data[key] = np.concatenate(blocks) if blocks else np.empty((0, 5), dtype=np.int64)
+    return data
+
+
+def load_json_recording(path):
+    with open(path, "r") as f:
+        raw = json.load(f)
+    data = {"init_time": int(raw.get("init_time", 0))}
+    for key, rows in raw.items():
+        if key != "init_time":
+            data[key] = np.asarray(rows, dtype=np.int64).reshape(-1, 5)
+    return data
+
+
+def is_recording(filename):
+    return filename.endswith(".json") or filename.endswith(".isrec")
+
+
+def load_recording(path):
+    if os.path.splitext(path)[1] == ".json":
+        return load_json_recording(path)
+    return load_binary_recording(path)
@@ -3,25 +3,25 @@ import absl.logging
 absl.logging.set_verbosity(absl.logging.ERROR)
 
 import os
-import json
 import numpy as np
 from sklearn.model_selection import train_test_split, KFold
 from sklearn.preprocessing import LabelEncoder
 import tensorflow as tf
 from datetime import datetime
 
-from model import create_model
+from export_weights import export_model
+from model import create_model, create_step_model
+from recording_io import is_recording, load_recording
 
 
 def load_and_preprocess_data(data_dir):
     samples, labels = [], []
 
     for filename in os.listdir(data_dir):
-        if filename.endswith(".json"):
+        if is_recording(filename):
             class_name = filename.split("_")[1]
             labels.append(class_name)
-            with open(os.path.join(data_dir, filename), "r") as f:
-                data = json.load(f)
+            data = load_recording(os.path.join(data_dir, filename))
 
             # Extract sensor data (5 sensors)
             sensor_ids = sorted([k for k in data.keys() if k != "init_time"])
@@ -31,7 +31,7 @@ def load_and_preprocess_data(data_dir):
             sample_data = np.zeros((timesteps, 5, 3))
             for i, sid in enumerate(sensor_ids):
                 truncated = data[sid][:timesteps]
-                sample_data[:, i, :] = [entry[2:5] for entry in truncated]
+                sample_data[:, i, :] = truncated[:, 2:5]
 
             samples.append(sample_data)
 
@@ -139,5 +139,11 @@ if __name__ == "__main__":
     best_model = min(results, key=lambda x: x[1])
     best_model[0].save("model.pb")
     print(f"Model with loss {best_model[1]:.4f} saved as model.pb")
+    # streaming classification, one LSTM step per frame with the state kept by the app
+    create_step_model(best_model[0]).save("model_step.pb")
+    print("Step model saved as model_step.pb")
+    # native classification backend, no TensorFlow needed in the app
+    export_model(best_model[0], "model.islm")
+    print("Weights saved as model.islm")
 
     # saved_model_cli show --dir ./model.pb --tag_set serve --signature_def serving_default
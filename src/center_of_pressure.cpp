@@ -0,0 +1,98 @@
+#include "center_of_pressure.hpp"
+
+#include <QtMinMax>
+
+
+CopTrajectory::CopTrajectory(int capacity) { this->setCapacity(capacity); }
+
+CopTrajectory::~CopTrajectory() {}
+
+void CopTrajectory::setCapacity(int capacity) {
+	this->m_capacity = qMax(1, capacity);
+	this->buffer.resize(2 * this->m_capacity);
+	this->clear();
+}
+
+void CopTrajectory::push(const QPointF& point) {
+	int tail = this->head + this->count;
+	if (tail >= this->m_capacity) {
+		tail -= this->m_capacity;
+	}
+	this->buffer[tail] = point;
+	this->buffer[tail + this->m_capacity] = point;
+	if (this->count == this->m_capacity) {
+		this->head = this->head + 1 == this->m_capacity ? 0 : this->head + 1;
+	} else {
+		this->count++;
+	}
+}
+
+void CopTrajectory::clear() { this->head = this->count = 0; }
+
+int CopTrajectory::capacity() const { return this->m_capacity; }
+
+int CopTrajectory::size() const { return this->count; }
+
+bool CopTrajectory::isEmpty() const { return this->count == 0; }
+
+const QPointF* CopTrajectory::data() const { return this->buffer.constData() + this->head; }
+
+const QPointF& CopTrajectory::last() const { return this->data()[this->count - 1]; }
+
+CenterOfPressure::CenterOfPressure() {
+	this->begin();
+	for (int foot = 0; foot < NUM_OF_COP_FOOT; foot++) {
+		this->valid[foot] = false;
+	}
+}
+
+CenterOfPressure::~CenterOfPressure() {}
+
+void CenterOfPressure::setTrailLength(int frames) {
+	for (int foot = 0; foot < NUM_OF_COP_FOOT; foot++) {
+		this->trajectories[foot].setCapacity(frames);
+	}
+}
+
+void CenterOfPressure::setMinWeight(qreal weight) { this->min_weight = weight; }
+
+void CenterOfPressure::begin() {
+	for (int foot = 0; foot < NUM_OF_COP_FOOT; foot++) {
+		this->sum_x[foot] = this->sum_y[foot] = this->sum_weight[foot] = 0;
+	}
+}
+
+void CenterOfPressure::add(CopFoot foot, qreal x, qreal y, qreal weight) {
+	if (weight <= 0) {
+		return;
+	}
+	this->sum_x[foot] += x * weight;
+	this->sum_y[foot] += y * weight;
+	this->sum_weight[foot] += weight;
+}
+
+void CenterOfPressure::end() {
+	for (int foot = 0; foot < NUM_OF_COP_FOOT; foot++) {
+		this->valid[foot] = this->sum_weight[foot] >= this->min_weight && this->sum_weight[foot] > 0;
+		if (this->valid[foot]) {
+			this->trajectories[foot].push(
+				QPointF(this->sum_x[foot] / this->sum_weight[foot], this->sum_y[foot] / this->sum_weight[foot]));
+		}
+	}
+}
+
+void CenterOfPressure::clear() {
+	this->begin();
+	for (int foot = 0; foot < NUM_OF_COP_FOOT; foot++) {
+		this->valid[foot] = false;
+		this->trajectories[foot].clear();
+	}
+}
+
+bool CenterOfPressure::isValid(CopFoot foot) const { return this->valid[foot]; }
+
+QPointF CenterOfPressure::current(CopFoot foot) const {
+	return this->trajectories[foot].isEmpty() ? QPointF() : this->trajectories[foot].last();
+}
+
+const CopTrajectory& CenterOfPressure::trajectory(CopFoot foot) const { return this->trajectories[foot]; }
@@ -0,0 +1,99 @@
+#include "chart_autoscale.hpp"
+
+#include <QtMath>
+#include <QtMinMax>
+
+
+ChartAutoscale chartAutoscaleFromString(const QString& name, ChartAutoscale fallback) {
+	const QString lower = name.toLower();
+	if (lower == "fixed") {
+		return CHART_AUTOSCALE_FIXED;
+	}
+	if (lower == "windowed") {
+		return CHART_AUTOSCALE_WINDOWED;
+	}
+	if (lower == "percentile") {
+		return CHART_AUTOSCALE_PERCENTILE;
+	}
+	return fallback;
+}
+
+ChartAutoscaler::ChartAutoscaler(int window_) : window(qMax(1, window_)) { this->allocate(); }
+
+ChartAutoscaler::~ChartAutoscaler() { delete this->histogram; }
+
+void ChartAutoscaler::setWindow(int window_) {
+	this->window = qMax(1, window_);
+	this->allocate();
+}
+
+void ChartAutoscaler::setPolicy(ChartAutoscale policy) {
+	this->m_policy = policy;
+	this->allocate();
+}
+
+ChartAutoscale ChartAutoscaler::policy() const { return this->m_policy; }
+
+void ChartAutoscaler::setFixedRange(qreal lo, qreal hi) {
+	this->fixed_lo = qMin(lo, hi);
+	this->fixed_hi = qMax(lo, hi);
+}
+
+void ChartAutoscaler::setPercentile(qreal percent_) { this->percent = qBound(0.0, percent_, 50.0); }
+
+void ChartAutoscaler::push(qreal value) {
+	// only the structure of the active policy is fed
+	switch (this->m_policy) {
+		case CHART_AUTOSCALE_WINDOWED: this->minmax.push(value); break;
+		case CHART_AUTOSCALE_PERCENTILE: this->histogram->push(qBound(-32768, qRound(value), 32767)); break;
+		default: break;
+	}
+}
+
+void ChartAutoscaler::clear() {
+	this->minmax.clear();
+	if (this->histogram) {
+		this->histogram->clear();
+	}
+}
+
+bool ChartAutoscaler::range(qreal& lo, qreal& hi) const {
+	switch (this->m_policy) {
+		case CHART_AUTOSCALE_WINDOWED: {
+			if (this->minmax.isEmpty()) {
+				return false;
+			}
+			lo = this->minmax.min();
+			hi = this->minmax.max();
+			return true;
+		}
+		case CHART_AUTOSCALE_PERCENTILE: {
+			if (this->histogram->size() == 0) {
+				return false;
+			}
+			lo = this->histogram->quantile(this->percent / 100);
+			hi = this->histogram->quantile(1 - this->percent / 100);
+			return true;
+		}
+		default: {
+			lo = this->fixed_lo;
+			hi = this->fixed_hi;
+			return true;
+		}
+	}
+}
+
+void ChartAutoscaler::allocate() {
+	// every sensor has its own autoscalers, only the active policy gets memory
+	this->minmax.setWindow(this->m_policy == CHART_AUTOSCALE_WINDOWED ? this->window : 1);
+	if (this->m_policy == CHART_AUTOSCALE_PERCENTILE) {
+		if (!this->histogram) {
+			this->histogram = new WindowHistogram(this->window);
+		} else {
+			this->histogram->setWindow(this->window);
+		}
+	} else {
+		delete this->histogram;
+		this->histogram = nullptr;
+	}
+}
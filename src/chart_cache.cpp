@@ -0,0 +1,106 @@
+#include "chart_cache.hpp"
+
+#include <QtMinMax>
+
+
+static QString chartOption(const QJsonValue& value, int chart) {
+	return value.isArray() ? value.toArray().at(chart).toString() : value.toString();
+}
+
+ChartCacheConfig loadChartCacheConfig(Settings* settings) {
+	ChartCacheConfig config;
+	config.capacity = CHART_DEFAULT_WINDOW_SIZE;
+	config.display_target = 0;
+	config.fixed_lo = -SENSOR_VALUE_SCALE;
+	config.fixed_hi = SENSOR_VALUE_SCALE;
+	config.percentile = 1;
+	for (int i = 0; i < 3; i++) {
+		config.decimation[i] = CHART_DECIMATION_MINMAX;
+		config.autoscale[i] = CHART_AUTOSCALE_WINDOWED;
+	}
+
+	if (settings->contains("chart_window_size")) {
+		config.capacity = qMax(2, settings->get("chart_window_size").toInt());
+	}
+	if (settings->contains("chart_decimation")) {
+		const QJsonValue value = settings->get("chart_decimation");
+		for (int i = 0; i < 3; i++) {
+			config.decimation[i] = chartDecimationFromString(chartOption(value, i));
+		}
+	}
+	if (settings->contains("chart_autoscale")) {
+		const QJsonValue value = settings->get("chart_autoscale");
+		for (int i = 0; i < 3; i++) {
+			config.autoscale[i] = chartAutoscaleFromString(chartOption(value, i));
+		}
+	}
+	if (settings->contains("chart_fixed_range")) {
+		const QJsonArray range = settings->get("chart_fixed_range").toArray();
+		if (range.size() == 2) {
+			config.fixed_lo = range.at(0).toDouble();
+			config.fixed_hi = range.at(1).toDouble();
+		}
+	}
+	if (settings->contains("chart_percentile")) {
+		config.percentile = settings->get("chart_percentile").toDouble();
+	}
+	return config;
+}
+
+
+ChartSensorCache::ChartSensorCache(const ChartCacheConfig& config) {
+	for (int i = 0; i < 3; i++) {
+		this->decimation[i] = config.decimation[i];
+		this->data[i].setCapacity(config.capacity);
+		this->data[i].setDecimation(config.decimation[i], config.display_target);
+		this->ranges[i].setWindow(config.capacity);
+		this->ranges[i].setPolicy(config.autoscale[i]);
+		this->ranges[i].setFixedRange(config.fixed_lo, config.fixed_hi);
+		this->ranges[i].setPercentile(config.percentile);
+	}
+}
+
+ChartSensorCache::~ChartSensorCache() {}
+
+bool ChartSensorCache::append(qreal time_sec, qreal X, qreal Y, qreal Z) {
+	if (!this->data[0].isEmpty() && time_sec <= this->data[0].last().x()) {
+		return false;
+	}
+	const qreal values[3] = {X, Y, Z};
+	for (int i = 0; i < 3; i++) {
+		if (!this->data[i].append(time_sec, values[i])) {
+			this->ranges[i].clear(); // the window started over, so does its range
+		}
+		this->ranges[i].push(values[i]);
+	}
+	return true;
+}
+
+void ChartSensorCache::clear() {
+	for (int i = 0; i < 3; i++) {
+		this->data[i].clear();
+		this->ranges[i].clear();
+	}
+}
+
+void ChartSensorCache::setDisplayTarget(int target) {
+	for (int i = 0; i < 3; i++) {
+		this->data[i].setDecimation(this->decimation[i], target);
+	}
+}
+
+void ChartSensorCache::resyncDisplay() {
+	for (int i = 0; i < 3; i++) {
+		this->data[i].resyncDisplay();
+	}
+}
+
+ChartSeriesBuffer& ChartSensorCache::series(int axis) { return this->data[axis]; }
+
+const ChartAutoscaler& ChartSensorCache::range(int axis) const { return this->ranges[axis]; }
+
+bool ChartSensorCache::isEmpty() const { return this->data[0].isEmpty(); }
+
+qreal ChartSensorCache::firstTime() const { return this->data[0].first().x(); }
+
+qreal ChartSensorCache::lastTime() const { return this->data[0].last().x(); }
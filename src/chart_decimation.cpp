@@ -0,0 +1,122 @@
+#include "chart_decimation.hpp"
+
+#include <QtMath>
+
+
+ChartDecimation chartDecimationFromString(const QString& name, ChartDecimation fallback) {
+	const QString lower = name.toLower();
+	if (lower == "none") {
+		return CHART_DECIMATION_NONE;
+	}
+	if (lower == "minmax") {
+		return CHART_DECIMATION_MINMAX;
+	}
+	if (lower == "lttb") {
+		return CHART_DECIMATION_LTTB;
+	}
+	return fallback;
+}
+
+static void copyPoints(const QPointF* points, int n, QList<QPointF>& out) {
+	out.clear();
+	out.reserve(n);
+	for (int i = 0; i < n; i++) {
+		out.append(points[i]);
+	}
+}
+
+void decimateMinMax(const QPointF* points, int n, int target, QList<QPointF>& out) {
+	if (n <= target || target < 4) {
+		copyPoints(points, n, out);
+		return;
+	}
+	out.clear();
+	out.reserve(target);
+
+	// buckets split the x range evenly, so a gap in the data stays a gap instead of being stretched
+	const int buckets = target / 2;
+	const qreal x0 = points[0].x();
+	const qreal span = points[n - 1].x() - x0;
+	int i = 0;
+	for (int b = 0; b < buckets && i < n; b++) {
+		const bool last_bucket = b == buckets - 1;
+		const qreal x_end = x0 + span * (b + 1) / buckets;
+		if (!last_bucket && points[i].x() > x_end) {
+			continue;
+		}
+		int min_i = i, max_i = i;
+		for (i++; i < n && (last_bucket || points[i].x() <= x_end); i++) {
+			if (points[i].y() < points[min_i].y()) {
+				min_i = i;
+			}
+			if (points[i].y() > points[max_i].y()) {
+				max_i = i;
+			}
+		}
+		// keep the pair in time order so the line does not fold back
+		if (min_i == max_i) {
+			out.append(points[min_i]);
+		} else if (min_i < max_i) {
+			out.append(points[min_i]);
+			out.append(points[max_i]);
+		} else {
+			out.append(points[max_i]);
+			out.append(points[min_i]);
+		}
+	}
+}
+
+void decimateLttb(const QPointF* points, int n, int target, QList<QPointF>& out) {
+	if (n <= target || target < 3) {
+		copyPoints(points, n, out);
+		return;
+	}
+	out.clear();
+	out.reserve(target);
+
+	// first and last points are kept, the n - 2 points between them are split into target - 2 buckets
+	const qreal every = (qreal)(n - 2) / (target - 2);
+	int a = 0;
+	out.append(points[0]);
+	for (int b = 0; b < target - 2; b++) {
+		// average of the next bucket is the third vertex of the triangle
+		int avg_start = (int)((b + 1) * every) + 1;
+		int avg_end = qMin((int)((b + 2) * every) + 1, n);
+		if (avg_start >= avg_end) {
+			avg_start = n - 1;
+			avg_end = n;
+		}
+		qreal avg_x = 0, avg_y = 0;
+		for (int i = avg_start; i < avg_end; i++) {
+			avg_x += points[i].x();
+			avg_y += points[i].y();
+		}
+		avg_x /= avg_end - avg_start;
+		avg_y /= avg_end - avg_start;
+
+		const int range_start = (int)(b * every) + 1;
+		const int range_end = qMin((int)((b + 1) * every) + 1, n - 1);
+		const qreal ax = points[a].x(), ay = points[a].y();
+		qreal max_area = -1;
+		int next_a = range_start;
+		for (int i = range_start; i < range_end; i++) {
+			// twice the triangle area, the constant factor does not change the argmax
+			const qreal area = qAbs((ax - avg_x) * (points[i].y() - ay) - (ax - points[i].x()) * (avg_y - ay));
+			if (area > max_area) {
+				max_area = area;
+				next_a = i;
+			}
+		}
+		out.append(points[next_a]);
+		a = next_a;
+	}
+	out.append(points[n - 1]);
+}
+
+void decimate(ChartDecimation mode, const QList<QPointF>& points, int target, QList<QPointF>& out) {
+	switch (mode) {
+		case CHART_DECIMATION_MINMAX: decimateMinMax(points.constData(), points.size(), target, out); break;
+		case CHART_DECIMATION_LTTB: decimateLttb(points.constData(), points.size(), target, out); break;
+		default: copyPoints(points.constData(), points.size(), out); break;
+	}
+}
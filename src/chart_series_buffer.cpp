@@ -0,0 +1,239 @@
+#include "chart_series_buffer.hpp"
+
+#include <QtMath>
+#include <QtMinMax>
+
+
+ChartSeriesBuffer::ChartSeriesBuffer(int capacity) { this->setCapacity(capacity); }
+
+ChartSeriesBuffer::~ChartSeriesBuffer() {}
+
+void ChartSeriesBuffer::setCapacity(int capacity) {
+	capacity = qMax(1, capacity);
+	this->points.resize(capacity);
+	this->display.resize(capacity + 1); // lttb keeps the first point of a bucket as well
+	this->clear();
+}
+
+void ChartSeriesBuffer::setDecimation(ChartDecimation mode_, int target_) {
+	if (mode_ == this->mode && target_ == this->target) {
+		return;
+	}
+	this->mode = mode_;
+	this->target = target_;
+	this->rebuildDisplay();
+}
+
+bool ChartSeriesBuffer::append(qreal x, qreal y) {
+	const bool continued = this->count == 0 || x >= this->last().x();
+	if (!continued) {
+		this->clear();
+	}
+	const int capacity = this->points.size();
+	if (this->count == capacity) {
+		this->head = this->head + 1 == capacity ? 0 : this->head + 1;
+		this->count--;
+		if (!this->bucketed) {
+			this->popDisplay();
+		}
+	}
+	int tail = this->head + this->count;
+	if (tail >= capacity) {
+		tail -= capacity;
+	}
+	this->points[tail] = QPointF(x, y);
+	this->count++;
+	const qint64 seq = this->next_seq++;
+
+	if (!this->bucketed) {
+		this->pushDisplay(this->points[tail]);
+		if (this->canBucket()) { // once per window at most, from then on the points stream into buckets
+			this->rebuildDisplay();
+		}
+		return continued;
+	}
+	this->feedBucket(seq);
+	const qreal first_x = this->first().x();
+	while (this->display_count && this->displayAt(0).x() < first_x) {
+		this->popDisplay();
+	}
+	if (this->display_count > 2 * this->target) { // rate went up since bucket_width was estimated
+		this->rebuildDisplay();
+	}
+	return continued;
+}
+
+void ChartSeriesBuffer::clear() {
+	this->head = this->count = 0;
+	this->display_head = this->display_count = 0;
+	this->display_synced = this->display_removed = 0;
+	this->display_reset = true;
+	this->bucketed = false;
+	this->has_open = this->has_prev = this->has_selected = false;
+}
+
+int ChartSeriesBuffer::size() const { return this->count; }
+
+bool ChartSeriesBuffer::isEmpty() const { return this->count == 0; }
+
+const QPointF& ChartSeriesBuffer::at(int index) const {
+	int i = this->head + index;
+	if (i >= this->points.size()) {
+		i -= this->points.size();
+	}
+	return this->points[i];
+}
+
+const QPointF& ChartSeriesBuffer::first() const { return this->at(0); }
+
+const QPointF& ChartSeriesBuffer::last() const { return this->at(this->count - 1); }
+
+int ChartSeriesBuffer::displaySize() const { return this->display_count; }
+
+bool ChartSeriesBuffer::takeDisplayChanges(int& removed, QList<QPointF>& appended) {
+	appended.clear();
+	const bool incremental = !this->display_reset;
+	removed = incremental ? this->display_removed : 0;
+	for (int i = incremental ? this->display_synced : 0; i < this->display_count; i++) {
+		appended.append(this->displayAt(i));
+	}
+	this->display_synced = this->display_count;
+	this->display_removed = 0;
+	this->display_reset = false;
+	return incremental;
+}
+
+void ChartSeriesBuffer::resyncDisplay() { this->display_reset = true; }
+
+/* private */
+const QPointF& ChartSeriesBuffer::pointAt(qint64 seq) const { return this->at(seq - (this->next_seq - this->count)); }
+
+const QPointF& ChartSeriesBuffer::displayAt(int index) const {
+	int i = this->display_head + index;
+	if (i >= this->display.size()) {
+		i -= this->display.size();
+	}
+	return this->display[i];
+}
+
+void ChartSeriesBuffer::pushDisplay(const QPointF& point) {
+	if (this->display_count == this->display.size()) {
+		this->popDisplay();
+	}
+	int tail = this->display_head + this->display_count;
+	if (tail >= this->display.size()) {
+		tail -= this->display.size();
+	}
+	this->display[tail] = point;
+	this->display_count++;
+}
+
+void ChartSeriesBuffer::popDisplay() {
+	if (this->display_count == 0) {
+		return;
+	}
+	this->display_head = this->display_head + 1 == this->display.size() ? 0 : this->display_head + 1;
+	this->display_count--;
+	if (this->display_synced > 0) {
+		this->display_synced--;
+		this->display_removed++;
+	}
+}
+
+void ChartSeriesBuffer::feedBucket(qint64 seq) {
+	const QPointF& point = this->pointAt(seq);
+	const qint64 index = qFloor((point.x() - this->bucket_origin) / this->bucket_width);
+	if (this->has_open && index != this->open.index) {
+		this->closeBucket();
+	}
+	if (!this->has_open) {
+		this->open = {index, seq, seq + 1, point, point, point, seq, seq, point.x(), point.y()};
+		this->has_open = true;
+		return;
+	}
+	this->open.end_seq = seq + 1;
+	if (point.y() < this->open.min.y()) {
+		this->open.min = point;
+		this->open.min_seq = seq;
+	}
+	if (point.y() > this->open.max.y()) {
+		this->open.max = point;
+		this->open.max_seq = seq;
+	}
+	this->open.sum_x += point.x();
+	this->open.sum_y += point.y();
+}
+
+void ChartSeriesBuffer::closeBucket() {
+	this->has_open = false;
+	if (this->mode == CHART_DECIMATION_MINMAX) {
+		const bool min_first = this->open.min_seq <= this->open.max_seq;
+		this->pushDisplay(min_first ? this->open.min : this->open.max);
+		if (this->open.min_seq != this->open.max_seq) {
+			this->pushDisplay(min_first ? this->open.max : this->open.min);
+		}
+		return;
+	}
+
+	// lttb, one bucket behind: the point of prev is chosen once the average of the bucket after it is known
+	if (!this->has_selected) {
+		this->last_selected = this->open.first;
+		this->has_selected = true;
+		this->pushDisplay(this->last_selected);
+	}
+	if (this->has_prev) {
+		const qreal n = this->open.end_seq - this->open.first_seq;
+		const qreal avg_x = this->open.sum_x / n, avg_y = this->open.sum_y / n;
+		const qreal ax = this->last_selected.x(), ay = this->last_selected.y();
+		const qint64 oldest_seq = this->next_seq - this->count;
+		qreal max_area = -1;
+		qint64 selected = -1;
+		for (qint64 seq = qMax(this->prev.first_seq, oldest_seq); seq < this->prev.end_seq; seq++) {
+			const QPointF& p = this->pointAt(seq);
+			const qreal area = qAbs((ax - avg_x) * (p.y() - ay) - (ax - p.x()) * (avg_y - ay));
+			if (area > max_area) {
+				max_area = area;
+				selected = seq;
+			}
+		}
+		if (selected >= 0) {
+			this->last_selected = this->pointAt(selected);
+			this->pushDisplay(this->last_selected);
+		}
+	}
+	this->prev = this->open;
+	this->has_prev = true;
+}
+
+bool ChartSeriesBuffer::canBucket() const {
+	// below 4 shown points or without a time span there is nothing to decimate, the raw points are shown
+	return this->mode != CHART_DECIMATION_NONE && this->target >= 4 && this->count > this->target
+		&& this->last().x() > this->first().x();
+}
+
+void ChartSeriesBuffer::rebuildDisplay() {
+	this->display_head = this->display_count = 0;
+	this->display_synced = this->display_removed = 0;
+	this->display_reset = true;
+	this->has_open = this->has_prev = this->has_selected = false;
+
+	this->bucketed = false;
+	if (this->canBucket()) {
+		// the window may not be full yet, extrapolate its span from the current sample interval
+		const qreal interval = (this->last().x() - this->first().x()) / (this->count - 1);
+		const qreal window_span = interval * (this->points.size() - 1);
+		const int buckets = this->mode == CHART_DECIMATION_MINMAX ? this->target / 2 : this->target;
+		this->bucket_origin = this->first().x();
+		this->bucket_width = window_span / buckets;
+		this->bucketed = true;
+	}
+
+	const qint64 oldest_seq = this->next_seq - this->count;
+	for (qint64 seq = oldest_seq; seq < this->next_seq; seq++) {
+		if (this->bucketed) {
+			this->feedBucket(seq);
+		} else {
+			this->pushDisplay(this->pointAt(seq));
+		}
+	}
+}
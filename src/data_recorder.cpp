@@ -5,12 +5,11 @@
 #include <QDateTime>
 #include <QDir>
 #include <QFile>
-#include <qjsonarray.h>
-#include <qjsonobject.h>
 
 
 /*
-obj = {
+legacy json recording:
+{
 	"init_time": 0,
 
 	{sensor_id}: [
@@ -40,32 +39,10 @@ void DataReplayThread::run() {
 
 void DataReplayThread::end() { this->reply_running = false; }
 
-/* JsonObjIterator */
-JsonArrIterator::JsonArrIterator(QString key_, QJsonArray arr_) : key(key_), arr(arr_), index(0) {}
-
-JsonArrIterator::~JsonArrIterator() {}
-
-bool JsonArrIterator::hasNext() { return this->index < this->arr.size(); }
-
-QJsonValue JsonArrIterator::peekNext() { return this->arr.at(this->index); }
-
-void JsonArrIterator::rmNext() { this->index++; }
-
-QJsonValue JsonArrIterator::next() { return this->arr.at(this->index++); }
-
-QString JsonArrIterator::getKey() { return this->key; }
-
 /* DataRecorder */
-DataRecorder::DataRecorder() : replay_start_time(), replay_its() {}
+DataRecorder::DataRecorder() : replay_start_time(), replay_cursors() {}
 
-DataRecorder::~DataRecorder() {
-	for (auto it : this->replay_its) {
-		delete it;
-	}
-	if (this->obj) {
-		delete this->obj;
-	}
-}
+DataRecorder::~DataRecorder() { this->clearReplay(); }
 
 RecorderState DataRecorder::getState() const { return this->state; }
 
@@ -74,15 +51,23 @@ bool DataRecorder::startRecording() {
 	if (state != RecorderStateIdle) {
 		return false;
 	}
-	state = RecorderStateRecording;
 
-	if (this->obj) {
-		delete this->obj;
+	const QString date = QDateTime().currentDateTime().toString("yyyy-MM-dd_hh-mm-ss");
+	// create ./recording folder
+	QDir dir = QDir::current();
+	if (!dir.exists("recordings")) {
+		dir.mkdir("recordings");
+	}
+	dir.cd("recordings");
+	const QString path = dir.filePath(QString("recording_%1.%2").arg(date, RECORDING_FILE_SUFFIX));
+	if (!this->writer.open(path, QDateTime::currentMSecsSinceEpoch())) {
+		showInfoBox("Failed to create recording file");
+		return false;
 	}
-	this->obj = new QJsonObject();
-	this->obj->insert("init_time", QDateTime::currentMSecsSinceEpoch());
+	state = RecorderStateRecording;
 
-	qDebug() << "start recording";
+	const qint64 spilled = this->pretrigger.spill(this->writer);
+	qDebug() << "start recording," << spilled << "pre-trigger samples";
 
 	return true;
 }
@@ -94,54 +79,25 @@ bool DataRecorder::stopRecording() {
 	}
 	state = RecorderStateIdle;
 
-	QJsonDocument doc(*this->obj);
-	const QString date = QDateTime().currentDateTime().toString("yyyy-MM-dd_hh-mm-ss");
-	// create ./recording folder
-	QDir dir = QDir::current();
-	if (!dir.exists("recordings")) {
-		dir.mkdir("recordings");
-	}
-	dir.cd("recordings");
-	QFile file(dir.filePath(QString("recording_%1.json").arg(date)));
-	if (!file.open(QIODevice::WriteOnly)) {
-		qWarning() << "Couldn't open recording file";
-		delete this->obj;
-		this->obj = nullptr;
-
+	if (!this->writer.close()) {
 		showInfoBox("Failed to save recording file");
 		return true;
 	}
-	file.write(doc.toJson());
-	file.close();
-	delete this->obj;
-	this->obj = nullptr;
 
 	showInfoBox("Recording saved");
 	return true;
 }
 
+void DataRecorder::setPretrigger(qint64 window_ms, int max_sample_rate) {
+	this->pretrigger.configure(window_ms, window_ms * max_sample_rate / 1000);
+}
+
 void DataRecorder::dataRecord(QString key, qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z) {
-	if (state != RecorderStateRecording) {
-		return;
-	}
-	// qDebug() << "data record called";
-	QJsonArray data = {timestamp, T, X, Y, Z};
-	if (!this->obj->contains(key)) {
-		QJsonArray arr;
-		this->obj->insert(key, arr);
+	switch (state) {
+		case RecorderStateRecording: this->writer.append(key, timestamp, T, X, Y, Z); break;
+		case RecorderStateIdle: this->pretrigger.push(key, timestamp, T, X, Y, Z); break;
+		default: break;
 	}
-	QJsonValueRef arr_ref = (*this->obj)[key];
-	QJsonArray arr = arr_ref.toArray();
-	arr.append(data);
-	arr_ref = arr;
-	// QJsonDocument doc1(arr);
-	// qDebug() << "arr: " << doc1.toJson();
-
-
-	// qDebug() << "Data recorded: " << key << " " << timestamp << " " << T << " " << X << " " << Y << " " << Z;
-
-	// QJsonDocument doc(*this->obj);
-	// qDebug() << "obj: " << doc.toJson();
 }
 
 bool DataRecorder::startReplaying(QString path) {
@@ -149,94 +105,47 @@ bool DataRecorder::startReplaying(QString path) {
 	if (state != RecorderStateIdle) {
 		return false;
 	}
+	this->pretrigger.clear();
 
-	QFile file(path);
-	if (!file.open(QIODevice::ReadOnly)) {
-		qWarning() << "Couldn't open recording file";
-		showInfoBox("Failed to open recording file");
+	this->clearReplay();
+	QString error;
+	if (!loadRecordingCursors(path, this->reader, this->replay_columns, this->replay_cursors, error)) {
+		qWarning() << "Failed to load recording: " << error;
+		showInfoBox("Failed to load recording: " + error);
+		this->clearReplay();
 		return false;
 	}
 
-	QJsonParseError error;
-	QJsonDocument doc = QJsonDocument::fromJson(file.readAll(), &error);
-	if (error.error != QJsonParseError::NoError) {
-		qWarning() << "Couldn't parse recording file";
-		showInfoBox("Failed to parse recording file");
-		return false;
-	}
-
-	QJsonObject new_obj = doc.object();
-	// if (!new_obj.contains("init_time")) {
-	// 	qWarning() << "Invalid recording file: no init_time";
-	// 	showInfoBox("Invalid recording file: no init_time");
-	// 	return false;
-	// }
-
-	for (auto key : new_obj.keys()) {
-		if (key == "init_time") {
-			// if (!new_obj.value(key).isDouble()) {
-			// 	qWarning() << "Invalid recording file: init_time not number";
-			// 	showInfoBox("Invalid recording file: init_time not number");
-			// 	return false;
-			// }
-			continue;
-		}
-		if (!new_obj.value(key).isArray()) {
-			qWarning() << "Invalid recording file: data not array";
-			showInfoBox("Invalid recording file: data not array");
-			return false;
-		}
-		if (new_obj.value(key).toArray().size() == 0) {
-			qWarning() << "Invalid recording file: data empty";
-			showInfoBox("Invalid recording file: data empty");
-			return false;
-		}
-		for (auto data : new_obj.value(key).toArray()) {
-			if (!data.isArray() || data.toArray().size() != 5) {
-				qWarning() << "Invalid recording file: data not array or size not 5";
-				showInfoBox("Invalid recording file: data not array or size not 5");
-				return false;
-			}
-			for (auto val : data.toArray()) {
-				if (!val.isDouble()) {
-					qWarning() << "Invalid recording file: value not number";
-					showInfoBox("Invalid recording file: value not number");
-					return false;
-				}
-			}
+	qint64 data_start_time = 0;
+	bool has_data = false;
+	for (auto cursor : this->replay_cursors) {
+		if (cursor->hasNext() && (!has_data || cursor->peekTimestamp() < data_start_time)) {
+			data_start_time = cursor->peekTimestamp();
+			has_data = true;
 		}
 	}
+	this->startReplayThread(data_start_time);
 
-	// setup replay
-	for (auto it : this->replay_its) {
-		delete it;
-	}
-	this->replay_its.clear();
-	if (this->obj) {
-		delete this->obj;
+	state = RecorderStateReplaying;
+	qDebug() << "start replay";
+	return true;
+}
+
+void DataRecorder::clearReplay() {
+	for (auto cursor : this->replay_cursors) {
+		delete cursor;
 	}
-	this->obj = new QJsonObject(new_obj);
-	for (auto key : this->obj->keys()) {
-		if (key == "init_time") {
-			continue;
-		}
-		this->replay_its.append(new JsonArrIterator(key, this->obj->value(key).toArray()));
+	this->replay_cursors.clear();
+	for (auto columns : this->replay_columns) {
+		delete columns;
 	}
+	this->replay_columns.clear();
+	this->reader.close();
+}
 
+void DataRecorder::startReplayThread(qint64 data_start_time) {
 	this->replay_start_time = QDateTime::currentDateTime();
-	// this->replay_data_start_time = QDateTime::fromMSecsSinceEpoch(this->obj->value("init_time").toInt());
-	this->replay_data_start_time = QDateTime::fromMSecsSinceEpoch(0);
-	for (auto it : this->replay_its) {
-		if (it->hasNext()) {
-			QJsonArray data = it->peekNext().toArray();
-			QDateTime data_time = QDateTime::fromMSecsSinceEpoch(data.at(0).toInt());
-			if (this->replay_data_start_time == QDateTime::fromMSecsSinceEpoch(0)
-				|| this->replay_data_start_time > data_time) {
-				this->replay_data_start_time = data_time;
-			}
-			break;
-		}
-	}
+	this->replay_data_start_time = QDateTime::fromMSecsSinceEpoch(data_start_time);
 	this->replay_started_do_once = true;
 	this->replay_finished_do_once = true;
 
@@ -249,10 +158,6 @@ bool DataRecorder::startReplaying(QString path) {
 	connect(this, &DataRecorder::replayStop, this->replay_thread, &DataReplayThread::end);
 	connect(this->replay_thread, &DataReplayThread::finished, this, &DataRecorder::deleteReplayThread);
 	this->replay_thread->start();
-
-	state = RecorderStateReplaying;
-	qDebug() << "start replay";
-	return true;
 }
 
 bool DataRecorder::stopReplaying() {
@@ -262,8 +167,7 @@ bool DataRecorder::stopReplaying() {
 	}
 	state = RecorderStateIdle;
 	emit replayStop();
-	delete this->obj;
-	this->obj = nullptr;
+	this->clearReplay();
 	return true;
 }
 
@@ -277,21 +181,18 @@ void DataRecorder::replayData() {
 	}
 
 	const qint64 time_elapsed = this->replay_start_time.msecsTo(QDateTime::currentDateTime());
+	const qint64 data_start_time = this->replay_data_start_time.toMSecsSinceEpoch();
 	// qDebug() << "time_elapsed: " << time_elapsed;
 	bool all_end = true;
-	for (auto it : this->replay_its) {
-		if (it->hasNext()) {
+	qint64 timestamp;
+	int16_t T, X, Y, Z;
+	for (auto cursor : this->replay_cursors) {
+		while (cursor->hasNext() && cursor->peekTimestamp() - data_start_time <= time_elapsed) {
+			cursor->next(timestamp, T, X, Y, Z);
+			emit playbackData(cursor->getKey(), timestamp, T, X, Y, Z);
+		}
+		if (cursor->hasNext()) {
 			all_end = false;
-			QJsonArray data = it->peekNext().toArray();
-			// qDebug() << "data_elapse: "
-			// 		 << this->replay_data_start_time.msecsTo(QDateTime::fromMSecsSinceEpoch(data.at(0).toInt()));
-			if (this->replay_data_start_time.msecsTo(QDateTime::fromMSecsSinceEpoch(data.at(0).toInt()))
-				> time_elapsed) {
-				break;
-			}
-			it->rmNext();
-			emit playbackData(it->getKey(), data.at(0).toInt(), data.at(1).toInt(), data.at(2).toInt(),
-							  data.at(3).toInt(), data.at(4).toInt());
 		}
 	}
 	if (all_end && this->replay_finished_do_once) {
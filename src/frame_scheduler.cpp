@@ -0,0 +1,125 @@
+#include "frame_scheduler.hpp"
+
+#include <QEvent>
+#include <QScreen>
+#include <QtMinMax>
+
+
+FrameScheduler::FrameScheduler(QWidget* widget_, QObject* parent)
+	: QObject(parent), widget(widget_), pace_timer(new QTimer(this)) {
+	this->pace_timer->setSingleShot(true);
+	this->pace_timer->setTimerType(Qt::PreciseTimer);
+	connect(this->pace_timer, &QTimer::timeout, this, &FrameScheduler::requestFrame);
+	this->clock.start();
+}
+
+FrameScheduler::~FrameScheduler() {
+	if (this->window) {
+		this->window->removeEventFilter(this);
+	}
+}
+
+void FrameScheduler::setTargetFps(int fps) { this->target_fps = qBound(1, fps, 1000); }
+
+int FrameScheduler::targetFps() const { return this->target_fps; }
+
+void FrameScheduler::markDirty(FrameView view) {
+	if (this->dirty_views == 0) {
+		this->dirty_since_ns = this->clock.nsecsElapsed();
+	}
+	this->dirty_views |= 1 << view;
+	this->scheduleFrame();
+}
+
+bool FrameScheduler::eventFilter(QObject* object, QEvent* event) {
+	// the window still handles the event afterwards, so whatever the frame changed is painted in the same pass
+	if (event->type() == QEvent::UpdateRequest && object == this->window && this->frame_requested) {
+		this->runFrame();
+	}
+	return QObject::eventFilter(object, event);
+}
+
+/* private */
+void FrameScheduler::requestFrame() {
+	this->attachWindow();
+	if (!this->window || !this->window->isExposed()) {
+		// not shown or minimized, no update request would arrive, keep the views in sync at the paced rate
+		this->runFrame();
+		return;
+	}
+	this->frame_requested = true;
+	this->window->requestUpdate();
+}
+
+qint64 FrameScheduler::frameIntervalNs() const {
+	qreal refresh_rate = FRAME_FALLBACK_REFRESH_RATE;
+	if (this->widget->screen() && this->widget->screen()->refreshRate() > 0) {
+		refresh_rate = this->widget->screen()->refreshRate();
+	}
+	return 1000000000.0 / qMin<qreal>(this->target_fps, refresh_rate);
+}
+
+void FrameScheduler::attachWindow() {
+	if (this->window) {
+		return;
+	}
+	this->window = this->widget->window()->windowHandle();
+	if (this->window) {
+		this->window->installEventFilter(this);
+	}
+}
+
+void FrameScheduler::scheduleFrame() {
+	if (this->frame_requested || this->pace_timer->isActive()) {
+		return;
+	}
+	// a quarter interval early is fine, the update request itself waits for the next refresh
+	const qint64 interval = this->frameIntervalNs();
+	const qint64 wait_ns = this->last_frame_ns + interval - interval / 4 - this->clock.nsecsElapsed();
+	if (wait_ns > 0) {
+		this->pace_timer->start(qMax<qint64>(1, wait_ns / 1000000));
+	} else {
+		this->requestFrame();
+	}
+}
+
+void FrameScheduler::runFrame() {
+	this->frame_requested = false;
+	const int views = this->dirty_views;
+	if (views == 0) {
+		return;
+	}
+	this->dirty_views = 0;
+
+	const qint64 interval = this->frameIntervalNs();
+	const qint64 start_ns = this->clock.nsecsElapsed();
+	const qint64 due_ns = qMax(this->dirty_since_ns, this->last_frame_ns + interval);
+	if (start_ns - due_ns > interval) {
+		this->stats_missed += (start_ns - due_ns) / interval;
+	}
+	this->last_frame_ns = start_ns;
+
+	emit sig_frame(views);
+
+	const qint64 end_ns = this->clock.nsecsElapsed();
+	const qint64 frame_ns = end_ns - start_ns;
+	this->stats_frames++;
+	this->stats_total_ns += frame_ns;
+	this->stats_max_ns = qMax(this->stats_max_ns, frame_ns);
+	if (end_ns - this->stats_start_ns >= (qint64)FRAME_STATS_INTERVAL_MS * 1000000) {
+		FrameStats stats;
+		stats.frames = this->stats_frames;
+		stats.missed = this->stats_missed;
+		stats.fps = this->stats_frames * 1e9 / (end_ns - this->stats_start_ns);
+		stats.avg_frame_ms = this->stats_total_ns / 1e6 / this->stats_frames;
+		stats.max_frame_ms = this->stats_max_ns / 1e6;
+		emit sig_stats(stats);
+		this->stats_start_ns = end_ns;
+		this->stats_frames = this->stats_missed = 0;
+		this->stats_total_ns = this->stats_max_ns = 0;
+	}
+
+	if (this->dirty_views != 0) { // marked while the frame ran
+		this->scheduleFrame();
+	}
+}
@@ -0,0 +1,365 @@
+#include "graphics_renderer.hpp"
+
+#include "sensor_pipeline.hpp"
+
+#include <QtMath>
+#include <QtMinMax>
+#include <algorithm>
+#include <climits>
+#include <cstring>
+
+
+GraphicsRendererConfig loadGraphicsRendererConfig(Settings* settings) {
+	GraphicsRendererConfig config;
+	config.blur_radius = 0;
+	config.colormap = HEATMAP_COLORMAP_YELLOW_RED;
+	config.temporal = HEATMAP_TEMPORAL_NONE;
+	config.tau_ms = HEATMAP_TEMPORAL_DEFAULT_TAU;
+	config.hold_ms = HEATMAP_TEMPORAL_DEFAULT_HOLD;
+	config.field = HEATMAP_FIELD_OFF;
+	config.field_radius = HEATMAP_FIELD_DEFAULT_RADIUS;
+	config.field_power = HEATMAP_FIELD_DEFAULT_POWER;
+	config.cop_trail_length = COP_DEFAULT_TRAIL_LENGTH;
+	if (!settings) {
+		return config;
+	}
+
+	if (settings->contains("heatmap_blur_radius")) {
+		config.blur_radius = qMax(0, settings->get("heatmap_blur_radius").toInt());
+	}
+	if (settings->contains("heatmap_colormap")) {
+		config.colormap = heatmapColormapFromString(settings->get("heatmap_colormap").toString());
+	}
+	if (settings->contains("heatmap_temporal")) {
+		config.temporal = heatmapTemporalFromString(settings->get("heatmap_temporal").toString());
+	}
+	if (settings->contains("heatmap_tau_ms")) {
+		config.tau_ms = settings->get("heatmap_tau_ms").toDouble();
+	}
+	if (settings->contains("heatmap_hold_ms")) {
+		config.hold_ms = settings->get("heatmap_hold_ms").toDouble();
+	}
+	if (settings->contains("heatmap_field")) {
+		config.field = heatmapFieldFromString(settings->get("heatmap_field").toString());
+	}
+	if (settings->contains("heatmap_field_radius")) {
+		config.field_radius = settings->get("heatmap_field_radius").toDouble();
+	}
+	if (settings->contains("heatmap_field_power")) {
+		config.field_power = settings->get("heatmap_field_power").toDouble();
+	}
+	if (settings->contains("cop_trail_length")) {
+		config.cop_trail_length = qMax(0, settings->get("cop_trail_length").toInt());
+	}
+	return config;
+}
+
+void graphicsArrowHead(const QLineF& line, QPointF head[3], QColor& color) {
+	static const qreal arrowSize = 10;
+	// distance of the head centroid from the tip, where the gradient is sampled
+	static const qreal headCenter = arrowSize * qCos(M_PI / 6) * 2 / 3;
+
+	const qreal angle = std::atan2(line.dy(), line.dx());
+	head[0] = line.p2();
+	head[1] = line.p2() - QPointF(qCos(angle + M_PI / 6) * arrowSize, qSin(angle + M_PI / 6) * arrowSize);
+	head[2] = line.p2() - QPointF(qCos(angle - M_PI / 6) * arrowSize, qSin(angle - M_PI / 6) * arrowSize);
+
+	const qreal length = line.length();
+	const qreal t = length > 0 ? qBound(0.0, (length - headCenter) / length, 1.0) : 1.0;
+	const int gray = qRound(255 * (1 - t));
+	color = QColor(gray, gray, gray);
+}
+
+HeatmapManager::HeatmapManager(int width, int height, int cellSize, int radiation_decay)
+	: m_grid(width, height, cellSize, radiation_decay),
+	  m_image(m_grid.columns(), m_grid.rows(), QImage::Format_ARGB32_Premultiplied) {
+	syncImage(QRect(0, 0, m_grid.columns(), m_grid.rows()), true);
+}
+
+HeatmapManager::~HeatmapManager() {}
+
+void HeatmapManager::setCellScalar(int xPos, int yPos, const int scalar) {
+	m_grid.setCellScalar(xPos, yPos, scalar);
+	syncImage(m_grid.takeDirtyCells());
+}
+
+void HeatmapManager::setCellScalarBatch(const std::vector<std::tuple<int, int, int>>& cells, qint64 dt_ms) {
+	m_grid.setCellScalarBatch(cells, dt_ms);
+	syncImage(m_grid.takeDirtyCells());
+}
+
+void HeatmapManager::syncImage(const QRect& cells, bool force) {
+	const int stride = m_grid.columns();
+	const int* next = m_grid.cells(HEATMAP_FRAME_NEXT);
+	int* current = m_grid.cells(HEATMAP_FRAME_CURRENT);
+	const uint32_t* colormap = HEATMAP_COLORMAP_TABLES[m_colormap].data();
+	int left = INT_MAX, top = INT_MAX, right = -1, bottom = -1; // bounding box of the changed cells
+	for (int j = cells.top(); j <= cells.bottom(); ++j) {
+		// span of changed cells in this row, converted in one pass
+		const int* next_row = next + j * stride;
+		int* current_row = current + j * stride;
+		int first = cells.left(), last = cells.right();
+		if (!force) {
+			while (first <= last && next_row[first] == current_row[first]) {
+				first++;
+			}
+			while (last >= first && next_row[last] == current_row[last]) {
+				last--;
+			}
+		}
+		if (first > last) {
+			continue;
+		}
+		heatmapColormapApply(colormap, next_row + first, (uint32_t*)m_image.scanLine(j) + first, last - first + 1);
+		std::copy(next_row + first, next_row + last + 1, current_row + first);
+		left = qMin(left, first);
+		right = qMax(right, last);
+		top = qMin(top, j);
+		bottom = qMax(bottom, j);
+	}
+	if (right >= 0) {
+		m_dirty |= QRect(QPoint(left, top), QPoint(right, bottom));
+	}
+}
+
+void HeatmapManager::clear() {
+	m_grid.clear();
+	syncImage(m_grid.takeDirtyCells());
+}
+
+void HeatmapManager::setBlurRadius(int radius) { m_grid.setBlurRadius(radius); }
+
+void HeatmapManager::setTemporal(HeatmapTemporal mode, qreal tau_ms, qreal hold_ms) {
+	m_grid.setTemporal(mode, tau_ms, hold_ms);
+}
+
+bool HeatmapManager::isSettling() const { return m_grid.isSettling(); }
+
+void HeatmapManager::setColormap(HeatmapColormap colormap) {
+	m_colormap = colormap;
+	syncImage(QRect(0, 0, m_grid.columns(), m_grid.rows()), true);
+}
+
+void HeatmapManager::buildField(HeatmapFieldMethod method, const std::vector<HeatmapFieldSensor>& sensors,
+								qreal radius, qreal power) {
+	m_grid.buildField(method, sensors, radius, power);
+}
+
+void HeatmapManager::setFieldValues(const std::vector<int>& values, qint64 dt_ms) {
+	m_grid.setFieldValues(values, dt_ms);
+	syncImage(m_grid.takeDirtyCells());
+}
+
+int HeatmapManager::cellSize() const { return m_grid.cellSize(); }
+
+int HeatmapManager::width() const { return m_grid.width(); }
+
+int HeatmapManager::height() const { return m_grid.height(); }
+
+const QImage& HeatmapManager::image() const { return m_image; }
+
+QRect HeatmapManager::takeDirtyImage() {
+	QRect dirty = m_dirty;
+	m_dirty = QRect();
+	return dirty;
+}
+
+GraphicsRenderer::GraphicsRenderer(int width, int height, int cellSize, int radiation_decay)
+	: m_heatmap(width, height, cellSize, radiation_decay) {
+	m_cop.setTrailLength(m_cop_trail_length);
+}
+
+GraphicsRenderer::~GraphicsRenderer() {}
+
+int GraphicsRenderer::sceneX(int x, bool is_left) const { return sensorSceneX(x, is_left, m_heatmap.width()); }
+
+void GraphicsRenderer::addSensor(const QString& name, int x, int y, int x_to, int y_to, bool is_left) {
+	x = sceneX(x, is_left);
+	x_to = sceneX(x_to, is_left);
+
+	m_heatmap.setCellScalar(x, y, 1);
+	m_sensors.insert(name, {QLineF(x, y, x_to, y_to), 1, x, y, is_left});
+	m_field_stale = true;
+}
+
+void GraphicsRenderer::removeSensor(const QString& name) {
+	auto it = m_sensors.find(name);
+	if (it == m_sensors.end())
+		return;
+
+	m_heatmap.setCellScalar(it->x, it->y, 0);
+	m_sensors.erase(it);
+	m_field_stale = true;
+}
+
+void GraphicsRenderer::setSensorPos(const QString& name, int x, int y, bool is_left, bool need_flip_arrow) {
+	auto it = m_sensors.find(name);
+	if (it == m_sensors.end())
+		return;
+
+	x = sceneX(x, is_left);
+
+	Sensor& sensor = it.value();
+	m_heatmap.setCellScalar(sensor.x, sensor.y, 0);
+
+	int cellSize = m_heatmap.cellSize();
+	int newX = x / cellSize * cellSize + cellSize / 2;
+	int newY = y / cellSize * cellSize + cellSize / 2;
+
+	m_heatmap.setCellScalar(newX, newY, sensor.scalar);
+	sensor.x = x;
+	sensor.y = y;
+	sensor.is_left = is_left;
+	m_field_stale = true;
+
+	qreal dx = sensor.arrow.dx();
+	qreal dy = sensor.arrow.dy();
+	if (need_flip_arrow)
+		sensor.arrow = QLineF(newX, newY, newX - dx, newY - dy);
+	else
+		sensor.arrow = QLineF(newX, newY, newX + dx, newY + dy);
+}
+
+void GraphicsRenderer::setArrowPointingTo(const QString& name, int x, int y) {
+	auto it = m_sensors.find(name);
+	if (it == m_sensors.end())
+		return;
+
+	it->arrow = QLineF(it->x, it->y, x, y);
+}
+
+void GraphicsRenderer::setArrowRot90(const QString& name, int num_of_90) {
+	auto it = m_sensors.find(name);
+	if (it == m_sensors.end())
+		return;
+
+	it->arrow.setAngle(it->arrow.angle() - num_of_90 * 90);
+}
+
+void GraphicsRenderer::clear() {
+	m_sensors.clear();
+	m_heatmap.clear();
+	m_cop.clear();
+	m_field_stale = true;
+}
+
+void GraphicsRenderer::setConfig(const GraphicsRendererConfig& config) {
+	setHeatmapBlurRadius(config.blur_radius);
+	setHeatmapColormap(config.colormap);
+	setHeatmapTemporal(config.temporal, config.tau_ms, config.hold_ms);
+	setHeatmapField(config.field, config.field_radius, config.field_power);
+	setCopTrailLength(config.cop_trail_length);
+}
+
+void GraphicsRenderer::setHeatmapBlurRadius(int radius) { m_heatmap.setBlurRadius(radius); }
+
+void GraphicsRenderer::setHeatmapColormap(HeatmapColormap colormap) { m_heatmap.setColormap(colormap); }
+
+void GraphicsRenderer::setHeatmapTemporal(HeatmapTemporal mode, qreal tau_ms, qreal hold_ms) {
+	m_heatmap_temporal = mode;
+	m_heatmap.setTemporal(mode, tau_ms, hold_ms);
+}
+
+void GraphicsRenderer::setHeatmapField(HeatmapFieldMethod method, qreal radius, qreal power) {
+	m_field_method = method;
+	m_field_radius = radius;
+	m_field_power = power;
+	m_field_stale = true;
+}
+
+void GraphicsRenderer::setCopTrailLength(int frames) {
+	m_cop_trail_length = qMax(0, frames);
+	if (m_cop_trail_length > 0) {
+		m_cop.setTrailLength(m_cop_trail_length);
+	} else {
+		m_cop.clear();
+	}
+}
+
+void GraphicsRenderer::rebuildField() {
+	std::vector<HeatmapFieldSensor> sensors;
+	m_field_keys = m_sensors.keys();
+	for (const QString& key : m_field_keys) {
+		const Sensor& sensor = m_sensors[key];
+		sensors.push_back({sensor.x, sensor.y, sensor.is_left ? 0 : 1});
+	}
+	m_heatmap.buildField(m_field_method, sensors, m_field_radius, m_field_power);
+	m_field_stale = false;
+}
+
+void GraphicsRenderer::process(const std::vector<GraphicsSample>& samples, qint64 dt_ms) {
+	m_batch_cells.clear();
+	m_cop.begin();
+	for (const GraphicsSample& sample : samples) {
+		auto it = m_sensors.find(sample.name);
+		if (it == m_sensors.end())
+			continue;
+
+		Sensor& sensor = it.value();
+		qreal dx = qBound(-1.0, sample.x, 1.0) * GRAPHICS_ARROW_LENGTH;
+		qreal dy = qBound(-1.0, sample.y, 1.0) * GRAPHICS_ARROW_LENGTH;
+		sensor.arrow = QLineF(sensor.x, sensor.y, sensor.x + dx, sensor.y + dy);
+		sensor.scalar = qBound(0.0, sample.z, 1.0) * HEATMAP_SCALAR_MAX;
+		m_batch_cells.emplace_back(sensor.x, sensor.y, sensor.scalar);
+		m_cop.add(sensor.is_left ? COP_FOOT_LEFT : COP_FOOT_RIGHT, sensor.x, sensor.y, sensor.scalar);
+	}
+	// a frame without samples still ends the stroke, the feet lose their weight and the dot goes away
+	if (m_cop_trail_length > 0) {
+		m_cop.end();
+	}
+	if (m_field_method != HEATMAP_FIELD_OFF) {
+		// weights only change with the sensor positions, a frame is one sparse matrix times the sensor values
+		if (m_field_stale) {
+			rebuildField();
+		} else if (samples.empty() && !m_heatmap.isSettling()
+			&& std::all_of(m_field_values.begin(), m_field_values.end(), [](int value) { return value == 0; })) {
+			// nothing arrived and the field already rests at 0, evaluating it again would give the same cells
+			return;
+		}
+		// like an empty batch of blobs, a frame without any sample lets the field fall back to 0, otherwise the
+		// temporal accumulation would chase the last values forever and never settle
+		m_field_values.resize(m_field_keys.size());
+		for (int i = 0; i < m_field_keys.size(); i++) {
+			Sensor& sensor = m_sensors[m_field_keys[i]];
+			if (samples.empty()) {
+				sensor.scalar = 0;
+			}
+			m_field_values[i] = sensor.scalar;
+		}
+		m_heatmap.setFieldValues(m_field_values, dt_ms);
+		return;
+	}
+	// with temporal accumulation an empty batch still lets the map decay
+	if (!m_batch_cells.empty() || m_heatmap_temporal != HEATMAP_TEMPORAL_NONE) {
+		m_heatmap.setCellScalarBatch(m_batch_cells, dt_ms);
+	}
+}
+
+void GraphicsRenderer::snapshot(GraphicsFrame& frame) {
+	const QImage& image = m_heatmap.image();
+	if (frame.heatmap.size() != image.size()) {
+		frame.heatmap = QImage(image.size(), image.format());
+	}
+	// a few ten kB of cells, a plain copy keeps every buffer of the handoff complete
+	std::memcpy(frame.heatmap.bits(), image.constBits(), image.sizeInBytes());
+	frame.dirty = m_heatmap.takeDirtyImage();
+
+	frame.arrows.clear();
+	for (const Sensor& sensor : m_sensors) {
+		frame.arrows.push_back(sensor.arrow);
+	}
+	for (int foot = 0; foot < NUM_OF_COP_FOOT; foot++) {
+		const CopTrajectory& trajectory = m_cop.trajectory((CopFoot)foot);
+		frame.cop[foot].assign(trajectory.data(), trajectory.data() + trajectory.size());
+		frame.cop_valid[foot] = m_cop_trail_length > 0 && m_cop.isValid((CopFoot)foot);
+	}
+}
+
+bool GraphicsRenderer::isSettling() const {
+	// a shown dot needs one more frame to be ended once the data stops
+	return m_heatmap.isSettling() || m_cop.isValid(COP_FOOT_LEFT) || m_cop.isValid(COP_FOOT_RIGHT);
+}
+
+int GraphicsRenderer::width() const { return m_heatmap.width(); }
+
+int GraphicsRenderer::height() const { return m_heatmap.height(); }
@@ -1,167 +1,143 @@
 #include "graphicsview.hpp"
 
 #include <QGraphicsItem>
-#include <QLinearGradient>
 #include <QPainter>
 #include <QPen>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+#include <QtNumeric>
 #include <qobjectdefs.h>
 
 
-ArrowItem::ArrowItem(QLineF line) : m_startColor(Qt::white), m_endColor(Qt::black) {
-	m_lineItem = new QGraphicsLineItem(line);
-	m_arrowHead = new QGraphicsPolygonItem();
-	updateArrowHead();
-	m_lineItem->setPen(QPen(QBrush(Qt::black), 2));
-}
-
-ArrowItem::~ArrowItem() {
-	delete m_lineItem;
-	delete m_arrowHead;
-}
+SensorOverlayItem::SensorOverlayItem() : m_pen(QBrush(Qt::black), 2) {}
 
-void ArrowItem::updateArrowHead() {
-	QLineF l = line();
-	static const qreal arrowSize = 10;
-	double angle = std::atan2(l.dy(), l.dx());
+SensorOverlayItem::~SensorOverlayItem() {}
 
-	QPointF arrowP1 = l.p2() - QPointF(cos(angle + M_PI / 6) * arrowSize, sin(angle + M_PI / 6) * arrowSize);
-	QPointF arrowP2 = l.p2() - QPointF(cos(angle - M_PI / 6) * arrowSize, sin(angle - M_PI / 6) * arrowSize);
-
-	QPolygonF arrowHead;
-	arrowHead << l.p2() << arrowP1 << arrowP2;
-	m_arrowHead->setPolygon(arrowHead);
-
-	QLinearGradient gradient(l.p1(), l.p2());
-	gradient.setColorAt(0, m_startColor);
-	gradient.setColorAt(1, m_endColor);
-	m_arrowHead->setBrush(gradient);
-}
+QRectF SensorOverlayItem::boundingRect() const { return m_bounds; }
 
-void ArrowItem::updateColor(QColor startColor, QColor endColor) {
-	m_startColor = startColor;
-	m_endColor = endColor;
-	updateArrowHead();
-}
-
-void ArrowItem::setLine(const QLineF line) {
-	m_lineItem->setLine(line);
-	updateArrowHead();
+void SensorOverlayItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+	Q_UNUSED(option);
+	Q_UNUSED(widget);
+	if (m_lines.empty()) {
+		return;
+	}
+	painter->setPen(m_pen);
+	painter->drawLines(m_lines.data(), (int)m_lines.size());
+	painter->setPen(Qt::NoPen);
+	for (size_t i = 0; i < m_lines.size(); i++) {
+		painter->setBrush(m_head_colors[i]);
+		painter->drawPolygon(m_heads.data() + 3 * i, 3);
+	}
 }
 
-HeatmapManager::HeatmapManager(int width, int height, int cellSize, int radiation_decay)
-	: m_width(width), m_height(height), m_cellSize(cellSize), m_radiation_decay(radiation_decay) {
-	const int cellWidth = width / cellSize;
-	const int cellHeight = height / cellSize;
-	for (int idx = 0; idx < 2; idx++) {
-		m_cellScalars[idx] = new int*[cellWidth];
-		for (int i = 0; i < cellWidth; ++i) {
-			m_cellScalars[idx][i] = new int[cellHeight]();
-		}
+void SensorOverlayItem::setArrows(const std::vector<QLineF>& arrows) {
+	if (arrows == m_lines) {
+		return;
 	}
-	for (int i = 0; i < cellWidth; ++i) {
-		for (int j = 0; j < cellHeight; ++j) {
-			m_cellScalars[HEATMAP_FRAME_NEXT][i][j] = 0;
-			m_cellScalars[HEATMAP_FRAME_CURRENT][i][j] = -1;
+	m_lines = arrows;
+	m_heads.resize(3 * m_lines.size());
+	m_head_colors.resize(m_lines.size());
+	qreal left = qInf(), top = qInf(), right = -qInf(), bottom = -qInf();
+	for (size_t i = 0; i < m_lines.size(); i++) {
+		const QLineF& l = m_lines[i];
+		QPointF* head = m_heads.data() + 3 * i;
+		graphicsArrowHead(l, head, m_head_colors[i]);
+		for (const QPointF& point : {l.p1(), head[0], head[1], head[2]}) {
+			left = qMin(left, point.x());
+			right = qMax(right, point.x());
+			top = qMin(top, point.y());
+			bottom = qMax(bottom, point.y());
 		}
 	}
+	QRectF bounds;
+	if (right >= left) {
+		const qreal margin = m_pen.widthF();
+		bounds = QRectF(QPointF(left, top), QPointF(right, bottom)).adjusted(-margin, -margin, margin, margin);
+	}
+	if (bounds != m_bounds) {
+		prepareGeometryChange(); // repaints the old area
+		m_bounds = bounds;
+	}
+	update();
 }
 
-HeatmapManager::~HeatmapManager() {
-	for (int idx = 0; idx < 2; idx++) {
-		for (int i = 0; i < m_width / m_cellSize; ++i) {
-			delete[] m_cellScalars[idx][i];
-		}
-		delete[] m_cellScalars[idx];
-	}
+HeatmapFrameItem::HeatmapFrameItem(int width, int height, int cellSize)
+	: m_bounds(0, 0, width, height), m_cellSize(cellSize) {
+	setFlag(QGraphicsItem::ItemUsesExtendedStyleOption); // for option->exposedRect
+	m_pens[COP_FOOT_LEFT] = QPen(QColor(0x1f, 0x77, 0xb4), 2);
+	m_pens[COP_FOOT_RIGHT] = QPen(QColor(0x2c, 0xa0, 0x2c), 2);
 }
 
-QRectF HeatmapManager::boundingRect() const { return QRectF(0, 0, m_width, m_height); }
+HeatmapFrameItem::~HeatmapFrameItem() {}
 
-QColor HeatmapManager::cvtColor(const int scalar) const {
-	if (scalar <= 204) {
-		return QColor(255, 255, 204 - scalar);
-	} else {
-		return QColor(255, fmax(0, 255 - (scalar - 204)), 0);
-	}
-}
+QRectF HeatmapFrameItem::boundingRect() const { return m_bounds; }
 
-void HeatmapManager::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
-	painter->setRenderHint(QPainter::Antialiasing, false);
-	painter->setPen(Qt::NoPen);
-	painter->setBrush(Qt::NoBrush);
-	painter->setOpacity(0.5);
-	for (int i = 0; i < m_width / m_cellSize; ++i) {
-		for (int j = 0; j < m_height / m_cellSize; ++j) {
-			if (m_cellScalars[HEATMAP_FRAME_NEXT][i][j] == m_cellScalars[HEATMAP_FRAME_CURRENT][i][j]) {}
-			QColor color = cvtColor(m_cellScalars[HEATMAP_FRAME_NEXT][i][j]);
-			painter->setBrush(color);
-			painter->drawRect(i * m_cellSize, j * m_cellSize, m_cellSize, m_cellSize);
-			m_cellScalars[HEATMAP_FRAME_CURRENT][i][j] = m_cellScalars[HEATMAP_FRAME_NEXT][i][j];
+void HeatmapFrameItem::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget) {
+	Q_UNUSED(widget);
+	if (!m_frame) {
+		return;
+	}
+	// only the cells under the exposed area, which is the dirty area of the frame unless the view scrolled
+	const QRectF exposed = option->exposedRect;
+	const QRect source = QRect(QPoint(qFloor(exposed.left() / m_cellSize), qFloor(exposed.top() / m_cellSize)),
+							   QPoint(qCeil(exposed.right() / m_cellSize), qCeil(exposed.bottom() / m_cellSize)))
+							 .intersected(m_frame->heatmap.rect());
+	if (!source.isEmpty()) {
+		painter->setRenderHint(QPainter::SmoothPixmapTransform, false);
+		painter->drawImage(QRectF(source.x() * m_cellSize, source.y() * m_cellSize, source.width() * m_cellSize,
+								  source.height() * m_cellSize),
+						   m_frame->heatmap, source);
+	}
+	for (int foot = 0; foot < NUM_OF_COP_FOOT; foot++) {
+		const std::vector<QPointF>& trail = m_frame->cop[foot];
+		if (trail.empty()) {
+			continue;
+		}
+		painter->setPen(m_pens[foot]);
+		painter->setBrush(Qt::NoBrush);
+		painter->drawPolyline(trail.data(), (int)trail.size());
+		if (m_frame->cop_valid[foot]) {
+			painter->setBrush(m_pens[foot].color());
+			painter->drawEllipse(trail.back(), 4, 4);
 		}
 	}
 }
 
-void HeatmapManager::setCellScalar(int xPos, int yPos, const int scalar) {
-	int cellX = xPos / m_cellSize;
-	int cellY = yPos / m_cellSize;
-	if (cellX < 0 || cellX >= m_width / m_cellSize || cellY < 0 || cellY >= m_height / m_cellSize) {
+void HeatmapFrameItem::setFrame(const GraphicsFrame* frame) {
+	const bool first = !m_frame;
+	m_frame = frame;
+	if (first) {
+		update();
 		return;
 	}
-	QPair<int, int> cell(cellX, cellY);
-
-	// add new color
-	if (scalar > 0) {
-		m_cellScalars[HEATMAP_FRAME_NEXT][cellX][cellY] = scalar;
-		const int radiation_cell_num = scalar / m_radiation_decay;
-		for (int i = -radiation_cell_num; i <= radiation_cell_num; ++i) {
-			for (int j = -radiation_cell_num; j <= radiation_cell_num; ++j) {
-				if (i * i + j * j <= radiation_cell_num * radiation_cell_num) {
-					int newCellX = cellX + i;
-					int newCellY = cellY + j;
-					if (newCellX >= 0 && newCellX < m_width / m_cellSize && newCellY >= 0
-						&& newCellY < m_height / m_cellSize) {
-						m_cellScalars[HEATMAP_FRAME_NEXT][newCellX][newCellY] +=
-							scalar * (1 - qSqrt(i * i + j * j) / radiation_cell_num);
-					}
-				}
-			}
-		}
+	const QRect& dirty = frame->dirty;
+	if (!dirty.isEmpty()) {
+		update(dirty.x() * m_cellSize, dirty.y() * m_cellSize, dirty.width() * m_cellSize,
+			   dirty.height() * m_cellSize);
 	}
-
-	// update();
-}
-
-void HeatmapManager::setCellScalarBatch(const std::vector<std::tuple<int, int, int>>& cells) {
-	for (int i = 0; i < m_width / m_cellSize; ++i) {
-		for (int j = 0; j < m_height / m_cellSize; ++j) {
-			m_cellScalars[HEATMAP_FRAME_NEXT][i][j] = 0;
+	// the old trail has to be erased as well
+	qreal left = qInf(), top = qInf(), right = -qInf(), bottom = -qInf();
+	for (int foot = 0; foot < NUM_OF_COP_FOOT; foot++) {
+		for (const QPointF& point : frame->cop[foot]) {
+			left = qMin(left, point.x());
+			right = qMax(right, point.x());
+			top = qMin(top, point.y());
+			bottom = qMax(bottom, point.y());
 		}
 	}
-
-	for (const auto& cell : cells) {
-		int x = std::get<0>(cell);
-		int y = std::get<1>(cell);
-		int scalar = std::get<2>(cell);
-		setCellScalar(x, y, scalar);
+	QRectF trail_rect;
+	if (right >= left) {
+		trail_rect = QRectF(QPointF(left, top), QPointF(right, bottom)).adjusted(-6, -6, 6, 6);
 	}
-	update();
-}
-
-void HeatmapManager::clear() {
-	for (int i = 0; i < m_width / m_cellSize; ++i) {
-		for (int j = 0; j < m_height / m_cellSize; ++j) {
-			m_cellScalars[HEATMAP_FRAME_NEXT][i][j] = 0;
-		}
+	if (!trail_rect.isEmpty() || !m_trail_rect.isEmpty()) {
+		update(trail_rect | m_trail_rect);
 	}
+	m_trail_rect = trail_rect;
 }
 
-int HeatmapManager::cellSize() const { return m_cellSize; }
-
 GraphicsManager::GraphicsManager(QGraphicsView* view, QObject* parent)
-	: QObject(parent), m_view(view), m_thread(new QThread), m_heatmap(nullptr) {
-	m_thread->setObjectName("GraphicsManagerThread");
-	m_thread->start();
-	moveToThread(m_thread);
+	: QObject(parent), m_view(view), m_frame_item(nullptr), m_overlay_item(nullptr), m_thread(new QThread),
+	  m_render_context(new QObject) {
 	m_view->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 	m_view->setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
 	m_view->setViewport(new QOpenGLWidget());
@@ -170,11 +146,21 @@ GraphicsManager::GraphicsManager(QGraphicsView* view, QObject* parent)
 	m_scene->setBackgroundBrush(QBrush(QColor(0xf0, 0xf0, 0xf0)));
 	m_view->setScene(m_scene);
 	createBackground();
+
+	// from here on m_renderer, m_samples, m_frame_timer and m_back belong to the render thread
+	m_renderer = new GraphicsRenderer(m_width, m_height);
+	m_frame_timer.start();
+	m_thread->setObjectName("GraphicsRenderThread");
+	m_render_context->moveToThread(m_thread);
+	m_thread->start();
 }
 
 GraphicsManager::~GraphicsManager() {
-	clear();
-	delete m_heatmap;
+	m_thread->quit();
+	m_thread->wait();
+	delete m_render_context;
+	delete m_thread;
+	delete m_renderer;
 	delete m_scene;
 }
 
@@ -197,157 +183,116 @@ void GraphicsManager::createBackground() {
 	m_height = m_bgPixmap.height();
 	m_scene->addPixmap(m_bgPixmap)->setZValue(0);
 
-	m_heatmap = new HeatmapManager(m_width, m_height, 5, 50);
-	m_heatmap->setZValue(1);
-	m_scene->addItem(m_heatmap);
-}
+	m_frame_item = new HeatmapFrameItem(m_width, m_height, GRAPHICS_CELL_SIZE);
+	m_frame_item->setZValue(1);
+	m_scene->addItem(m_frame_item);
 
-void GraphicsManager::wrap_x(int& x, bool is_left) {
-	x = qBound(0, x, m_width / 2);
-	if (!is_left)
-		x = m_width - x;
+	m_overlay_item = new SensorOverlayItem();
+	m_overlay_item->setZValue(2);
+	m_scene->addItem(m_overlay_item);
 }
 
-void GraphicsManager::addSphereArrow(QString name, int x, int y, int x_to, int y_to, bool is_left) {
-	wrap_x(x, is_left);
-	wrap_x(x_to, is_left);
-
-	m_heatmap->setCellScalar(x, y, 1);
-	ArrowItem* arrow = new ArrowItem(QLineF(x, y, x_to, y_to));
-	arrow->arrowHead()->setZValue(2);
-	arrow->lineItem()->setZValue(2);
-	m_scene->addItem(arrow->arrowHead());
-	m_scene->addItem(arrow->lineItem());
-	m_objects.insert(name, std::make_tuple(arrow, 1, x, y, is_left));
+void GraphicsManager::post(std::function<void()> work) {
+	QMetaObject::invokeMethod(
+		m_render_context,
+		[this, work]() {
+			work();
+			publishFrame();
+		},
+		Qt::QueuedConnection);
 }
 
-void GraphicsManager::rmSphereArrow(QString name) {
-	if (!m_objects.contains(name))
+void GraphicsManager::submitSamples(const std::vector<GraphicsSample>& samples) {
+	QMutexLocker locker(&m_input_mutex);
+	m_pending.insert(m_pending.end(), samples.begin(), samples.end());
+	if (m_render_posted) {
 		return;
-
-	auto obj = m_objects.take(name);
-	ArrowItem* arrow = std::get<0>(obj);
-	int x = std::get<2>(obj);
-	int y = std::get<3>(obj);
-
-	m_heatmap->setCellScalar(x, y, 0);
-	m_scene->removeItem(arrow->arrowHead());
-	m_scene->removeItem(arrow->lineItem());
-	delete arrow;
+	}
+	// one queued call per frame, an empty batch still advances the temporal accumulation
+	m_render_posted = true;
+	QMetaObject::invokeMethod(m_render_context, [this]() { renderPending(); }, Qt::QueuedConnection);
 }
 
-void GraphicsManager::setSpherePos(QString name, int x, int y, bool is_left, bool need_flip_arrow) {
-	if (!m_objects.contains(name))
-		return;
-
-	wrap_x(x, is_left);
-
-	auto& obj = m_objects[name];
-	ArrowItem* arrow = std::get<0>(obj);
-	int scalar = std::get<1>(obj);
-	int oldX = std::get<2>(obj);
-	int oldY = std::get<3>(obj);
-	bool oldIsLeft = std::get<4>(obj);
-
-	m_heatmap->setCellScalar(oldX, oldY, 0);
-
-	int cellSize = m_heatmap->cellSize();
-	int newCellX = x / cellSize;
-	int newCellY = y / cellSize;
-	int newX = newCellX * cellSize + cellSize / 2;
-	int newY = newCellY * cellSize + cellSize / 2;
-
-	m_heatmap->setCellScalar(newX, newY, scalar);
-	std::get<2>(obj) = x;
-	std::get<3>(obj) = y;
-	std::get<4>(obj) = is_left;
-
-	QLineF line = arrow->line();
-	qreal dx = line.dx();
-	qreal dy = line.dy();
-
-	if (need_flip_arrow)
-		line = QLineF(newX, newY, newX - dx, newY - dy);
-	else
-		line = QLineF(newX, newY, newX + dx, newY + dy);
-
-	arrow->setLine(line);
+void GraphicsManager::renderPending() {
+	{
+		QMutexLocker locker(&m_input_mutex);
+		std::swap(m_pending, m_samples);
+		m_render_posted = false;
+	}
+	m_renderer->process(m_samples, m_frame_timer.restart());
+	m_samples.clear();
+	publishFrame();
 }
 
-void GraphicsManager::setArrowPointingTo(QString name, int x, int y) {
-	if (!m_objects.contains(name))
-		return;
-
-	auto& obj = m_objects[name];
-	ArrowItem* arrow = std::get<0>(obj);
-	int sphereX = std::get<2>(obj);
-	int sphereY = std::get<3>(obj);
-	arrow->setLine(QLineF(sphereX, sphereY, x, y));
+void GraphicsManager::publishFrame() {
+	GraphicsFrame& back = m_frames[m_back];
+	m_renderer->snapshot(back);
+	m_settling = m_renderer->isSettling();
+	{
+		QMutexLocker locker(&m_frame_mutex);
+		if (m_has_ready) {
+			// the GUI never took the frame being replaced, its changes are part of this one
+			back.dirty |= m_frames[m_ready].dirty;
+		}
+		std::swap(m_back, m_ready);
+		m_has_ready = true;
+	}
+	if (!m_present_posted.exchange(true)) {
+		QMetaObject::invokeMethod(this, &GraphicsManager::presentFrame, Qt::QueuedConnection);
+	}
 }
 
-void GraphicsManager::setArrowRot90(QString name, int num_of_90) {
-	if (!m_objects.contains(name))
-		return;
-
-	auto& obj = m_objects[name];
-	QLineF line = std::get<0>(obj)->line();
-	line.setAngle(line.angle() - num_of_90 * 90);
-	std::get<0>(obj)->setLine(line);
+void GraphicsManager::presentFrame() {
+	m_present_posted = false;
+	{
+		QMutexLocker locker(&m_frame_mutex);
+		if (!m_has_ready) {
+			return;
+		}
+		std::swap(m_front, m_ready);
+		m_has_ready = false;
+	}
+	const GraphicsFrame& frame = m_frames[m_front];
+	m_frame_item->setFrame(&frame);
+	m_overlay_item->setArrows(frame.arrows);
 }
 
-void GraphicsManager::setArrowPointingToScalar(QString name, qreal sca_x, qreal sca_y) {
-	if (!m_objects.contains(name))
-		return;
+void GraphicsManager::addSphereArrow(QString name, int x, int y, int x_to, int y_to, bool is_left) {
+	post([this, name, x, y, x_to, y_to, is_left]() { m_renderer->addSensor(name, x, y, x_to, y_to, is_left); });
+}
 
-	auto& obj = m_objects[name];
-	ArrowItem* arrow = std::get<0>(obj);
-	int x = std::get<2>(obj);
-	int y = std::get<3>(obj);
-	qreal dx = qBound(-1.0, sca_x, 1.0) * 50;
-	qreal dy = qBound(-1.0, sca_y, 1.0) * 50;
-	// arrow->setLine(QLineF(x, y, x + dx, y + dy)); // need to switch back to correct thread
-	QMetaObject::invokeMethod(arrow, "setLine", Qt::QueuedConnection, Q_ARG(QLineF, QLineF(x, y, x + dx, y + dy)));
+void GraphicsManager::rmSphereArrow(QString name) {
+	post([this, name]() { m_renderer->removeSensor(name); });
 }
 
-void GraphicsManager::setDefaultSphereColorScalar(QString name, qreal scalar) {
-	if (!m_objects.contains(name))
-		return;
+void GraphicsManager::setSpherePos(QString name, int x, int y, bool is_left, bool need_flip_arrow) {
+	post([this, name, x, y, is_left, need_flip_arrow]() {
+		m_renderer->setSensorPos(name, x, y, is_left, need_flip_arrow);
+	});
+}
 
-	scalar = qBound(0.0, scalar, 1.0) * 459;
-	auto& obj = m_objects[name];
-	std::get<1>(obj) = scalar;
-	int x = std::get<2>(obj);
-	int y = std::get<3>(obj);
-	this->m_heatmap->setCellScalar(x, y, scalar);
+void GraphicsManager::setArrowPointingTo(QString name, int x, int y) {
+	post([this, name, x, y]() { m_renderer->setArrowPointingTo(name, x, y); });
 }
 
-void GraphicsManager::setDefaultSphereColorScalarBatch(const std::vector<std::tuple<QString, qreal>>& data) {
-	std::vector<std::tuple<int, int, int>> cells;
-	for (const auto& item : data) {
-		QString name = std::get<0>(item);
-		qreal scalar = std::get<1>(item);
-		if (!m_objects.contains(name))
-			continue;
+void GraphicsManager::setArrowRot90(QString name, int num_of_90) {
+	post([this, name, num_of_90]() { m_renderer->setArrowRot90(name, num_of_90); });
+}
 
-		scalar = qBound(0.0, scalar, 1.0) * 459;
-		auto& obj = m_objects[name];
-		std::get<1>(obj) = scalar;
-		int x = std::get<2>(obj);
-		int y = std::get<3>(obj);
-		cells.emplace_back(x, y, scalar);
-	}
-	if (!cells.empty()) {
-		this->m_heatmap->setCellScalarBatch(cells);
-	}
+void GraphicsManager::setRendererConfig(const GraphicsRendererConfig& config) {
+	post([this, config]() { m_renderer->setConfig(config); });
 }
 
-void GraphicsManager::updateHeatmap() { this->m_heatmap->update(); }
+bool GraphicsManager::isHeatmapSettling() const { return m_settling; }
 
 int GraphicsManager::width() const { return m_width; }
 int GraphicsManager::height() const { return m_height; }
 
 void GraphicsManager::clear() {
 	m_scene->clear();
-	m_objects.clear();
 	createBackground();
-}
\ No newline at end of file
+	post([this]() {
+		m_renderer->clear();
+		m_frame_timer.restart();
+	});
+}
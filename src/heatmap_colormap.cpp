@@ -0,0 +1,29 @@
+#include "heatmap_colormap.hpp"
+
+#include <QtMinMax>
+
+
+HeatmapColormap heatmapColormapFromString(const QString& name, HeatmapColormap fallback) {
+	const QString lower = name.toLower();
+	if (lower == "yellow_red") {
+		return HEATMAP_COLORMAP_YELLOW_RED;
+	}
+	if (lower == "viridis") {
+		return HEATMAP_COLORMAP_VIRIDIS;
+	}
+	if (lower == "inferno") {
+		return HEATMAP_COLORMAP_INFERNO;
+	}
+	if (lower == "turbo") {
+		return HEATMAP_COLORMAP_TURBO;
+	}
+	return fallback;
+}
+
+void heatmapColormapApply(const uint32_t* __restrict table, const int* __restrict scalars, uint32_t* __restrict out,
+						  int n) {
+	for (int i = 0; i < n; i++) {
+		const int scalar = qBound(0, scalars[i], HEATMAP_SCALAR_MAX);
+		out[i] = table[(scalar * HEATMAP_COLORMAP_INDEX_SCALE) >> HEATMAP_COLORMAP_INDEX_SHIFT];
+	}
+}
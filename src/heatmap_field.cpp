@@ -0,0 +1,264 @@
+#include "heatmap_field.hpp"
+
+#include <QDebug>
+#include <QtMath>
+#include <QtMinMax>
+
+
+#define HEATMAP_FIELD_RBF_REGULARIZATION 1e-3 // keeps the system solvable for sensors on the same cell
+#define HEATMAP_FIELD_MIN_WEIGHT		 1e-4
+
+HeatmapFieldMethod heatmapFieldFromString(const QString& name, HeatmapFieldMethod fallback) {
+	const QString lower = name.toLower();
+	if (lower == "off") {
+		return HEATMAP_FIELD_OFF;
+	}
+	if (lower == "idw") {
+		return HEATMAP_FIELD_IDW;
+	}
+	if (lower == "rbf") {
+		return HEATMAP_FIELD_RBF;
+	}
+	return fallback;
+}
+
+static qreal cellDistance(int column, int row, const HeatmapFieldSensor& sensor) {
+	const int dx = column - sensor.column, dy = row - sensor.row;
+	return qSqrt(dx * dx + dy * dy);
+}
+
+// Wendland C2, positive definite with support radius
+static qreal wendland(qreal distance, qreal radius) {
+	if (distance >= radius) {
+		return 0;
+	}
+	const qreal r = distance / radius;
+	return qPow(1 - r, 4) * (4 * r + 1);
+}
+
+// Gauss-Jordan with partial pivoting, m is n x n row-major and replaced by its inverse
+static bool invertMatrix(std::vector<qreal>& m, int n) {
+	std::vector<qreal> inv(n * n, 0);
+	for (int i = 0; i < n; i++) {
+		inv[i * n + i] = 1;
+	}
+	for (int col = 0; col < n; col++) {
+		int pivot = col;
+		for (int row = col + 1; row < n; row++) {
+			if (qAbs(m[row * n + col]) > qAbs(m[pivot * n + col])) {
+				pivot = row;
+			}
+		}
+		if (qAbs(m[pivot * n + col]) < 1e-12) {
+			return false;
+		}
+		if (pivot != col) {
+			for (int k = 0; k < n; k++) {
+				std::swap(m[col * n + k], m[pivot * n + k]);
+				std::swap(inv[col * n + k], inv[pivot * n + k]);
+			}
+		}
+		const qreal scale = 1 / m[col * n + col];
+		for (int k = 0; k < n; k++) {
+			m[col * n + k] *= scale;
+			inv[col * n + k] *= scale;
+		}
+		for (int row = 0; row < n; row++) {
+			const qreal factor = m[row * n + col];
+			if (row == col || factor == 0) {
+				continue;
+			}
+			for (int k = 0; k < n; k++) {
+				m[row * n + k] -= factor * m[col * n + k];
+				inv[row * n + k] -= factor * inv[col * n + k];
+			}
+		}
+	}
+	m.swap(inv);
+	return true;
+}
+
+HeatmapField::HeatmapField() {}
+
+HeatmapField::~HeatmapField() { m_pool.waitForDone(); }
+
+void HeatmapField::build(HeatmapFieldMethod method, int columns, int rows,
+						 const std::vector<HeatmapFieldSensor>& sensors, qreal radius, qreal power) {
+	clear();
+	if (method == HEATMAP_FIELD_OFF || sensors.empty() || columns <= 0 || rows <= 0 || radius <= 0) {
+		return;
+	}
+
+	// every sensor reaches its radius, clipped to the half of its foot
+	const int split_column = columns / 2;
+	const int reach = qCeil(radius);
+	for (const HeatmapFieldSensor& sensor : sensors) {
+		const QRect half = sensor.group == 0 ? QRect(0, 0, split_column, rows)
+											 : QRect(split_column, 0, columns - split_column, rows);
+		m_bounds |= QRect(sensor.column - reach, sensor.row - reach, 2 * reach + 1, 2 * reach + 1).intersected(half);
+	}
+	if (m_bounds.isEmpty()) {
+		return;
+	}
+
+	m_row_ptr.reserve(m_bounds.width() * m_bounds.height() + 1);
+	m_row_ptr.push_back(0);
+	if (method == HEATMAP_FIELD_RBF) {
+		buildRbf(sensors, split_column, radius);
+	} else {
+		buildIdw(sensors, split_column, radius, power);
+	}
+	m_num_sensors = sensors.size();
+}
+
+void HeatmapField::clear() {
+	m_bounds = QRect();
+	m_row_ptr.clear();
+	m_sensor.clear();
+	m_weight.clear();
+	m_num_sensors = 0;
+}
+
+bool HeatmapField::isEmpty() const { return m_bounds.isEmpty(); }
+
+QRect HeatmapField::bounds() const { return m_bounds; }
+
+void HeatmapField::evaluate(const std::vector<int>& values, int* out, int stride) {
+	if (isEmpty() || (int)values.size() < m_num_sensors) {
+		return;
+	}
+	const int rows = m_bounds.height();
+	const int tiles = qMin(rows, m_pool.maxThreadCount());
+	if ((int)m_weight.size() < HEATMAP_FIELD_PARALLEL_MIN || tiles <= 1) {
+		evaluateRows(values, out, stride, 0, rows);
+		return;
+	}
+	for (int tile = 0; tile < tiles; tile++) {
+		const int first = rows * tile / tiles;
+		const int last = rows * (tile + 1) / tiles;
+		m_pool.start([this, &values, out, stride, first, last]() { evaluateRows(values, out, stride, first, last); });
+	}
+	m_pool.waitForDone();
+}
+
+/* private */
+void HeatmapField::buildIdw(const std::vector<HeatmapFieldSensor>& sensors, int split_column, qreal radius,
+							qreal power) {
+	// modified Shepard weights ((R - d) / (R d))^p go to 0 at the radius, the value then fades out over the
+	// outer half of the radius of the nearest sensor so the covered area has no hard edge
+	for (int row = m_bounds.top(); row <= m_bounds.bottom(); row++) {
+		for (int column = m_bounds.left(); column <= m_bounds.right(); column++) {
+			const int group = column < split_column ? 0 : 1;
+			const int start = m_weight.size();
+			qreal sum = 0, nearest = radius;
+			int exact = -1;
+			for (int k = 0; k < (int)sensors.size(); k++) {
+				if (sensors[k].group != group) {
+					continue;
+				}
+				const qreal distance = cellDistance(column, row, sensors[k]);
+				if (distance >= radius) {
+					continue;
+				}
+				if (distance == 0) {
+					exact = k;
+					break;
+				}
+				const qreal weight = qPow((radius - distance) / (radius * distance), power);
+				m_sensor.push_back(k);
+				m_weight.push_back(weight);
+				sum += weight;
+				nearest = qMin(nearest, distance);
+			}
+			if (exact >= 0) {
+				m_sensor.resize(start);
+				m_weight.resize(start);
+				m_sensor.push_back(exact);
+				m_weight.push_back(1);
+			} else if (sum > 0) {
+				qreal fade = 1;
+				if (nearest > radius / 2) {
+					const qreal t = (radius - nearest) / (radius / 2);
+					fade = t * t * (3 - 2 * t);
+				}
+				for (int i = start; i < (int)m_weight.size(); i++) {
+					m_weight[i] = m_weight[i] / sum * fade;
+				}
+			}
+			m_row_ptr.push_back(m_weight.size());
+		}
+	}
+}
+
+void HeatmapField::buildRbf(const std::vector<HeatmapFieldSensor>& sensors, int split_column, qreal radius) {
+	// s(x) = sum_i phi(|x - x_i|) c_i with Phi c = v, so the weight of sensor j at x is sum_i phi(|x - x_i|) Phi^-1_ij
+	std::vector<int> members[2];
+	std::vector<qreal> inverse[2];
+	for (int k = 0; k < (int)sensors.size(); k++) {
+		members[sensors[k].group == 0 ? 0 : 1].push_back(k);
+	}
+	for (int group = 0; group < 2; group++) {
+		const int n = members[group].size();
+		inverse[group].assign(n * n, 0);
+		for (int i = 0; i < n; i++) {
+			const HeatmapFieldSensor& a = sensors[members[group][i]];
+			for (int j = 0; j < n; j++) {
+				const qreal distance = cellDistance(a.column, a.row, sensors[members[group][j]]);
+				inverse[group][i * n + j] = wendland(distance, radius) + (i == j ? HEATMAP_FIELD_RBF_REGULARIZATION : 0);
+			}
+		}
+		if (!invertMatrix(inverse[group], n)) {
+			qWarning() << "Heatmap field: rbf system of group " << group << " is singular";
+			members[group].clear();
+			inverse[group].clear();
+		}
+	}
+
+	std::vector<qreal> phi, weights;
+	for (int row = m_bounds.top(); row <= m_bounds.bottom(); row++) {
+		for (int column = m_bounds.left(); column <= m_bounds.right(); column++) {
+			const int group = column < split_column ? 0 : 1;
+			const std::vector<int>& member = members[group];
+			const int n = member.size();
+			phi.assign(n, 0);
+			bool covered = false;
+			for (int i = 0; i < n; i++) {
+				phi[i] = wendland(cellDistance(column, row, sensors[member[i]]), radius);
+				covered |= phi[i] > 0;
+			}
+			if (covered) {
+				weights.assign(n, 0);
+				for (int i = 0; i < n; i++) {
+					if (phi[i] == 0) {
+						continue;
+					}
+					for (int j = 0; j < n; j++) {
+						weights[j] += phi[i] * inverse[group][i * n + j];
+					}
+				}
+				for (int j = 0; j < n; j++) {
+					if (qAbs(weights[j]) >= HEATMAP_FIELD_MIN_WEIGHT) {
+						m_sensor.push_back(member[j]);
+						m_weight.push_back(weights[j]);
+					}
+				}
+			}
+			m_row_ptr.push_back(m_weight.size());
+		}
+	}
+}
+
+void HeatmapField::evaluateRows(const std::vector<int>& values, int* out, int stride, int first, int last) const {
+	const int columns = m_bounds.width();
+	for (int row = first; row < last; row++) {
+		int* cells = out + (m_bounds.top() + row) * stride + m_bounds.left();
+		const int* row_ptr = m_row_ptr.data() + row * columns;
+		for (int column = 0; column < columns; column++) {
+			float sum = 0;
+			for (int e = row_ptr[column]; e < row_ptr[column + 1]; e++) {
+				sum += m_weight[e] * values[m_sensor[e]];
+			}
+			cells[column] = qMax(0, qRound(sum)); // rbf may undershoot between sensors, pressure is not negative
+		}
+	}
+}
@@ -0,0 +1,301 @@
+#include "heatmap_grid.hpp"
+
+#include <QtMath>
+#include <QtMinMax>
+#include <algorithm>
+
+
+HeatmapTemporal heatmapTemporalFromString(const QString& name, HeatmapTemporal fallback) {
+	const QString lower = name.toLower();
+	if (lower == "none") {
+		return HEATMAP_TEMPORAL_NONE;
+	}
+	if (lower == "smooth") {
+		return HEATMAP_TEMPORAL_SMOOTH;
+	}
+	if (lower == "decay") {
+		return HEATMAP_TEMPORAL_DECAY;
+	}
+	if (lower == "peak_hold") {
+		return HEATMAP_TEMPORAL_PEAK_HOLD;
+	}
+	return fallback;
+}
+
+HeatmapGrid::HeatmapGrid(int width, int height, int cellSize, int radiation_decay)
+	: m_width(width), m_height(height), m_cellSize(cellSize), m_radiation_decay(radiation_decay) {
+	const int cells = columns() * rows();
+	m_cellScalars[HEATMAP_FRAME_NEXT].assign(cells, 0);
+	m_cellScalars[HEATMAP_FRAME_CURRENT].assign(cells, -1);
+}
+
+HeatmapGrid::~HeatmapGrid() {}
+
+void HeatmapGrid::setCellScalar(int xPos, int yPos, const int scalar) {
+	int cellX = xPos / m_cellSize;
+	int cellY = yPos / m_cellSize;
+	if (cellX < 0 || cellX >= columns() || cellY < 0 || cellY >= rows()) {
+		return;
+	}
+
+	// add new color
+	if (scalar > 0) {
+		int* next = m_cellScalars[HEATMAP_FRAME_NEXT].data();
+		const int stride = columns();
+		next[cellY * stride + cellX] = scalar;
+		const int radius = m_radiation_decay > 0 ? scalar / m_radiation_decay : 0;
+		const std::vector<int32_t>& kernel = this->kernel(radius);
+		const int size = 2 * radius + 1;
+
+		// clip the stamp once, the inner loop then runs over contiguous cells of one row without checks
+		const QRect stamp = QRect(cellX - radius, cellY - radius, size, size).intersected(QRect(0, 0, columns(), rows()));
+		m_touched |= stamp;
+		m_dirty |= stamp;
+		const int i0 = stamp.left() - (cellX - radius);
+		const int count = stamp.width();
+		for (int j = stamp.top(); j <= stamp.bottom(); ++j) {
+			int* __restrict dst = next + j * stride + stamp.left();
+			const int32_t* __restrict weights = kernel.data() + (j - (cellY - radius)) * size + i0;
+			for (int i = 0; i < count; ++i) {
+				dst[i] += (scalar * weights[i]) >> HEATMAP_KERNEL_SHIFT;
+			}
+		}
+	}
+}
+
+void HeatmapGrid::setCellScalarBatch(const std::vector<std::tuple<int, int, int>>& cells, qint64 dt_ms) {
+	clear();
+
+	for (const auto& cell : cells) {
+		int x = std::get<0>(cell);
+		int y = std::get<1>(cell);
+		int scalar = std::get<2>(cell);
+		setCellScalar(x, y, scalar);
+	}
+	if (m_blur_radius > 0) {
+		blur();
+	}
+	if (m_temporal != HEATMAP_TEMPORAL_NONE) {
+		applyTemporal(dt_ms);
+	}
+}
+
+void HeatmapGrid::setBlurRadius(int radius) { m_blur_radius = qMax(0, radius); }
+
+int HeatmapGrid::blurRadius() const { return m_blur_radius; }
+
+void HeatmapGrid::buildField(HeatmapFieldMethod method, const std::vector<HeatmapFieldSensor>& sensors, qreal radius,
+							 qreal power) {
+	std::vector<HeatmapFieldSensor> cells = sensors;
+	for (HeatmapFieldSensor& cell : cells) {
+		cell.column /= m_cellSize;
+		cell.row /= m_cellSize;
+	}
+	m_field.build(method, columns(), rows(), cells, radius, power);
+}
+
+bool HeatmapGrid::hasField() const { return !m_field.isEmpty(); }
+
+void HeatmapGrid::setFieldValues(const std::vector<int>& values, qint64 dt_ms) {
+	clear();
+	m_field.evaluate(values, m_cellScalars[HEATMAP_FRAME_NEXT].data(), columns());
+	m_touched = m_field.bounds();
+	m_dirty |= m_touched;
+	if (m_blur_radius > 0) {
+		blur();
+	}
+	if (m_temporal != HEATMAP_TEMPORAL_NONE) {
+		applyTemporal(dt_ms);
+	}
+}
+
+void HeatmapGrid::setTemporal(HeatmapTemporal mode, qreal tau_ms, qreal hold_ms) {
+	m_temporal = mode;
+	m_tau_ms = qMax(1.0, tau_ms);
+	m_hold_ms = qMax(0.0, hold_ms);
+	m_accum_area = QRect();
+	if (mode == HEATMAP_TEMPORAL_NONE) {
+		m_accum = std::vector<int32_t>();
+		m_hold = std::vector<int32_t>();
+		return;
+	}
+	m_accum.assign(columns() * rows(), 0);
+	if (mode == HEATMAP_TEMPORAL_PEAK_HOLD) {
+		m_hold.assign(columns() * rows(), 0);
+	}
+}
+
+bool HeatmapGrid::isSettling() const { return !m_accum_area.isEmpty(); }
+
+void HeatmapGrid::clear() {
+	// everything outside m_touched is still 0
+	for (int j = m_touched.top(); j <= m_touched.bottom(); ++j) {
+		std::fill_n(m_cellScalars[HEATMAP_FRAME_NEXT].data() + j * columns() + m_touched.left(), m_touched.width(), 0);
+	}
+	m_dirty |= m_touched;
+	m_touched = QRect();
+}
+
+int HeatmapGrid::width() const { return m_width; }
+
+int HeatmapGrid::height() const { return m_height; }
+
+int HeatmapGrid::cellSize() const { return m_cellSize; }
+
+int HeatmapGrid::columns() const { return m_width / m_cellSize; }
+
+int HeatmapGrid::rows() const { return m_height / m_cellSize; }
+
+int* HeatmapGrid::cells(HeatmapFrame_t frame) { return m_cellScalars[frame].data(); }
+
+const int* HeatmapGrid::cells(HeatmapFrame_t frame) const { return m_cellScalars[frame].data(); }
+
+QRect HeatmapGrid::takeDirtyCells() {
+	const QRect dirty = m_dirty;
+	m_dirty = QRect();
+	return dirty;
+}
+
+/* private */
+const std::vector<int32_t>& HeatmapGrid::kernel(int radius) {
+	if (radius >= (int)m_kernels.size()) {
+		m_kernels.resize(radius + 1);
+	}
+	std::vector<int32_t>& kernel = m_kernels[radius];
+	if (kernel.empty()) {
+		// 1 - distance / radius inside the circle, in fixed point
+		const int size = 2 * radius + 1;
+		kernel.resize(size * size);
+		for (int j = -radius; j <= radius; ++j) {
+			for (int i = -radius; i <= radius; ++i) {
+				qreal weight = 0;
+				if (radius == 0) {
+					weight = 1;
+				} else if (i * i + j * j <= radius * radius) {
+					weight = 1 - qSqrt(i * i + j * j) / radius;
+				}
+				kernel[(j + radius) * size + (i + radius)] = qRound(weight * (1 << HEATMAP_KERNEL_SHIFT));
+			}
+		}
+	}
+	return kernel;
+}
+
+void HeatmapGrid::blur() {
+	// separable box blur over the touched cells plus the blur radius, running sums keep it O(1) per cell and pass
+	const int r = m_blur_radius;
+	const QRect area = m_touched.adjusted(-r, -r, r, r).intersected(QRect(0, 0, columns(), rows()));
+	if (area.isEmpty()) {
+		return;
+	}
+	const int w = area.width(), h = area.height();
+	const int64_t inv = (1 << 16) / (2 * r + 1);
+	const int stride = columns();
+	m_blur_buffer.resize(w * h);
+	m_blur_sums.assign(w, 0);
+	int* next = m_cellScalars[HEATMAP_FRAME_NEXT].data() + area.top() * stride + area.left();
+
+	// along each row, cells outside the area are 0
+	for (int j = 0; j < h; ++j) {
+		const int* src = next + j * stride;
+		int* dst = m_blur_buffer.data() + j * w;
+		int64_t sum = 0;
+		for (int i = 0; i < qMin(r, w); ++i) {
+			sum += src[i];
+		}
+		for (int i = 0; i < w; ++i) {
+			if (i + r < w) {
+				sum += src[i + r];
+			}
+			if (i - r - 1 >= 0) {
+				sum -= src[i - r - 1];
+			}
+			dst[i] = (sum * inv) >> 16;
+		}
+	}
+	// down the columns with one running sum per column, so both passes walk memory row by row
+	int64_t* sums = m_blur_sums.data();
+	for (int j = 0; j < qMin(r, h); ++j) {
+		const int* src = m_blur_buffer.data() + j * w;
+		for (int i = 0; i < w; ++i) {
+			sums[i] += src[i];
+		}
+	}
+	for (int j = 0; j < h; ++j) {
+		if (j + r < h) {
+			const int* add = m_blur_buffer.data() + (j + r) * w;
+			for (int i = 0; i < w; ++i) {
+				sums[i] += add[i];
+			}
+		}
+		if (j - r - 1 >= 0) {
+			const int* sub = m_blur_buffer.data() + (j - r - 1) * w;
+			for (int i = 0; i < w; ++i) {
+				sums[i] -= sub[i];
+			}
+		}
+		int* dst = next + j * stride;
+		for (int i = 0; i < w; ++i) {
+			dst[i] = (sums[i] * inv) >> 16;
+		}
+	}
+	m_touched = area;
+	m_dirty |= area;
+}
+
+void HeatmapGrid::applyTemporal(qint64 dt_ms) {
+	// one pass over the new frame and the cells still accumulated, the frame becomes the accumulated value
+	const QRect area = m_touched | m_accum_area;
+	if (area.isEmpty()) {
+		return;
+	}
+	const qreal decay = qExp(-qMax<qint64>(0, dt_ms) / m_tau_ms);
+	const int32_t keep = qRound(decay * (1 << HEATMAP_TEMPORAL_COEF_SHIFT));	 // of the accumulated value
+	const int32_t gain = (1 << HEATMAP_TEMPORAL_COEF_SHIFT) - keep;			 // of the new value, smooth only
+	const int32_t hold_ms = m_hold_ms, elapsed = dt_ms;
+	const int stride = columns();
+	int32_t any = 0;
+	for (int j = area.top(); j <= area.bottom(); ++j) {
+		int* __restrict frame = m_cellScalars[HEATMAP_FRAME_NEXT].data() + j * stride + area.left();
+		int32_t* __restrict accum = m_accum.data() + j * stride + area.left();
+		const int n = area.width();
+		switch (m_temporal) {
+			case HEATMAP_TEMPORAL_SMOOTH: {
+				for (int i = 0; i < n; ++i) {
+					const int32_t value = qBound(0, frame[i], HEATMAP_SCALAR_MAX) << HEATMAP_TEMPORAL_VALUE_SHIFT;
+					accum[i] += ((value - accum[i]) * gain) >> HEATMAP_TEMPORAL_COEF_SHIFT;
+					frame[i] = accum[i] >> HEATMAP_TEMPORAL_VALUE_SHIFT;
+					any |= accum[i];
+				}
+				break;
+			}
+			case HEATMAP_TEMPORAL_DECAY: {
+				for (int i = 0; i < n; ++i) {
+					const int32_t value = qBound(0, frame[i], HEATMAP_SCALAR_MAX) << HEATMAP_TEMPORAL_VALUE_SHIFT;
+					const int32_t decayed = (accum[i] * keep) >> HEATMAP_TEMPORAL_COEF_SHIFT;
+					accum[i] = qMax(value, decayed);
+					frame[i] = accum[i] >> HEATMAP_TEMPORAL_VALUE_SHIFT;
+					any |= accum[i];
+				}
+				break;
+			}
+			default: {
+				int32_t* __restrict hold = m_hold.data() + j * stride + area.left();
+				for (int i = 0; i < n; ++i) {
+					const int32_t value = qBound(0, frame[i], HEATMAP_SCALAR_MAX) << HEATMAP_TEMPORAL_VALUE_SHIFT;
+					const int32_t decayed = (accum[i] * keep) >> HEATMAP_TEMPORAL_COEF_SHIFT;
+					const bool peak = value >= accum[i];
+					const int32_t held = hold[i] > 0 ? accum[i] : decayed;
+					hold[i] = peak ? hold_ms : qMax(0, hold[i] - elapsed);
+					accum[i] = peak ? value : qMax(value, held);
+					frame[i] = accum[i] >> HEATMAP_TEMPORAL_VALUE_SHIFT;
+					any |= accum[i];
+				}
+				break;
+			}
+		}
+	}
+	m_touched = area;
+	m_dirty |= area;
+	m_accum_area = any ? area : QRect();
+}
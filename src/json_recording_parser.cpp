@@ -0,0 +1,334 @@
+#include "json_recording_parser.hpp"
+
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+#include <cmath>
+
+
+#define JSON_INT_MAX_DIGITS 18 // anything longer may overflow qint64, decoded through double instead
+
+/* JsonRecordingParser */
+JsonRecordingParser::JsonRecordingParser() {}
+
+JsonRecordingParser::~JsonRecordingParser() {}
+
+bool JsonRecordingParser::parseFile(const QString& path, JsonRecordingHandler& handler) {
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		this->error = "Couldn't open recording file";
+		this->error_offset = -1;
+		return false;
+	}
+	const qint64 size = file.size();
+	uchar* data = size > 0 ? file.map(0, size) : nullptr;
+	if (data) {
+		const bool ok = this->parse(reinterpret_cast<const char*>(data), reinterpret_cast<const char*>(data) + size,
+									handler);
+		file.unmap(data);
+		return ok;
+	}
+	// mapping not supported by the device, fall back to a plain read
+	const QByteArray bytes = file.readAll();
+	return this->parse(bytes.constData(), bytes.constData() + bytes.size(), handler);
+}
+
+bool JsonRecordingParser::parse(const char* begin_, const char* end_, JsonRecordingHandler& handler) {
+	this->begin = this->p = begin_;
+	this->end = end_;
+	this->error.clear();
+	this->error_offset = -1;
+	this->sample_count = 0;
+
+	skipWhitespace();
+	if (!expect('{')) {
+		return false;
+	}
+	skipWhitespace();
+	bool empty = p < end && *p == '}';
+	if (empty) {
+		p++;
+	}
+	while (!empty) {
+		QString key;
+		skipWhitespace();
+		if (!parseString(key)) {
+			return false;
+		}
+		skipWhitespace();
+		if (!expect(':')) {
+			return false;
+		}
+		skipWhitespace();
+		if (key == "init_time") {
+			qint64 init_time;
+			if (!parseNumber(init_time)) {
+				return false;
+			}
+			handler.initTime(init_time);
+		} else {
+			handler.sensorBegin(key);
+			if (!parseSensor(handler)) {
+				return false;
+			}
+			handler.sensorEnd();
+		}
+		skipWhitespace();
+		if (p < end && *p == ',') {
+			p++;
+			continue;
+		}
+		if (!expect('}')) {
+			return false;
+		}
+		break;
+	}
+	skipWhitespace();
+	if (p != end) {
+		return fail("Failed to parse recording file: trailing data");
+	}
+	return true;
+}
+
+bool JsonRecordingParser::parseSensor(JsonRecordingHandler& handler) {
+	if (p >= end || *p != '[') {
+		return fail("Invalid recording file: data not array");
+	}
+	p++;
+	skipWhitespace();
+	if (p < end && *p == ']') {
+		return fail("Invalid recording file: data empty");
+	}
+
+	qint64 row[5];
+	while (true) {
+		skipWhitespace();
+		if (p >= end || *p != '[') {
+			return fail("Invalid recording file: data not array or size not 5");
+		}
+		p++;
+		for (int i = 0; i < 5; i++) {
+			skipWhitespace();
+			if (!parseNumber(row[i])) {
+				return false;
+			}
+			skipWhitespace();
+			if (p >= end || *p != (i < 4 ? ',' : ']')) {
+				return fail("Invalid recording file: data not array or size not 5");
+			}
+			p++;
+		}
+		for (int i = 1; i < 5; i++) {
+			if (row[i] < INT16_MIN || row[i] > INT16_MAX) {
+				return fail("Invalid recording file: value out of range");
+			}
+		}
+		handler.sample(row[0], row[1], row[2], row[3], row[4]);
+		this->sample_count++;
+
+		skipWhitespace();
+		if (p < end && *p == ',') {
+			p++;
+			continue;
+		}
+		return expect(']');
+	}
+}
+
+bool JsonRecordingParser::parseString(QString& out) {
+	if (!expect('"')) {
+		return false;
+	}
+	const char* start = p;
+	while (p < end && *p != '"' && *p != '\\') {
+		p++;
+	}
+	if (p < end && *p == '"') { // fast path, no escapes
+		out = QString::fromUtf8(start, p - start);
+		p++;
+		return true;
+	}
+
+	QByteArray buf(start, p - start);
+	while (p < end && *p != '"') {
+		if (*p != '\\') {
+			buf.append(*p++);
+			continue;
+		}
+		if (++p >= end) {
+			break;
+		}
+		switch (*p) {
+			case '"': buf.append('"'); break;
+			case '\\': buf.append('\\'); break;
+			case '/': buf.append('/'); break;
+			case 'b': buf.append('\b'); break;
+			case 'f': buf.append('\f'); break;
+			case 'n': buf.append('\n'); break;
+			case 'r': buf.append('\r'); break;
+			case 't': buf.append('\t'); break;
+			case 'u': {
+				if (end - p < 5) {
+					return fail("Failed to parse recording file: bad escape");
+				}
+				bool ok;
+				const ushort code = QByteArray(p + 1, 4).toUShort(&ok, 16);
+				if (!ok) {
+					return fail("Failed to parse recording file: bad escape");
+				}
+				buf.append(QString(QChar(code)).toUtf8());
+				p += 4;
+				break;
+			}
+			default: return fail("Failed to parse recording file: bad escape");
+		}
+		p++;
+	}
+	if (!expect('"')) {
+		return false;
+	}
+	out = QString::fromUtf8(buf);
+	return true;
+}
+
+bool JsonRecordingParser::parseNumber(qint64& value) {
+	const char* start = p;
+	const bool negative = p < end && *p == '-';
+	if (negative) {
+		p++;
+	}
+	if (p >= end || *p < '0' || *p > '9') {
+		return fail("Invalid recording file: value not number");
+	}
+	quint64 v = 0;
+	const char* digits = p;
+	while (p < end && *p >= '0' && *p <= '9') {
+		v = v * 10 + (*p - '0');
+		p++;
+	}
+	if (p - digits <= JSON_INT_MAX_DIGITS && (p >= end || (*p != '.' && *p != 'e' && *p != 'E'))) {
+		value = negative ? -(qint64)v : (qint64)v;
+		return true;
+	}
+
+	// fraction, exponent or very long integer
+	while (p < end && ((*p >= '0' && *p <= '9') || *p == '.' || *p == 'e' || *p == 'E' || *p == '+' || *p == '-')) {
+		p++;
+	}
+	bool ok;
+	const double d = QByteArray(start, p - start).toDouble(&ok);
+	if (!ok || !std::isfinite(d) || d < -9.2e18 || d > 9.2e18) {
+		return fail("Invalid recording file: value not number");
+	}
+	value = std::llround(d);
+	return true;
+}
+
+void JsonRecordingParser::skipWhitespace() {
+	while (p < end && (*p == ' ' || *p == '\n' || *p == '\r' || *p == '\t')) {
+		p++;
+	}
+}
+
+bool JsonRecordingParser::expect(char c) {
+	if (p >= end || *p != c) {
+		return fail(QString("Failed to parse recording file: expected '%1'").arg(c));
+	}
+	p++;
+	return true;
+}
+
+bool JsonRecordingParser::fail(const QString& message) {
+	this->error = message;
+	this->error_offset = this->p - this->begin;
+	return false;
+}
+
+QString JsonRecordingParser::errorString() const { return this->error; }
+
+qint64 JsonRecordingParser::errorOffset() const { return this->error_offset; }
+
+qint64 JsonRecordingParser::sampleCount() const { return this->sample_count; }
+
+/* RecordingColumnsBuilder */
+RecordingColumnsBuilder::RecordingColumnsBuilder() {}
+
+RecordingColumnsBuilder::~RecordingColumnsBuilder() {
+	for (auto c : this->columns) {
+		delete c;
+	}
+}
+
+void RecordingColumnsBuilder::initTime(qint64 init_time_) { this->init_time = init_time_; }
+
+void RecordingColumnsBuilder::sensorBegin(const QString& key) {
+	this->current = new RecordingColumns;
+	this->columns.append(this->current);
+	this->sensor_keys.append(key);
+}
+
+void RecordingColumnsBuilder::sample(qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z) {
+	this->current->timestamps.append(timestamp);
+	this->current->T.append(T);
+	this->current->X.append(X);
+	this->current->Y.append(Y);
+	this->current->Z.append(Z);
+}
+
+void RecordingColumnsBuilder::sensorEnd() { this->current = nullptr; }
+
+qint64 RecordingColumnsBuilder::getInitTime() const { return this->init_time; }
+
+QStringList RecordingColumnsBuilder::keys() const { return this->sensor_keys; }
+
+QList<RecordingColumns*> RecordingColumnsBuilder::takeColumns() {
+	QList<RecordingColumns*> out;
+	out.swap(this->columns);
+	return out;
+}
+
+/* RecordingWriterSink */
+RecordingWriterSink::RecordingWriterSink(RecordingWriter& writer_) : writer(writer_) {}
+
+RecordingWriterSink::~RecordingWriterSink() {}
+
+void RecordingWriterSink::initTime(qint64 init_time) { this->writer.setInitTime(init_time); }
+
+void RecordingWriterSink::sensorBegin(const QString& key) { this->sensor = this->writer.sensorId(key); }
+
+void RecordingWriterSink::sample(qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z) {
+	this->writer.append(this->sensor, timestamp, T, X, Y, Z);
+}
+
+void RecordingWriterSink::sensorEnd() {}
+
+bool convertJsonRecording(const QString& json_path, const QString& binary_path, QString* error,
+						  qint64* sample_count) {
+	RecordingWriter writer;
+	if (!writer.open(binary_path, 0)) {
+		if (error) {
+			*error = "Couldn't create " + binary_path;
+		}
+		return false;
+	}
+	RecordingWriterSink sink(writer);
+	JsonRecordingParser parser;
+	if (!parser.parseFile(json_path, sink)) {
+		writer.close();
+		QFile::remove(binary_path);
+		if (error) {
+			*error = QString("%1 (offset %2)").arg(parser.errorString()).arg(parser.errorOffset());
+		}
+		return false;
+	}
+	if (!writer.close()) {
+		if (error) {
+			*error = "Failed to write " + binary_path;
+		}
+		return false;
+	}
+	if (sample_count) {
+		*sample_count = parser.sampleCount();
+	}
+	return true;
+}
@@ -0,0 +1,336 @@
+#include "lstm_engine.hpp"
+
+#include <QByteArray>
+#include <QDebug>
+#include <QFile>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+// clang-format off
+#if (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+	#define LSTM_HAVE_AVX2 1
+	#include <immintrin.h>
+#endif
+#if defined(__ARM_NEON) || defined(__aarch64__)
+	#define LSTM_HAVE_NEON 1
+	#include <arm_neon.h>
+#endif
+// clang-format on
+
+
+#define LSTM_SIMD_WIDTH 8 // floats, rows are padded to this so no kernel needs a tail loop
+
+static int padToSimd(int n) { return (n + LSTM_SIMD_WIDTH - 1) / LSTM_SIMD_WIDTH * LSTM_SIMD_WIDTH; }
+
+static float sigmoid(float x) { return 1.0f / (1.0f + std::exp(-x)); }
+
+/* matrix vector kernels, out[0, stride) = bias + x * weights */
+static void matvecScalar(const float* x, int rows, const float* weights, int stride, const float* bias, float* out) {
+	memcpy(out, bias, stride * sizeof(float));
+	for (int r = 0; r < rows; r++) {
+		const float xr = x[r];
+		const float* row = weights + r * stride;
+		for (int col = 0; col < stride; col++) {
+			out[col] += xr * row[col];
+		}
+	}
+}
+
+#ifdef LSTM_HAVE_AVX2
+__attribute__((target("avx2,fma"))) static void matvecAvx2(const float* x, int rows, const float* weights, int stride,
+														   const float* bias, float* out) {
+	int col = 0;
+	// four accumulators hide the FMA latency, 4 * units = 128 gates is exactly four of these blocks
+	for (; col + 4 * LSTM_SIMD_WIDTH <= stride; col += 4 * LSTM_SIMD_WIDTH) {
+		__m256 acc0 = _mm256_loadu_ps(bias + col);
+		__m256 acc1 = _mm256_loadu_ps(bias + col + 8);
+		__m256 acc2 = _mm256_loadu_ps(bias + col + 16);
+		__m256 acc3 = _mm256_loadu_ps(bias + col + 24);
+		const float* row = weights + col;
+		for (int r = 0; r < rows; r++, row += stride) {
+			const __m256 xr = _mm256_set1_ps(x[r]);
+			acc0 = _mm256_fmadd_ps(xr, _mm256_loadu_ps(row), acc0);
+			acc1 = _mm256_fmadd_ps(xr, _mm256_loadu_ps(row + 8), acc1);
+			acc2 = _mm256_fmadd_ps(xr, _mm256_loadu_ps(row + 16), acc2);
+			acc3 = _mm256_fmadd_ps(xr, _mm256_loadu_ps(row + 24), acc3);
+		}
+		_mm256_storeu_ps(out + col, acc0);
+		_mm256_storeu_ps(out + col + 8, acc1);
+		_mm256_storeu_ps(out + col + 16, acc2);
+		_mm256_storeu_ps(out + col + 24, acc3);
+	}
+	for (; col < stride; col += LSTM_SIMD_WIDTH) {
+		__m256 acc = _mm256_loadu_ps(bias + col);
+		const float* row = weights + col;
+		for (int r = 0; r < rows; r++, row += stride) {
+			acc = _mm256_fmadd_ps(_mm256_set1_ps(x[r]), _mm256_loadu_ps(row), acc);
+		}
+		_mm256_storeu_ps(out + col, acc);
+	}
+}
+#endif
+
+#ifdef LSTM_HAVE_NEON
+static void matvecNeon(const float* x, int rows, const float* weights, int stride, const float* bias, float* out) {
+	int col = 0;
+	for (; col + 4 * LSTM_SIMD_WIDTH <= stride; col += 4 * LSTM_SIMD_WIDTH) {
+		float32x4_t acc[8];
+		for (int i = 0; i < 8; i++) {
+			acc[i] = vld1q_f32(bias + col + 4 * i);
+		}
+		const float* row = weights + col;
+		for (int r = 0; r < rows; r++, row += stride) {
+			const float32x4_t xr = vdupq_n_f32(x[r]);
+			for (int i = 0; i < 8; i++) {
+				acc[i] = vfmaq_f32(acc[i], xr, vld1q_f32(row + 4 * i));
+			}
+		}
+		for (int i = 0; i < 8; i++) {
+			vst1q_f32(out + col + 4 * i, acc[i]);
+		}
+	}
+	for (; col < stride; col += 4) {
+		float32x4_t acc = vld1q_f32(bias + col);
+		const float* row = weights + col;
+		for (int r = 0; r < rows; r++, row += stride) {
+			acc = vfmaq_f32(acc, vdupq_n_f32(x[r]), vld1q_f32(row));
+		}
+		vst1q_f32(out + col, acc);
+	}
+}
+#endif
+
+/* LstmEngine */
+LstmEngine::LstmEngine() : m_kernel(bestKernel()) {}
+
+LstmEngine::~LstmEngine() {}
+
+LstmKernel LstmEngine::bestKernel() {
+#ifdef LSTM_HAVE_NEON
+	return LSTM_KERNEL_NEON;
+#elif defined(LSTM_HAVE_AVX2)
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma")) {
+		return LSTM_KERNEL_AVX2;
+	}
+	return LSTM_KERNEL_SCALAR;
+#else
+	return LSTM_KERNEL_SCALAR;
+#endif
+}
+
+const char* LstmEngine::kernelName(LstmKernel kernel) {
+	switch (kernel) {
+		case LSTM_KERNEL_AVX2:
+			return "avx2";
+		case LSTM_KERNEL_NEON:
+			return "neon";
+		default:
+			return "scalar";
+	}
+}
+
+LstmKernel LstmEngine::kernel() const { return this->m_kernel; }
+
+void LstmEngine::setKernel(LstmKernel kernel) {
+	const LstmKernel best = bestKernel();
+	this->m_kernel = kernel == best ? kernel : LSTM_KERNEL_SCALAR;
+}
+
+bool LstmEngine::load(const QString& path) {
+	this->error.clear();
+	this->input_size = this->m_units = 0;
+	this->dense.clear();
+
+	QFile file(path);
+	if (!file.open(QIODevice::ReadOnly)) {
+		return this->fail("Couldn't open weights file");
+	}
+	const QByteArray bytes = file.readAll();
+	const char* p = bytes.constData();
+	const char* end = p + bytes.size();
+
+	LstmWeightsHeader header;
+	if (end - p < (qint64)sizeof(header)) {
+		return this->fail("Invalid weights file: too small");
+	}
+	memcpy(&header, p, sizeof(header));
+	p += sizeof(header);
+	if (memcmp(header.magic, LSTM_WEIGHTS_MAGIC, sizeof(header.magic)) != 0) {
+		return this->fail("Invalid weights file: bad magic");
+	}
+	if (header.version != LSTM_WEIGHTS_VERSION) {
+		return this->fail("Invalid weights file: unsupported version");
+	}
+	if (header.input_size == 0 || header.units == 0 || header.num_dense == 0 || header.num_dense > LSTM_MAX_DENSE
+		|| header.input_size > 4096 || header.units > 4096) {
+		return this->fail("Invalid weights file: bad layer sizes");
+	}
+	const int input_size = header.input_size;
+	const int units = header.units;
+
+	LstmDenseHeader dense_headers[LSTM_MAX_DENSE];
+	if (end - p < (qint64)(header.num_dense * sizeof(LstmDenseHeader))) {
+		return this->fail("Invalid weights file: truncated");
+	}
+	memcpy(dense_headers, p, header.num_dense * sizeof(LstmDenseHeader));
+	p += header.num_dense * sizeof(LstmDenseHeader);
+	int inputs = units;
+	for (quint32 i = 0; i < header.num_dense; i++) {
+		const LstmDenseHeader& dh = dense_headers[i];
+		if ((int)dh.inputs != inputs || dh.outputs == 0 || dh.outputs > 4096
+			|| dh.activation >= NUM_OF_LSTM_ACTIVATION) {
+			return this->fail("Invalid weights file: bad dense layer");
+		}
+		inputs = dh.outputs;
+	}
+
+	// copies a rows x cols matrix into rows of stride floats, zero padded
+	auto readMatrix = [&](int rows, int cols, int stride, float* dst) {
+		const qint64 bytes = (qint64)rows * cols * sizeof(float);
+		if (end - p < bytes) {
+			return false;
+		}
+		for (int r = 0; r < rows; r++) {
+			memcpy(dst + r * stride, p + (qint64)r * cols * sizeof(float), cols * sizeof(float));
+		}
+		p += bytes;
+		return true;
+	};
+
+	this->gate_stride = padToSimd(4 * units);
+	this->lstm_weights.assign((input_size + units) * this->gate_stride, 0.0f);
+	this->lstm_bias.assign(this->gate_stride, 0.0f);
+	if (!readMatrix(input_size, 4 * units, this->gate_stride, this->lstm_weights.data())
+		|| !readMatrix(units, 4 * units, this->gate_stride, this->lstm_weights.data() + input_size * this->gate_stride)
+		|| !readMatrix(1, 4 * units, this->gate_stride, this->lstm_bias.data())) {
+		return this->fail("Invalid weights file: truncated");
+	}
+	int max_stride = 0;
+	for (quint32 i = 0; i < header.num_dense; i++) {
+		Dense layer;
+		layer.inputs = dense_headers[i].inputs;
+		layer.outputs = dense_headers[i].outputs;
+		layer.stride = padToSimd(layer.outputs);
+		layer.activation = (LstmActivation)dense_headers[i].activation;
+		layer.weights.assign(layer.inputs * layer.stride, 0.0f);
+		layer.bias.assign(layer.stride, 0.0f);
+		if (!readMatrix(layer.inputs, layer.outputs, layer.stride, layer.weights.data())
+			|| !readMatrix(1, layer.outputs, layer.stride, layer.bias.data())) {
+			this->dense.clear();
+			return this->fail("Invalid weights file: truncated");
+		}
+		max_stride = std::max(max_stride, layer.stride);
+		this->dense.push_back(std::move(layer));
+	}
+	if (p != end) {
+		this->dense.clear();
+		return this->fail("Invalid weights file: trailing data");
+	}
+
+	this->input_size = input_size;
+	this->m_units = units;
+	this->xh.assign(input_size + units, 0.0f);
+	this->gates.assign(this->gate_stride, 0.0f);
+	this->run_h.assign(units, 0.0f);
+	this->run_c.assign(units, 0.0f);
+	this->dense_out[0].assign(max_stride, 0.0f);
+	this->dense_out[1].assign(max_stride, 0.0f);
+	return true;
+}
+
+bool LstmEngine::isLoaded() const { return this->m_units > 0; }
+
+QString LstmEngine::errorString() const { return this->error; }
+
+int LstmEngine::inputSize() const { return this->input_size; }
+
+int LstmEngine::units() const { return this->m_units; }
+
+int LstmEngine::outputSize() const { return this->dense.empty() ? 0 : this->dense.back().outputs; }
+
+void LstmEngine::matvec(const float* x, int rows, const float* weights, int stride, const float* bias,
+						float* out) const {
+	switch (this->m_kernel) {
+#ifdef LSTM_HAVE_AVX2
+		case LSTM_KERNEL_AVX2:
+			matvecAvx2(x, rows, weights, stride, bias, out);
+			return;
+#endif
+#ifdef LSTM_HAVE_NEON
+		case LSTM_KERNEL_NEON:
+			matvecNeon(x, rows, weights, stride, bias, out);
+			return;
+#endif
+		default:
+			matvecScalar(x, rows, weights, stride, bias, out);
+			return;
+	}
+}
+
+void LstmEngine::step(const float* frame, float* h, float* c) {
+	const int units = this->m_units;
+	float* xh = this->xh.data();
+	memcpy(xh, frame, this->input_size * sizeof(float));
+	memcpy(xh + this->input_size, h, units * sizeof(float));
+	float* gates = this->gates.data();
+	this->matvec(xh, this->input_size + units, this->lstm_weights.data(), this->gate_stride, this->lstm_bias.data(),
+				 gates);
+
+	const float* gate_i = gates;
+	const float* gate_f = gates + units;
+	const float* gate_c = gates + 2 * units;
+	const float* gate_o = gates + 3 * units;
+	for (int u = 0; u < units; u++) {
+		c[u] = sigmoid(gate_f[u]) * c[u] + sigmoid(gate_i[u]) * std::tanh(gate_c[u]);
+		h[u] = sigmoid(gate_o[u]) * std::tanh(c[u]);
+	}
+}
+
+void LstmEngine::classify(const float* h, float* probs) {
+	const float* in = h;
+	for (size_t i = 0; i < this->dense.size(); i++) {
+		const Dense& layer = this->dense[i];
+		float* out = this->dense_out[i % 2].data();
+		this->matvec(in, layer.inputs, layer.weights.data(), layer.stride, layer.bias.data(), out);
+		switch (layer.activation) {
+			case LSTM_ACTIVATION_RELU:
+				for (int o = 0; o < layer.outputs; o++) {
+					out[o] = std::max(out[o], 0.0f);
+				}
+				break;
+			case LSTM_ACTIVATION_SOFTMAX: {
+				const float max = *std::max_element(out, out + layer.outputs);
+				float sum = 0;
+				for (int o = 0; o < layer.outputs; o++) {
+					out[o] = std::exp(out[o] - max);
+					sum += out[o];
+				}
+				for (int o = 0; o < layer.outputs; o++) {
+					out[o] /= sum;
+				}
+				break;
+			}
+			default:
+				break;
+		}
+		in = out;
+	}
+	memcpy(probs, in, this->outputSize() * sizeof(float));
+}
+
+void LstmEngine::run(const float* frames, int timesteps, float* probs) {
+	std::fill(this->run_h.begin(), this->run_h.end(), 0.0f);
+	std::fill(this->run_c.begin(), this->run_c.end(), 0.0f);
+	for (int t = 0; t < timesteps; t++) {
+		this->step(frames + t * this->input_size, this->run_h.data(), this->run_c.data());
+	}
+	this->classify(this->run_h.data(), probs);
+}
+
+bool LstmEngine::fail(const QString& message) {
+	qWarning() << message;
+	this->error = message;
+	return false;
+}
@@ -1,5 +1,7 @@
 #include "mainwindow.h"
+#ifdef WITH_TENSORFLOW
 #include "network.hpp"
+#endif
 
 #include <QApplication>
 #include <QLocale>
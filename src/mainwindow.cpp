@@ -33,10 +33,6 @@ MainWindow::MainWindow(QWidget* parent)
 	, chartView{new QChartView(), new QChartView(), new QChartView()}
 	, chart{new QChart(), new QChart(), new QChart()}
 	, series{new QLineSeries(), new QLineSeries(), new QLineSeries()}
-	, chart_update_timer(new QTimer())
-	, chart_update_thread(new QThread())
-	, graphics_update_timer(new QTimer())
-	, graphics_update_thread(new QThread())
 	, classification_timer(new QTimer())
 	, classification_update_thread(new QThread())
 	, mqtt_state_btn(new QPushButton())
@@ -53,6 +49,8 @@ MainWindow::MainWindow(QWidget* parent)
 	, xy_right_btn(new QRadioButton("Right"))
 	, data_clear_flags()
 	, settings(new Settings())
+	, auto_record_timer(new QTimer(this))
+	, frame_scheduler(new FrameScheduler(this, this))
 	, chart_worker(new ChartWorker(this))
 	, graphics_worker(new GraphicsWorker(this))
 	, classification_worker(new ClassificationWorker()) {
@@ -66,13 +64,15 @@ MainWindow::MainWindow(QWidget* parent)
 	// graphicsView
 	this->ui->graphicsView->setStyleSheet("QGraphicsView { border: 0px solid #000; }");
 	this->graphicsManager = new GraphicsManager(this->ui->graphicsView);
+	// heatmap and center of pressure options, see loadGraphicsRendererConfig
+	this->graphicsManager->setRendererConfig(loadGraphicsRendererConfig(this->settings));
 
 	// comboBox
 	comboBox->setInsertPolicy(QComboBox::InsertAtBottom);
 	comboBox->setStyle(QStyleFactory::create("Fusion"));
 	connect(comboBox, QOverload<int>::of(&QComboBox::currentIndexChanged), this, &MainWindow::updateChartSelect);
 	// add to mainwindow on (450, 0)
-	comboBox->setGeometry(450 + 10, 10, this->width() - 450 - 20 - 100, 25);
+	comboBox->setGeometry(450 + 10, 10, this->width() - 450 - 20 - 100 - 85, 25);
 	this->layout()->addWidget(comboBox);
 
 	// esp_status_label
@@ -87,6 +87,10 @@ MainWindow::MainWindow(QWidget* parent)
 	this->elapsed_timer.start();
 	this->start_time = this->getNowMicroSec();
 
+	// chart caches of every sensor, see loadChartCacheConfig for the options
+	this->chart_config = loadChartCacheConfig(this->settings);
+	this->data_series_size = this->chart_config.capacity;
+
 	// chart
 	auto chart_height = (this->height() - comboBox->height() - comboBox->y()) / 3;
 	for (int i = 0; i < 3; i++) {
@@ -147,27 +151,59 @@ MainWindow::MainWindow(QWidget* parent)
 		chartView[i]->setChart(chart[i]);
 		this->layout()->addWidget(chartView[i]);
 	}
+
+	// trace view, e.g. {"trace_window_ms": 10000}, frames follow frame_fps
+	this->trace_view = new TraceView(this->data_series_size, this->frame_scheduler);
+	this->trace_view->setGeometry(450, comboBox->height() + comboBox->y(), this->width() - 450, chart_height * 3);
+	if (this->settings->contains("trace_window_ms")) {
+		this->trace_view->setWindowMs(this->settings->get("trace_window_ms").toDouble());
+	}
+	this->layout()->addWidget(this->trace_view);
+	this->trace_view->hide();
+
+	this->trace_btn = new QPushButton("Charts");
+	this->trace_btn->setGeometry(esp_status_label->x() + esp_status_label->width() + 5, 10, 80, 25);
+	this->trace_btn->setToolTip("Switch between charts of the selected sensor, traces of all sensors and overlay");
+	connect(this->trace_btn, &QPushButton::clicked, this, &MainWindow::traceBtnClicked);
+	this->layout()->addWidget(this->trace_btn);
 	this->reloadChart();
 
-	// connect(this->chart_update_timer, &QTimer::timeout, this, &MainWindow::updateChartData);
-	connect(this->chart_update_timer, &QTimer::timeout, this->chart_worker, &ChartWorker::updateChartData,
-			Qt::QueuedConnection);
-	this->chart_update_timer->setInterval(100); // 10fps update interval
-	this->chart_worker->moveToThread(this->chart_update_thread);
-	this->chart_update_timer->moveToThread(this->chart_update_thread);
-	this->chart_update_thread->start();
-	QMetaObject::invokeMethod(this->chart_update_timer, "start", Qt::QueuedConnection);
-
-	// connect(this->graphics_update_timer, &QTimer::timeout, this, &MainWindow::updateGraphicsData);
-	connect(this->graphics_update_timer, &QTimer::timeout, this->graphics_worker, &GraphicsWorker::updateGraphicsData,
-			Qt::QueuedConnection);
-	this->graphics_update_timer->setInterval(50); // 50fps update interval
-	this->graphics_worker->moveToThread(this->graphics_update_thread);
-	this->graphics_update_timer->moveToThread(this->graphics_update_thread);
-	this->graphics_update_thread->start();
-	QMetaObject::invokeMethod(this->graphics_update_timer, "start", Qt::QueuedConnection);
-
-	QFileInfo file_info("./model.pb");
+	// charts, heatmap and traces update together on the frame clock, only when new data arrived, e.g.
+	// {"frame_fps": 60, "frame_stats": true}
+	if (this->settings->contains("frame_fps")) {
+		this->frame_scheduler->setTargetFps(this->settings->get("frame_fps").toInt());
+	}
+	connect(this->frame_scheduler, &FrameScheduler::sig_frame, this, [this](int dirty_views) {
+		if (dirty_views & (1 << FRAME_VIEW_CHART)) {
+			this->chart_worker->updateChartData();
+		}
+		if (dirty_views & (1 << FRAME_VIEW_GRAPHICS)) {
+			this->graphics_worker->updateGraphicsData();
+		}
+		if (dirty_views & (1 << FRAME_VIEW_TRACE)) {
+			this->trace_view->requestFrame();
+		}
+	});
+	if (this->settings->contains("frame_stats") && this->settings->get("frame_stats").toBool()) {
+		connect(this->frame_scheduler, &FrameScheduler::sig_stats, this, [](const FrameStats& stats) {
+			qDebug() << "Frames: " << stats.frames << " fps: " << stats.fps << " avg: " << stats.avg_frame_ms
+					 << "ms max: " << stats.max_frame_ms << "ms missed: " << stats.missed;
+		});
+	}
+
+	// "classification_mode": "window" | "streaming", streaming steps the LSTM on every frame
+	// "classification_backend": "tensorflow" | "native", native runs model.islm without TensorFlow in both modes
+	const bool streaming = this->settings->contains("classification_mode")
+						   && this->settings->get("classification_mode").toString() == "streaming";
+	ClassificationBackend backend = CLASSIFICATION_DEFAULT_BACKEND;
+	if (this->settings->contains("classification_backend")) {
+		backend = this->settings->get("classification_backend").toString() == "native"
+					  ? CLASSIFICATION_BACKEND_NATIVE
+					  : CLASSIFICATION_BACKEND_TENSORFLOW;
+	}
+	QFileInfo file_info(backend == CLASSIFICATION_BACKEND_NATIVE ? "./model.islm"
+						: streaming								 ? "./model_step.pb"
+																 : "./model.pb");
 	if (!file_info.exists()) {
 		qDebug() << "Model file not found: " << file_info.absoluteFilePath();
 		showInfoBox("Model file not found: " + file_info.absoluteFilePath());
@@ -181,14 +217,17 @@ MainWindow::MainWindow(QWidget* parent)
 		return;
 	}
 	std::string label_path = file_info.absoluteFilePath().toStdString();
-	this->classification_worker->init(model_path, label_path);
-	connect(this->classification_timer, &QTimer::timeout, this->classification_worker,
-			&ClassificationWorker::classifyCurrentSlot, Qt::QueuedConnection);
-	this->classification_timer->setInterval(1500); // update interval
+	this->classification_worker->init(model_path, label_path,
+									  streaming ? CLASSIFICATION_MODE_STREAMING : CLASSIFICATION_MODE_WINDOW, backend);
 	this->classification_worker->moveToThread(this->classification_update_thread);
 	this->classification_timer->moveToThread(this->classification_update_thread);
 	this->classification_update_thread->start();
-	QMetaObject::invokeMethod(this->classification_timer, "start", Qt::QueuedConnection);
+	if (!streaming) {
+		connect(this->classification_timer, &QTimer::timeout, this->classification_worker,
+				&ClassificationWorker::classifyCurrentSlot, Qt::QueuedConnection);
+		this->classification_timer->setInterval(1500); // update interval
+		QMetaObject::invokeMethod(this->classification_timer, "start", Qt::QueuedConnection);
+	}
 
 	classification_result_label = new QLabel(this);
 	classification_result_label->setGeometry(350, this->height() - 25 - 10, 100, 30);
@@ -198,8 +237,8 @@ MainWindow::MainWindow(QWidget* parent)
 	classification_result_label->setText("N.A.");
 	classification_result_label->setAlignment(Qt::AlignCenter);
 	this->layout()->addWidget(classification_result_label);
-	connect(this->classification_worker, &ClassificationWorker::sig_classificationResult, this,
-			&MainWindow::updateClassificationResult);
+	connect(this->classification_worker, &ClassificationWorker::sig_classificationResults, this,
+			&MainWindow::updateClassificationResults);
 
 	// xy input box
 	QString x_placeholder = "X: 0-%1";
@@ -259,7 +298,7 @@ MainWindow::MainWindow(QWidget* parent)
 	mqtt_state_btn->setText("MQTT: Disconnected");
 	mqtt_state_btn->setFont(QFont("Calibri", 11, QFont::Medium));
 	mqtt_state_btn->setStyleSheet("QPushButton { border-radius: 5px; background-color: #a9a9a9; color: #ff0000; }");
-	mqtt_state_btn->setToolTip("Click to select JSON file to replay");
+	mqtt_state_btn->setToolTip("Click to select recording file to replay");
 	mqtt_state_btn->setGeometry(10, this->height() - 25 - 10, 220, 30);
 	connect(mqtt_state_btn, &QPushButton::clicked, this, &MainWindow::mqttStateBtnClicked);
 	this->layout()->addWidget(mqtt_state_btn);
@@ -293,25 +332,38 @@ MainWindow::MainWindow(QWidget* parent)
 	connect(&recorder, &DataRecorder::playbackData, this, &MainWindow::processData);
 	connect(&recorder, &DataRecorder::replayStarted, this, &MainWindow::clear);
 	connect(&recorder, &DataRecorder::replayFinished, this, &MainWindow::replayFinished);
+	const qreal pretrigger_sec = this->settings->contains("pretrigger_sec")
+									 ? this->settings->get("pretrigger_sec").toDouble()
+									 : PRETRIGGER_DEFAULT_SEC;
+	const int pretrigger_rate = this->settings->contains("pretrigger_rate")
+									? this->settings->get("pretrigger_rate").toInt()
+									: PRETRIGGER_DEFAULT_RATE;
+	this->recorder.setPretrigger(pretrigger_sec * 1000, pretrigger_rate);
+
+	// auto record, e.g. {"auto_record_label": "jump", "auto_record_sec": 10}
+	this->auto_record_label = this->settings->contains("auto_record_label")
+								  ? this->settings->get("auto_record_label").toString()
+								  : QString();
+	const qreal auto_record_sec =
+		this->settings->contains("auto_record_sec") ? this->settings->get("auto_record_sec").toDouble() : 10;
+	this->auto_record_timer->setSingleShot(true);
+	this->auto_record_timer->setInterval(auto_record_sec * 1000);
+	connect(this->auto_record_timer, &QTimer::timeout, this, [this]() {
+		if (this->recorder.getState() == RecorderStateRecording) {
+			this->startStopBtnClicked();
+		}
+	});
 }
 
 MainWindow::~MainWindow() {
-	// Stop and clean up threads
-	if (chart_update_thread->isRunning()) {
-		chart_update_thread->quit();
-		chart_update_thread->wait();
-	}
-	if (graphics_update_thread->isRunning()) {
-		graphics_update_thread->quit();
-		graphics_update_thread->wait();
-	}
-
 	delete ui;
 	for (int i = 0; i < 3; i++) {
 		delete chartView[i];
 		delete chart[i];
 		delete series[i];
 	}
+	delete trace_view;
+	delete trace_btn;
 	delete comboBox;
 	delete esp_status_label;
 	delete mqtt_state_btn;
@@ -319,6 +371,7 @@ MainWindow::~MainWindow() {
 	for (auto value : this->data_map.values()) {
 		delete value;
 	}
+	qDeleteAll(this->chart_caches);
 	if (this->graphicsManager) {
 		delete this->graphicsManager;
 	}
@@ -430,45 +483,25 @@ void MainWindow::processData(QString key, qint64 timestamp_ms, int16_t T, int16_
 		if (this->data_map.contains(key)) {
 			this->data_map[key]->clear();
 		}
+		this->trace_view->clearSensor(key);
+		this->data_queue_mutex.lock();
+		if (ChartSensorCache* cache = this->chart_caches.value(key)) {
+			cache->clear();
+			this->data_queue.removeIf([cache](const DataPoint& data) { return data.cache == cache; });
+		}
+		this->data_queue_mutex.unlock();
 		this->data_clear_flags.remove(key);
 		need_reload_chart = this->comboBox->currentText() == key;
 	}
 
-	const qreal time_sec = MSecToSec(timestamp_ms - this->start_time);
-	// qDebug() << "Adding data to chart: " << time_sec << " " << X << " " << Y << " " << Z;
-
-	if (time_sec != 0 && !this->chart_data[0].empty() && time_sec <= this->chart_data[0].last().x()) {
-		// qDebug() << "Invalid time: " << time_sec << " " << this->chart_data[0].last().x();
-		return;
-	}
-
 	if (!this->data_map.contains(key)) { // just on start
-		bool is_left = true;
-		Rotation rot = ROT_0;
-
-		if (this->settings->contains(key)) {
-			auto vars = this->settings->get(key).toArray();
-			if (vars.size() == 3) { // for backward compatibility
-				is_left = vars.at(2).toBool();
-			} else if (vars.size() == 4) {
-				is_left = vars.at(2).toBool();
-				rot = (Rotation)vars.at(3).toInt();
-			}
-			int pos_x = vars.at(0).toInt(), pos_y = vars.at(1).toInt();
-			this->sensor_is_left.insert(key, is_left);
-			this->sensor_pos.insert(key, std::make_tuple(pos_x, pos_y));
-			this->sensor_rot.insert(key, rot);
-			this->graphicsManager->addSphereArrow(key, pos_x, pos_y, pos_x, pos_y, is_left);
-			// qDebug() << "pt1: " << this->sensor_is_left[key] << " " << std::get<0>(this->sensor_pos[key]) << " "
-			// 		 << std::get<1>(this->sensor_pos[key]);
-		} else {
-			this->sensor_is_left.insert(key, true);
-			this->sensor_pos.insert(key, std::make_tuple(0, 0));
-			this->sensor_rot.insert(key, ROT_0);
-			this->graphicsManager->addSphereArrow(key, 0, 0, 0, 0, true);
-		}
+		const SensorConfig config = loadSensorConfig(this->settings, key);
+		this->sensor_is_left.insert(key, config.is_left);
+		this->sensor_pos.insert(key, std::make_tuple(config.x, config.y));
+		this->sensor_rot.insert(key, config.rot);
+		this->graphicsManager->addSphereArrow(key, config.x, config.y, config.x, config.y, config.is_left);
 
-		if (!is_left) {
+		if (!config.is_left) {
 			X = -X;
 			Y = -Y;
 		}
@@ -476,6 +509,10 @@ void MainWindow::processData(QString key, qint64 timestamp_ms, int16_t T, int16_
 		this->data_map.insert(key, new DataContainer(data_series_size));
 		this->data_map[key]->append(timestamp_ms, X, Y, Z);
 
+		// addItem selects the first sensor right away, its cache has to exist by then
+		this->data_queue_mutex.lock();
+		this->chartCache(key);
+		this->data_queue_mutex.unlock();
 		this->comboBox->addItem(key);
 		this->comboBox->model()->sort(0);
 
@@ -497,37 +534,15 @@ void MainWindow::processData(QString key, qint64 timestamp_ms, int16_t T, int16_
 
 		qDebug() << "new device added: " << key;
 	} else {
-		if (!this->sensor_is_left[key]) {
-			X = -X;
-			Y = -Y;
-		}
-		switch (this->sensor_rot[key]) { // clockwise
-			case ROT_90: {
-				int tmp = X;
-				X = Y;
-				Y = -tmp;
-				break;
-			}
-			case ROT_180: {
-				X = -X;
-				Y = -Y;
-				break;
-			}
-			case ROT_270: {
-				int tmp = X;
-				X = -Y;
-				Y = tmp;
-				break;
-			}
-			default: break;
-		}
+		orientSensorData(X, Y, this->sensor_is_left[key], this->sensor_rot[key]);
 
 		this->data_map[key]->append(timestamp_ms, X, Y, Z);
-		if (this->comboBox->currentText() == key) {
-			this->addChartData(timestamp_ms, X, Y, Z);
-		}
 	}
 
+	// every sensor keeps its chart cache up to date, selecting one in the combo box only swaps the shown cache
+	this->addChartData(key, timestamp_ms, X, Y, Z);
+	this->trace_view->append(key, timestamp_ms, X, Y, Z);
+
 	if (need_reload_chart) {
 		qDebug() << "Reloading chart due to recalibration";
 		this->updateChartSelect(this->comboBox->currentIndex());
@@ -539,23 +554,11 @@ void MainWindow::processData(QString key, qint64 timestamp_ms, int16_t T, int16_
 	// }
 	// last_update = this->getNowMicroSec();
 
-	const qreal scale = 600;
-	// this->graphicsManager->setArrowPointingToScalar(key, X / scale, Y / scale);
-	// this->graphicsManager->setDefaultSphereColorScalar(key, Z / scale);
+	// this->graphicsManager->setArrowPointingToScalar(key, X / SENSOR_VALUE_SCALE, Y / SENSOR_VALUE_SCALE);
+	// this->graphicsManager->setDefaultSphereColorScalar(key, Z / SENSOR_VALUE_SCALE);
 	// this->graphicsManager->setArrowRot90(key, this->sensor_rot[key]);
-	this->graphics_mutex.lock();
-	if (!this->graphics_data.contains(key)) {
-		this->graphics_data.insert(key, std::make_tuple(0.0, 0.0, 0.0));
-		this->graphics_data_num.insert(key, 0);
-	}
-	auto data = this->graphics_data[key];
-	auto num = this->graphics_data_num[key];
-	std::get<0>(data) += X; // / scale;
-	std::get<1>(data) += Y; // / scale;
-	std::get<2>(data) += Z; // / scale;
-	this->graphics_data[key] = data;
-	this->graphics_data_num[key] = num + 1;
-	this->graphics_mutex.unlock();
+	this->graphics_accumulators.accumulate(this->graphics_accumulators.slot(key), X, Y, Z);
+	this->frame_scheduler->markDirty(FRAME_VIEW_GRAPHICS);
 }
 
 // void MainWindow::updateGraphicsData() {
@@ -591,42 +594,20 @@ void MainWindow::updateChartSelect(int index) {
 
 	QString key = this->comboBox->itemText(index);
 	qDebug() << "Selected device: " << key;
-	DataContainer* data = this->data_map[key];
-	if (!data) {
-		qDebug() << "Data not found";
-		return;
-	}
-	if (data->size() == 0) {
-		qDebug() << "Data size is 0";
-		return;
-	}
-	// qDebug() << "Data size: " << data->size();
+
+	// the cache of every sensor is already filled and decimated, switching is a pointer swap plus one replace
 	data_queue_mutex.lock();
-	data_queue.clear();
+	this->chart_cache = this->chart_caches.value(key, nullptr);
+	if (this->chart_cache) {
+		this->chart_cache->resyncDisplay();
+		this->syncChartSeries();
+	} else {
+		for (int i = 0; i < 3; i++) {
+			series[i]->clear();
+		}
+	}
 	data_queue_mutex.unlock();
 
-	// series[0]->clear();
-	// series[1]->clear();
-	// series[2]->clear();
-	chart_data[0].clear();
-	chart_data[1].clear();
-	chart_data[2].clear();
-	qDebug() << "Series cleared";
-
-	for (auto [timestamp_ms, value] : *data) {
-		const qreal time_sec = MSecToSec(timestamp_ms - this->start_time);
-		// series[0]->append(time_sec, std::get<0>(value));
-		// series[1]->append(time_sec, std::get<1>(value));
-		// series[2]->append(time_sec, std::get<2>(value));
-		chart_data[0].append((QPointF){time_sec, (qreal)std::get<0>(value)});
-		chart_data[1].append((QPointF){time_sec, (qreal)std::get<1>(value)});
-		chart_data[2].append((QPointF){time_sec, (qreal)std::get<2>(value)});
-	}
-	if (chart_data[0].size() != 0) {
-		series[0]->replace(chart_data[0]);
-		series[1]->replace(chart_data[1]);
-		series[2]->replace(chart_data[2]);
-	}
 	if (this->esp_status_map.contains(key) && this->getNowMicroSec() - this->esp_status_map[key] < secToMSec(5)) {
 		this->esp_status_label->setText("Online");
 		this->esp_status_label->setStyleSheet(esp_status_label_style[1]);
@@ -652,61 +633,86 @@ void MainWindow::updateChartSelect(int index) {
 		this->xy_left_btn->setChecked(true);
 	}
 
-	qDebug() << "Data appended, reloading chart";
-
 	this->reloadChart();
 }
 
 void MainWindow::reloadChart() {
 	qDebug() << "Updating chart";
 
+	data_queue_mutex.lock();
 	for (int i = 0; i < 3; i++) {
-		qDebug() << "i: " << i << " series size: " << series[i]->points().size();
-		qreal minX = 0, maxX = 0, minY = 0, maxY = 0;
-		for (const QPointF& point : series[i]->points()) {
-			// qDebug() << "point: " << point.x() << " " << point.y();
-			if (point == series[i]->points().first()) {
-				minX = maxX = point.x();
-				minY = maxY = point.y();
-			} else {
-				minX = qMin(minX, point.x());
-				maxX = qMax(maxX, point.x());
-				minY = qMin(minY, point.y());
-				maxY = qMax(maxY, point.y());
-			}
-		}
-		// qDebug() << "minX: " << minX << " maxX: " << maxX << " minY: " << minY << " maxY: " << maxY;
-		if (abs(maxX - minX) < 1) {
-			maxX += 1;
-		}
-		if (abs(maxY - minY) < 1) {
-			maxY += 1;
-		}
+		this->updateChartAxes(i);
+		chart[i]->update();
+		chartView[i]->update();
+	}
+	data_queue_mutex.unlock();
+}
 
-		chart_range_y[i] = std::make_tuple(minY, maxY);
+void MainWindow::updateChartAxes(int i) {
+	// caller holds data_queue_mutex
+	qreal minX = 0, maxX = 0, minY = 0, maxY = 0;
+	if (chart_cache && !chart_cache->isEmpty()) {
+		minX = chart_cache->firstTime();
+		maxX = chart_cache->lastTime();
+		chart_cache->range(i).range(minY, maxY);
+	}
+	if (abs(maxX - minX) < 1) {
+		maxX = minX + 1;
+	}
+	if (abs(maxY - minY) < 1) {
+		maxY = minY + 1;
+	}
 
-		chart[i]->axes(Qt::Horizontal).back()->setRange(minX, maxX);
-		const qreal padding = ceil((maxY - minY) * 0.2);
-		chart[i]->axes(Qt::Vertical).back()->setRange(minY - padding, maxY + padding);
+	chart[i]->axes(Qt::Horizontal).back()->setRange(minX, maxX);
+	const qreal padding = ceil((maxY - minY) * 0.2);
+	chart[i]->axes(Qt::Vertical).back()->setRange(minY - padding, maxY + padding);
+}
 
-		chart[i]->update();
-		chartView[i]->update();
-		qDebug() << "Chart " << i << " updated";
-		qDebug() << "x range: " << minX << " " << maxX;
-		qDebug() << "y range: " << minY << " " << maxY;
+void MainWindow::syncChartSeries() {
+	// caller holds data_queue_mutex
+	const int target = qMax(4, (int)chart[0]->plotArea().width() * CHART_DECIMATION_POINTS_PER_PIXEL);
+	if (target != chart_config.display_target) { // plot resized, new caches start with the new target as well
+		chart_config.display_target = target;
+		for (ChartSensorCache* cache : chart_caches) {
+			cache->setDisplayTarget(target);
+		}
+	}
+	if (!chart_cache) {
+		return;
+	}
+	for (int i = 0; i < 3; i++) {
+		int removed;
+		if (!chart_cache->series(i).takeDisplayChanges(removed, chart_appended)) {
+			series[i]->replace(chart_appended);
+			continue;
+		}
+		if (removed > 0) {
+			series[i]->removePoints(0, removed);
+		}
+		if (!chart_appended.isEmpty()) {
+			series[i]->append(chart_appended);
+		}
 	}
-	qDebug() << series[0]->points().size() << " " << series[1]->points().size() << " " << series[2]->points().size();
 }
 
+ChartSensorCache* MainWindow::chartCache(const QString& key) {
+	ChartSensorCache* cache = chart_caches.value(key, nullptr);
+	if (!cache) {
+		cache = new ChartSensorCache(chart_config);
+		chart_caches.insert(key, cache);
+	}
+	return cache;
+}
 
-void MainWindow::addChartData(qint64 timestamp_ms, int16_t X, int16_t Y, int16_t Z) {
+void MainWindow::addChartData(const QString& key, qint64 timestamp_ms, int16_t X, int16_t Y, int16_t Z) {
 	const qreal time_sec = MSecToSec(timestamp_ms - this->start_time);
 	// qDebug() << "Adding data to chart: " << time_sec << " " << X << " " << Y << " " << Z;
 
 	data_queue_mutex.lock();
-	data_queue.enqueue({time_sec, (qreal)X, (qreal)Y, (qreal)Z});
+	data_queue.enqueue({this->chartCache(key), time_sec, (qreal)X, (qreal)Y, (qreal)Z});
 	is_data_queue_updated = true;
 	data_queue_mutex.unlock();
+	this->frame_scheduler->markDirty(FRAME_VIEW_CHART);
 }
 
 // void MainWindow::updateChartData() {
@@ -878,7 +884,8 @@ void MainWindow::mqttStateBtnClicked() {
 	if (dir.exists("recordings")) {
 		dir.cd("recordings");
 	}
-	QString path = QFileDialog::getOpenFileName(this, "Open recording file", dir.absolutePath(), "JSON files (*.json)");
+	QString path = QFileDialog::getOpenFileName(this, "Open recording file", dir.absolutePath(),
+												"Recording files (*." RECORDING_FILE_SUFFIX " *.json)");
 	if (path.isEmpty()) {
 		qDebug() << "No file selected";
 		return;
@@ -899,6 +906,7 @@ void MainWindow::startStopBtnClicked() {
 			// start recording
 			if (!this->recorder.startRecording()) {
 				qDebug() << "Failed to start recording";
+				break;
 			}
 			this->start_stop_btn->setText("Stop record");
 			this->start_stop_btn->setStyleSheet(
@@ -908,6 +916,7 @@ void MainWindow::startStopBtnClicked() {
 		}
 		case RecorderStateRecording: {
 			// stop recording
+			this->auto_record_timer->stop();
 			if (!this->recorder.stopRecording()) {
 				qDebug() << "Failed to stop recording";
 			}
@@ -931,6 +940,25 @@ void MainWindow::startStopBtnClicked() {
 	}
 }
 
+void MainWindow::traceBtnClicked() {
+	// charts -> traces (small multiples) -> overlay -> charts
+	const bool show_charts = this->trace_view->isVisible() && this->trace_view->traceLayout() == TRACE_LAYOUT_OVERLAY;
+	if (show_charts) {
+		this->trace_view->hide();
+		this->trace_btn->setText("Charts");
+	} else if (this->trace_view->isVisible()) {
+		this->trace_view->setTraceLayout(TRACE_LAYOUT_OVERLAY);
+		this->trace_btn->setText("Overlay");
+	} else {
+		this->trace_view->setTraceLayout(TRACE_LAYOUT_SMALL_MULTIPLES);
+		this->trace_view->show();
+		this->trace_btn->setText("Traces");
+	}
+	for (int i = 0; i < 3; i++) {
+		this->chartView[i]->setVisible(show_charts);
+	}
+}
+
 void MainWindow::replayFinished() {
 	qDebug() << "replay finished sig recv";
 	if (this->recorder.getState() != RecorderStateReplaying) {
@@ -951,8 +979,47 @@ void MainWindow::updateEspStatus(const QString esp_id, bool status) {
 	}
 }
 
+void MainWindow::updateClassificationResults(const QStringList& sessions, const QStringList& results) {
+	if (results.size() == 1) {
+		this->classification_result_label->setText(results[0]);
+	} else {
+		// several insoles classified in one run, every result with its esp id
+		QStringList texts;
+		for (int i = 0; i < results.size(); i++) {
+			texts.append(sessions[i] + ": " + results[i]);
+		}
+		this->classification_result_label->setText(texts.join("  "));
+	}
+	this->classification_result_label->resize(qMax(100, this->classification_result_label->sizeHint().width() + 10),
+											  this->classification_result_label->height());
+
+	for (const QString& result : results) {
+		this->updateClassificationResult(result);
+	}
+}
+
 void MainWindow::updateClassificationResult(const QString& result) {
-	this->classification_result_label->setText(result);
+	if (this->auto_record_label.isEmpty() || result != this->auto_record_label) {
+		return;
+	}
+	switch (this->recorder.getState()) {
+		case RecorderStateIdle: {
+			qDebug() << "auto record triggered by" << result;
+			this->startStopBtnClicked();
+			if (this->recorder.getState() == RecorderStateRecording) {
+				this->auto_record_timer->start();
+			}
+			break;
+		}
+		case RecorderStateRecording: {
+			// label seen again, extend a recording that was started automatically
+			if (this->auto_record_timer->isActive()) {
+				this->auto_record_timer->start();
+			}
+			break;
+		}
+		default: break;
+	}
 }
 
 void MainWindow::clear() {
@@ -962,11 +1029,17 @@ void MainWindow::clear() {
 	}
 	this->data_map.clear();
 	this->comboBox->clear();
+	this->trace_view->clear();
 	this->graphicsManager->clear();
 	// this->reloadChart();
-	for (int i = 0; i < 3; i++) {
-		chart_data[i].clear();
+	// caches stay allocated, the sensors usually come back with the same keys
+	data_queue_mutex.lock();
+	data_queue.clear();
+	for (ChartSensorCache* cache : chart_caches) {
+		cache->clear();
 	}
+	chart_cache = nullptr;
+	data_queue_mutex.unlock();
 	this->elapsed_timer.restart();
 	this->start_time = this->getNowMicroSec();
 }
@@ -0,0 +1,84 @@
+#include "pretrigger_ring.hpp"
+
+#include <QtMinMax>
+
+
+PretriggerRing::PretriggerRing() {}
+
+PretriggerRing::~PretriggerRing() {}
+
+void PretriggerRing::configure(qint64 window_ms_, int capacity_) {
+	this->window_ms = qMax<qint64>(0, window_ms_);
+	this->capacity = qMax(0, capacity_);
+	this->sensor_ids.clear();
+	this->sensors.clear();
+}
+
+bool PretriggerRing::isEnabled() const { return this->capacity > 0 && this->window_ms > 0; }
+
+qint64 PretriggerRing::windowMs() const { return this->window_ms; }
+
+void PretriggerRing::push(const QString& key, qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z) {
+	if (!this->isEnabled()) {
+		return;
+	}
+	auto it = this->sensor_ids.constFind(key);
+	int id;
+	if (it == this->sensor_ids.constEnd()) {
+		id = this->sensors.size();
+		this->sensor_ids.insert(key, id);
+		SensorRing ring;
+		ring.key = key;
+		ring.samples.resize(this->capacity);
+		ring.head = 0;
+		ring.count = 0;
+		ring.latest_time = 0;
+		this->sensors.append(ring);
+	} else {
+		id = it.value();
+	}
+
+	SensorRing& ring = this->sensors[id];
+	ring.samples[ring.head] = {timestamp, T, X, Y, Z};
+	ring.head = ring.head + 1 == this->capacity ? 0 : ring.head + 1;
+	if (ring.count < this->capacity) {
+		ring.count++;
+	}
+	if (ring.count == 1 || timestamp > ring.latest_time) {
+		ring.latest_time = timestamp;
+	}
+}
+
+qint64 PretriggerRing::spill(RecordingWriter& writer) {
+	qint64 written = 0;
+	for (SensorRing& ring : this->sensors) {
+		if (ring.count == 0) {
+			continue;
+		}
+		const qint64 oldest_time = ring.latest_time - this->window_ms;
+		const int sensor = writer.sensorId(ring.key);
+		int idx = ring.head - ring.count;
+		if (idx < 0) {
+			idx += this->capacity;
+		}
+		for (int i = 0; i < ring.count; i++) {
+			const PretriggerSample& s = ring.samples[idx];
+			if (s.timestamp >= oldest_time) {
+				writer.append(sensor, s.timestamp, s.T, s.X, s.Y, s.Z);
+				written++;
+			}
+			idx = idx + 1 == this->capacity ? 0 : idx + 1;
+		}
+	}
+	this->clear();
+	return written;
+}
+
+void PretriggerRing::clear() {
+	// keep the allocated rings, a cleared ring costs nothing to refill
+	for (SensorRing& ring : this->sensors) {
+		ring.head = 0;
+		ring.count = 0;
+		ring.latest_time = 0;
+	}
+}
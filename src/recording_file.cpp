@@ -0,0 +1,391 @@
+#include "recording_file.hpp"
+
+#include "json_recording_parser.hpp"
+
+#include <QDebug>
+#include <cstring>
+
+
+/* RecordingWriter */
+RecordingWriter::RecordingWriter() {}
+
+RecordingWriter::~RecordingWriter() {
+	if (this->isOpen()) {
+		this->close();
+	}
+	for (auto block : this->pending) {
+		delete block;
+	}
+}
+
+bool RecordingWriter::open(const QString& path, qint64 init_time_) {
+	if (this->isOpen()) {
+		this->close();
+	}
+	for (auto block : this->pending) {
+		delete block;
+	}
+	this->pending.clear();
+	this->sensor_ids.clear();
+	this->sensor_keys.clear();
+	this->index.clear();
+	this->sample_count = 0;
+	this->write_failed = false;
+
+	this->file.setFileName(path);
+	if (!this->file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+		qWarning() << "Couldn't open recording file for writing: " << path;
+		return false;
+	}
+
+	this->init_time = init_time_;
+	if (!this->writeHeader()) {
+		qWarning() << "Couldn't write recording header: " << this->file.errorString();
+		this->file.close();
+		return false;
+	}
+	return true;
+}
+
+bool RecordingWriter::close() {
+	if (!this->isOpen()) {
+		return false;
+	}
+	for (int i = 0; i < this->pending.size(); i++) {
+		this->flushBlock(i);
+	}
+
+	RecordingFileFooter footer = {};
+	footer.sensor_table_offset = this->file.pos();
+	for (const QString& key : this->sensor_keys) {
+		const QByteArray utf8 = key.toUtf8();
+		const quint16 len = utf8.size();
+		this->write_failed |= this->file.write(reinterpret_cast<const char*>(&len), sizeof(len)) != sizeof(len);
+		this->write_failed |= this->file.write(utf8) != utf8.size();
+	}
+	this->writePadding();
+
+	footer.index_offset = this->file.pos();
+	const qint64 index_bytes = this->index.size() * sizeof(RecordingBlockIndex);
+	this->write_failed |=
+		this->file.write(reinterpret_cast<const char*>(this->index.constData()), index_bytes) != index_bytes;
+
+	footer.sensor_count = this->sensor_keys.size();
+	footer.block_count = this->index.size();
+	memcpy(footer.magic, RECORDING_INDEX_MAGIC, sizeof(footer.magic));
+	this->write_failed |=
+		this->file.write(reinterpret_cast<const char*>(&footer), sizeof(footer)) != sizeof(footer);
+
+	// init_time may have changed since open
+	this->write_failed |= !this->file.seek(0) || !this->writeHeader();
+
+	this->file.close();
+	if (this->write_failed) {
+		qWarning() << "Failed to write recording file: " << this->file.fileName();
+	}
+	return !this->write_failed;
+}
+
+bool RecordingWriter::isOpen() const { return this->file.isOpen(); }
+
+void RecordingWriter::setInitTime(qint64 init_time_) { this->init_time = init_time_; }
+
+int RecordingWriter::sensorId(const QString& key) {
+	auto it = this->sensor_ids.constFind(key);
+	if (it != this->sensor_ids.constEnd()) {
+		return it.value();
+	}
+	const int sensor = this->sensor_keys.size();
+	this->sensor_ids.insert(key, sensor);
+	this->sensor_keys.append(key);
+	PendingBlock* block = new PendingBlock;
+	block->count = 0;
+	this->pending.append(block);
+	return sensor;
+}
+
+void RecordingWriter::append(int sensor, qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z) {
+	if (!this->isOpen()) {
+		return;
+	}
+	PendingBlock* block = this->pending[sensor];
+	const int i = block->count++;
+	block->timestamps[i] = timestamp;
+	block->T[i] = T;
+	block->X[i] = X;
+	block->Y[i] = Y;
+	block->Z[i] = Z;
+	this->sample_count++;
+	if (block->count == RECORDING_BLOCK_SAMPLES) {
+		this->flushBlock(sensor);
+	}
+}
+
+void RecordingWriter::append(const QString& key, qint64 timestamp, int16_t T, int16_t X, int16_t Y, int16_t Z) {
+	if (!this->isOpen()) {
+		return;
+	}
+	this->append(this->sensorId(key), timestamp, T, X, Y, Z);
+}
+
+qint64 RecordingWriter::sampleCount() const { return this->sample_count; }
+
+QString RecordingWriter::errorString() const { return this->file.errorString(); }
+
+bool RecordingWriter::writeHeader() {
+	RecordingFileHeader header = {};
+	memcpy(header.magic, RECORDING_FILE_MAGIC, sizeof(header.magic));
+	header.version = RECORDING_FILE_VERSION;
+	header.init_time = this->init_time;
+	header.block_samples = RECORDING_BLOCK_SAMPLES;
+	return this->file.write(reinterpret_cast<const char*>(&header), sizeof(header)) == sizeof(header);
+}
+
+bool RecordingWriter::flushBlock(int sensor) {
+	PendingBlock* block = this->pending[sensor];
+	const int n = block->count;
+	if (n == 0) {
+		return true;
+	}
+
+	RecordingBlockIndex entry;
+	entry.sensor = sensor;
+	entry.count = n;
+	entry.offset = this->file.pos();
+	entry.first_time = block->timestamps[0];
+	entry.last_time = block->timestamps[n - 1];
+
+	const qint64 ts_bytes = n * sizeof(qint64), col_bytes = n * sizeof(int16_t);
+	bool ok = this->file.write(reinterpret_cast<const char*>(block->timestamps), ts_bytes) == ts_bytes;
+	ok &= this->file.write(reinterpret_cast<const char*>(block->T), col_bytes) == col_bytes;
+	ok &= this->file.write(reinterpret_cast<const char*>(block->X), col_bytes) == col_bytes;
+	ok &= this->file.write(reinterpret_cast<const char*>(block->Y), col_bytes) == col_bytes;
+	ok &= this->file.write(reinterpret_cast<const char*>(block->Z), col_bytes) == col_bytes;
+	block->count = 0;
+	if (!ok) {
+		this->write_failed = true;
+		return false;
+	}
+	this->index.append(entry);
+	return true;
+}
+
+bool RecordingWriter::writePadding() {
+	static const char zeros[8] = {};
+	const int pad = (8 - this->file.pos() % 8) % 8;
+	if (pad == 0) {
+		return true;
+	}
+	const bool ok = this->file.write(zeros, pad) == pad;
+	this->write_failed |= !ok;
+	return ok;
+}
+
+/* RecordingReader */
+RecordingReader::RecordingReader() {}
+
+RecordingReader::~RecordingReader() { this->close(); }
+
+bool RecordingReader::open(const QString& path) {
+	this->close();
+	this->error.clear();
+
+	this->file.setFileName(path);
+	if (!this->file.open(QIODevice::ReadOnly)) {
+		return this->fail("Couldn't open recording file");
+	}
+	this->size = this->file.size();
+	if (this->size < (qint64)(sizeof(RecordingFileHeader) + sizeof(RecordingFileFooter))) {
+		return this->fail("Invalid recording file: too small");
+	}
+	// mapping is lazy, only the header, footer and index pages are touched here
+	this->data = this->file.map(0, this->size);
+	if (!this->data) {
+		return this->fail("Couldn't map recording file");
+	}
+
+	RecordingFileHeader header;
+	memcpy(&header, this->data, sizeof(header));
+	if (memcmp(header.magic, RECORDING_FILE_MAGIC, sizeof(header.magic)) != 0) {
+		return this->fail("Invalid recording file: bad magic");
+	}
+	if (header.version != RECORDING_FILE_VERSION) {
+		return this->fail("Invalid recording file: unsupported version");
+	}
+	this->init_time = header.init_time;
+
+	RecordingFileFooter footer;
+	memcpy(&footer, this->data + this->size - sizeof(footer), sizeof(footer));
+	if (memcmp(footer.magic, RECORDING_INDEX_MAGIC, sizeof(footer.magic)) != 0) {
+		return this->fail("Invalid recording file: no index, recording may be incomplete");
+	}
+	// offsets come from the file, compare against the remaining space instead of adding them up, a sum could wrap
+	const quint64 index_end = this->size - sizeof(footer);
+	if (footer.sensor_table_offset < sizeof(RecordingFileHeader) || footer.sensor_table_offset > footer.index_offset
+		|| footer.index_offset % 8 != 0 || footer.index_offset > index_end
+		|| index_end - footer.index_offset != (quint64)footer.block_count * sizeof(RecordingBlockIndex)) {
+		return this->fail("Invalid recording file: corrupted index");
+	}
+
+	const uchar* p = this->data + footer.sensor_table_offset;
+	const uchar* table_end = this->data + footer.index_offset;
+	for (quint32 i = 0; i < footer.sensor_count; i++) {
+		quint16 len;
+		if (p + sizeof(len) > table_end) {
+			return this->fail("Invalid recording file: corrupted sensor table");
+		}
+		memcpy(&len, p, sizeof(len));
+		p += sizeof(len);
+		if (p + len > table_end) {
+			return this->fail("Invalid recording file: corrupted sensor table");
+		}
+		this->sensor_keys.append(QString::fromUtf8(reinterpret_cast<const char*>(p), len));
+		p += len;
+	}
+
+	this->blocks.resize(footer.sensor_count);
+	this->sample_counts.fill(0, footer.sensor_count);
+	bool has_time = false;
+	const uchar* entry_ptr = this->data + footer.index_offset;
+	for (quint32 i = 0; i < footer.block_count; i++, entry_ptr += sizeof(RecordingBlockIndex)) {
+		RecordingBlockIndex entry;
+		memcpy(&entry, entry_ptr, sizeof(entry));
+		if (entry.sensor >= footer.sensor_count || entry.count == 0 || entry.offset % 8 != 0
+			|| entry.offset < sizeof(RecordingFileHeader) || entry.offset > footer.sensor_table_offset
+			|| entry.count > (footer.sensor_table_offset - entry.offset) / RECORDING_SAMPLE_BYTES) {
+			return this->fail("Invalid recording file: corrupted block index");
+		}
+		this->blocks[entry.sensor].append(entry);
+		this->sample_counts[entry.sensor] += entry.count;
+		if (!has_time || entry.first_time < this->first_time) {
+			this->first_time = entry.first_time;
+		}
+		if (!has_time || entry.last_time > this->last_time) {
+			this->last_time = entry.last_time;
+		}
+		has_time = true;
+	}
+	return true;
+}
+
+void RecordingReader::close() {
+	if (this->data) {
+		this->file.unmap(const_cast<uchar*>(this->data));
+		this->data = nullptr;
+	}
+	if (this->file.isOpen()) {
+		this->file.close();
+	}
+	this->size = 0;
+	this->init_time = this->first_time = this->last_time = 0;
+	this->sensor_keys.clear();
+	this->blocks.clear();
+	this->sample_counts.clear();
+}
+
+bool RecordingReader::isOpen() const { return this->data != nullptr; }
+
+qint64 RecordingReader::initTime() const { return this->init_time; }
+
+qint64 RecordingReader::firstTimestamp() const { return this->first_time; }
+
+qint64 RecordingReader::lastTimestamp() const { return this->last_time; }
+
+qint64 RecordingReader::fileSize() const { return this->size; }
+
+int RecordingReader::sensorCount() const { return this->sensor_keys.size(); }
+
+QString RecordingReader::sensorKey(int sensor) const { return this->sensor_keys.at(sensor); }
+
+qint64 RecordingReader::sampleCount(int sensor) const { return this->sample_counts.at(sensor); }
+
+const QVector<RecordingBlockIndex>& RecordingReader::sensorBlocks(int sensor) const { return this->blocks.at(sensor); }
+
+RecordingBlockView RecordingReader::block(const RecordingBlockIndex& index) const {
+	const uchar* base = this->data + index.offset;
+	const int n = index.count;
+	RecordingBlockView view;
+	view.timestamps = reinterpret_cast<const qint64*>(base);
+	view.T = reinterpret_cast<const int16_t*>(base + n * sizeof(qint64));
+	view.X = view.T + n;
+	view.Y = view.X + n;
+	view.Z = view.Y + n;
+	view.count = n;
+	return view;
+}
+
+QString RecordingReader::errorString() const { return this->error; }
+
+bool RecordingReader::fail(const QString& message) {
+	qWarning() << message << ": " << this->file.fileName();
+	this->close();
+	this->error = message;
+	return false;
+}
+
+/* RecordingCursor */
+RecordingCursor::RecordingCursor(QString key_, QVector<RecordingBlockView> blocks_)
+	: key(key_), blocks(blocks_), block_index(0), row(0) {
+	while (this->block_index < this->blocks.size() && this->blocks[this->block_index].count == 0) {
+		this->block_index++;
+	}
+}
+
+RecordingCursor::~RecordingCursor() {}
+
+bool RecordingCursor::hasNext() const { return this->block_index < this->blocks.size(); }
+
+qint64 RecordingCursor::peekTimestamp() const { return this->blocks[this->block_index].timestamps[this->row]; }
+
+void RecordingCursor::next(qint64& timestamp, int16_t& T, int16_t& X, int16_t& Y, int16_t& Z) {
+	const RecordingBlockView& view = this->blocks[this->block_index];
+	timestamp = view.timestamps[this->row];
+	T = view.T[this->row];
+	X = view.X[this->row];
+	Y = view.Y[this->row];
+	Z = view.Z[this->row];
+	if (++this->row >= view.count) {
+		this->row = 0;
+		do {
+			this->block_index++;
+		} while (this->block_index < this->blocks.size() && this->blocks[this->block_index].count == 0);
+	}
+}
+
+QString RecordingCursor::getKey() const { return this->key; }
+
+/* replay */
+bool loadRecordingCursors(const QString& path, RecordingReader& reader, QList<RecordingColumns*>& columns,
+						  QList<RecordingCursor*>& cursors, QString& error) {
+	if (path.endsWith(".json", Qt::CaseInsensitive)) {
+		RecordingColumnsBuilder builder;
+		JsonRecordingParser parser;
+		if (!parser.parseFile(path, builder)) {
+			error = QString("%1 (offset %2)").arg(parser.errorString()).arg(parser.errorOffset());
+			return false;
+		}
+		const QStringList keys = builder.keys();
+		columns = builder.takeColumns();
+		for (int i = 0; i < keys.size(); i++) {
+			const RecordingColumns* c = columns[i];
+			RecordingBlockView view = {c->timestamps.constData(), c->T.constData(), c->X.constData(),
+									   c->Y.constData(),		  c->Z.constData(), (int)c->timestamps.size()};
+			cursors.append(new RecordingCursor(keys[i], {view}));
+		}
+		return true;
+	}
+
+	if (!reader.open(path)) {
+		error = reader.errorString();
+		return false;
+	}
+	for (int sensor = 0; sensor < reader.sensorCount(); sensor++) {
+		QVector<RecordingBlockView> views;
+		views.reserve(reader.sensorBlocks(sensor).size());
+		for (const RecordingBlockIndex& index : reader.sensorBlocks(sensor)) {
+			views.append(reader.block(index));
+		}
+		cursors.append(new RecordingCursor(reader.sensorKey(sensor), views));
+	}
+	return true;
+}
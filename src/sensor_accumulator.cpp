@@ -0,0 +1,66 @@
+#include "sensor_accumulator.hpp"
+
+
+static_assert(std::atomic<int64_t>::is_always_lock_free, "SensorAccumulators needs lock free 64 bit atomics");
+
+SensorAccumulators::SensorAccumulators(int capacity_)
+	: capacity(qMax(1, capacity_)), sensor_slots(new Slot[qMax(1, capacity_)]), keys(qMax(1, capacity_)) {
+	for (int i = 0; i < capacity; i++) {
+		for (int axis = 0; axis < 3; axis++) {
+			sensor_slots[i].axis[axis].store(0, std::memory_order_relaxed);
+		}
+	}
+}
+
+SensorAccumulators::~SensorAccumulators() {}
+
+int SensorAccumulators::slot(const QString& key) {
+	auto it = sensor_ids.constFind(key);
+	if (it != sensor_ids.constEnd()) {
+		return it.value();
+	}
+	const int id = count.load(std::memory_order_relaxed);
+	if (id >= capacity) {
+		return -1;
+	}
+	keys[id] = key;
+	sensor_ids.insert(key, id);
+	count.store(id + 1, std::memory_order_release);
+	return id;
+}
+
+void SensorAccumulators::accumulate(int slot, int16_t X, int16_t Y, int16_t Z) {
+	if (slot < 0 || slot >= capacity) {
+		return;
+	}
+	const int64_t one = (int64_t)1 << SENSOR_ACCUMULATOR_COUNT_SHIFT;
+	Slot& s = sensor_slots[slot];
+	s.axis[0].fetch_add(one + X, std::memory_order_relaxed);
+	s.axis[1].fetch_add(one + Y, std::memory_order_relaxed);
+	s.axis[2].fetch_add(one + Z, std::memory_order_relaxed);
+}
+
+int SensorAccumulators::size() const { return count.load(std::memory_order_acquire); }
+
+QString SensorAccumulators::key(int slot) const { return keys[slot]; }
+
+bool SensorAccumulators::take(int slot, qreal& x, qreal& y, qreal& z) {
+	const int64_t half = (int64_t)1 << (SENSOR_ACCUMULATOR_COUNT_SHIFT - 1);
+	qreal means[3];
+	bool any = false;
+	for (int axis = 0; axis < 3; axis++) {
+		const int64_t word = sensor_slots[slot].axis[axis].exchange(0, std::memory_order_relaxed);
+		// the sum is signed, rounding the count undoes the borrow of a negative sum
+		const int64_t num = (word + half) >> SENSOR_ACCUMULATOR_COUNT_SHIFT;
+		const int64_t sum = word - (num << SENSOR_ACCUMULATOR_COUNT_SHIFT);
+		means[axis] = num > 0 ? (qreal)sum / num : 0;
+		any |= num > 0;
+	}
+	if (!any) {
+		return false;
+	}
+	x = means[0];
+	y = means[1];
+	z = means[2];
+	return true;
+}
@@ -0,0 +1,54 @@
+#include "sensor_pipeline.hpp"
+
+#include <QJsonArray>
+#include <QtMinMax>
+
+
+SensorConfig loadSensorConfig(Settings* settings, const QString& key) {
+	SensorConfig config = {true, 0, 0, ROT_0};
+	if (!settings->contains(key)) {
+		return config;
+	}
+	auto vars = settings->get(key).toArray();
+	if (vars.size() == 3) { // for backward compatibility
+		config.is_left = vars.at(2).toBool();
+	} else if (vars.size() == 4) {
+		config.is_left = vars.at(2).toBool();
+		config.rot = (Rotation)vars.at(3).toInt();
+	}
+	config.x = vars.at(0).toInt();
+	config.y = vars.at(1).toInt();
+	return config;
+}
+
+void orientSensorData(int16_t& X, int16_t& Y, bool is_left, Rotation rot) {
+	if (!is_left) {
+		X = -X;
+		Y = -Y;
+	}
+	switch (rot) { // clockwise
+		case ROT_90: {
+			int tmp = X;
+			X = Y;
+			Y = -tmp;
+			break;
+		}
+		case ROT_180: {
+			X = -X;
+			Y = -Y;
+			break;
+		}
+		case ROT_270: {
+			int tmp = X;
+			X = -Y;
+			Y = tmp;
+			break;
+		}
+		default: break;
+	}
+}
+
+int sensorSceneX(int x, bool is_left, int scene_width) {
+	x = qBound(0, x, scene_width / 2);
+	return is_left ? x : scene_width - x;
+}
@@ -2,7 +2,10 @@
 
 #include <QFile>
 
-Settings::Settings() : doc(new QJsonDocument()), obj(new QJsonObject()) { this->load(); }
+Settings::Settings(const QString& path_, bool read_only_)
+	: path(path_), read_only(read_only_), doc(new QJsonDocument()), obj(new QJsonObject()) {
+	this->load();
+}
 
 Settings::~Settings() {
 	this->save();
@@ -11,16 +14,16 @@ Settings::~Settings() {
 }
 
 void Settings::load() {
-	QFile file("settings.json");
+	QFile file(this->path);
 	if (!file.open(QIODevice::ReadOnly)) {
-		qWarning() << "Couldn't open settings.json";
+		qWarning() << "Couldn't open " << this->path;
 		return;
 	}
 
 	QJsonParseError error;
 	*doc = QJsonDocument::fromJson(file.readAll(), &error);
 	if (error.error != QJsonParseError::NoError) {
-		qWarning() << "Couldn't parse settings.json";
+		qWarning() << "Couldn't parse " << this->path;
 		return;
 	}
 
@@ -28,9 +31,12 @@ void Settings::load() {
 }
 
 void Settings::save() {
-	QFile file("settings.json");
+	if (this->read_only) {
+		return;
+	}
+	QFile file(this->path);
 	if (!file.open(QIODevice::WriteOnly)) {
-		qWarning() << "Couldn't open settings.json";
+		qWarning() << "Couldn't open " << this->path;
 		return;
 	}
 
@@ -0,0 +1,130 @@
+#include "trace_view.hpp"
+
+#include <QPainter>
+#include <QtMinMax>
+
+
+TraceView::TraceView(int capacity, FrameScheduler* scheduler, QWidget* parent)
+	: QWidget(parent), worker(new TraceWorker(&store)), render_thread(new QThread()), scheduler(scheduler) {
+	this->store.capacity = qMax(1, capacity);
+	this->setAttribute(Qt::WA_OpaquePaintEvent);
+
+	this->worker->moveToThread(this->render_thread);
+	connect(this, &TraceView::sig_render, this->worker, &TraceWorker::render, Qt::QueuedConnection);
+	connect(this->worker, &TraceWorker::frameReady, this, &TraceView::frameReady, Qt::QueuedConnection);
+	this->render_thread->start();
+}
+
+TraceView::~TraceView() {
+	this->render_thread->quit();
+	this->render_thread->wait();
+	delete this->worker;
+	delete this->render_thread;
+	qDeleteAll(this->store.rings);
+}
+
+void TraceView::append(const QString& key, qint64 timestamp, int16_t X, int16_t Y, int16_t Z) {
+	QMutexLocker locker(&this->store.mutex);
+	TraceRing* ring = this->store.rings.value(key);
+	if (!ring) {
+		ring = new TraceRing();
+		ring->timestamps.resize(this->store.capacity);
+		for (int axis = 0; axis < 3; axis++) {
+			ring->values[axis].resize(this->store.capacity);
+		}
+		ring->head = ring->count = 0;
+		this->store.rings.insert(key, ring);
+		this->store.keys.append(key);
+		this->store.keys.sort();
+	}
+	if (ring->count == 0 || timestamp > ring->latest_time) {
+		ring->latest_time = timestamp;
+	}
+	ring->timestamps[ring->head] = timestamp;
+	ring->values[0][ring->head] = X;
+	ring->values[1][ring->head] = Y;
+	ring->values[2][ring->head] = Z;
+	ring->head = ring->head + 1 == this->store.capacity ? 0 : ring->head + 1;
+	if (ring->count < this->store.capacity) {
+		ring->count++;
+	}
+	this->markDirty();
+}
+
+void TraceView::clearSensor(const QString& key) {
+	QMutexLocker locker(&this->store.mutex);
+	TraceRing* ring = this->store.rings.value(key);
+	if (ring) {
+		ring->head = ring->count = 0;
+	}
+	this->markDirty();
+}
+
+void TraceView::clear() {
+	QMutexLocker locker(&this->store.mutex);
+	qDeleteAll(this->store.rings);
+	this->store.rings.clear();
+	this->store.keys.clear();
+	this->markDirty();
+}
+
+void TraceView::setTraceLayout(TraceLayout layout_) {
+	this->layout = layout_;
+	this->markDirty();
+}
+
+TraceLayout TraceView::traceLayout() const { return this->layout; }
+
+void TraceView::setWindowMs(qint64 window_ms_) {
+	this->window_ms = qMax<qint64>(1, window_ms_);
+	this->markDirty();
+}
+
+void TraceView::paintEvent(QPaintEvent* event) {
+	QPainter painter(this);
+	if (this->frame.isNull()) {
+		painter.fillRect(this->rect(), Qt::black);
+		return;
+	}
+	painter.drawImage(0, 0, this->frame);
+}
+
+void TraceView::resizeEvent(QResizeEvent* event) {
+	QWidget::resizeEvent(event);
+	this->markDirty();
+}
+
+void TraceView::showEvent(QShowEvent* event) {
+	QWidget::showEvent(event);
+	this->markDirty();
+}
+
+void TraceView::requestFrame() {
+	if (!this->isVisible() || this->render_busy) {
+		return;
+	}
+	if (!this->dirty && this->frame.size() == this->size()) {
+		return;
+	}
+	this->dirty = false;
+	this->render_busy = true;
+	emit sig_render(this->size(), this->layout, this->window_ms);
+}
+
+void TraceView::frameReady(const QImage& frame_) {
+	this->render_busy = false;
+	this->frame = frame_;
+	this->update();
+	// changes that came in while rendering were skipped by requestFrame
+	if (this->dirty) {
+		this->markDirty();
+	}
+}
+
+void TraceView::markDirty() {
+	this->dirty = true;
+	// hidden, showEvent schedules the first frame
+	if (this->isVisible()) {
+		this->scheduler->markDirty(FRAME_VIEW_TRACE);
+	}
+}
@@ -0,0 +1,121 @@
+#include "window_minmax.hpp"
+
+#include <QtMinMax>
+
+
+/* WindowMinMax */
+WindowMinMax::WindowMinMax(int window) { this->setWindow(window); }
+
+WindowMinMax::~WindowMinMax() {}
+
+void WindowMinMax::setWindow(int window_) {
+	this->window = qMax(1, window_);
+	this->min_deque.ring.resize(this->window);
+	this->max_deque.ring.resize(this->window);
+	this->clear();
+}
+
+void WindowMinMax::push(qreal value) {
+	const qint64 seq = this->next_seq++;
+	const qint64 oldest_seq = seq - this->window + 1;
+	expire(this->min_deque, oldest_seq);
+	expire(this->max_deque, oldest_seq);
+
+	// values that can never be the minimum (maximum) again are dropped from the back
+	while (this->min_deque.count && back(this->min_deque).value >= value) {
+		this->min_deque.count--;
+	}
+	pushBack(this->min_deque, {seq, value});
+	while (this->max_deque.count && back(this->max_deque).value <= value) {
+		this->max_deque.count--;
+	}
+	pushBack(this->max_deque, {seq, value});
+}
+
+void WindowMinMax::clear() {
+	this->min_deque.head = this->min_deque.count = 0;
+	this->max_deque.head = this->max_deque.count = 0;
+}
+
+bool WindowMinMax::isEmpty() const { return this->min_deque.count == 0; }
+
+qreal WindowMinMax::min() const { return front(this->min_deque).value; }
+
+qreal WindowMinMax::max() const { return front(this->max_deque).value; }
+
+void WindowMinMax::expire(Deque& deque, qint64 oldest_seq) {
+	while (deque.count && front(deque).seq < oldest_seq) {
+		deque.head = deque.head + 1 == deque.ring.size() ? 0 : deque.head + 1;
+		deque.count--;
+	}
+}
+
+void WindowMinMax::pushBack(Deque& deque, const Entry& entry) {
+	int tail = deque.head + deque.count;
+	if (tail >= deque.ring.size()) {
+		tail -= deque.ring.size();
+	}
+	deque.ring[tail] = entry;
+	deque.count++;
+}
+
+const WindowMinMax::Entry& WindowMinMax::front(const Deque& deque) { return deque.ring[deque.head]; }
+
+const WindowMinMax::Entry& WindowMinMax::back(const Deque& deque) {
+	int tail = deque.head + deque.count - 1;
+	if (tail >= deque.ring.size()) {
+		tail -= deque.ring.size();
+	}
+	return deque.ring[tail];
+}
+
+/* WindowHistogram */
+WindowHistogram::WindowHistogram(int window) : coarse(256), fine(65536) { this->setWindow(window); }
+
+WindowHistogram::~WindowHistogram() {}
+
+void WindowHistogram::setWindow(int window) {
+	this->values.resize(qMax(1, window));
+	this->clear();
+}
+
+void WindowHistogram::push(int16_t value) {
+	const int capacity = this->values.size();
+	if (this->count == capacity) {
+		const int old_bin = this->values[this->head] + 32768;
+		this->coarse[old_bin >> 8]--;
+		this->fine[old_bin]--;
+		this->head = this->head + 1 == capacity ? 0 : this->head + 1;
+		this->count--;
+	}
+	int tail = this->head + this->count;
+	if (tail >= capacity) {
+		tail -= capacity;
+	}
+	this->values[tail] = value;
+	this->count++;
+	const int bin = value + 32768;
+	this->coarse[bin >> 8]++;
+	this->fine[bin]++;
+}
+
+void WindowHistogram::clear() {
+	this->head = this->count = 0;
+	this->coarse.fill(0);
+	this->fine.fill(0);
+}
+
+int WindowHistogram::size() const { return this->count; }
+
+int16_t WindowHistogram::quantile(qreal q) const {
+	int rank = qBound(0, (int)(q * (this->count - 1) + 0.5), this->count - 1);
+	int c = 0;
+	for (; c < 255 && rank >= this->coarse[c]; c++) {
+		rank -= this->coarse[c];
+	}
+	int bin = c << 8;
+	for (; bin < (c << 8) + 255 && rank >= this->fine[bin]; bin++) {
+		rank -= this->fine[bin];
+	}
+	return bin - 32768;
+}
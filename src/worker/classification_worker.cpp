@@ -5,6 +5,8 @@
 #include <QFileInfo>
 #include <algorithm>
 #include <chrono>
+#include <cmath>
+#include <cstring>
 #include <fstream>
 
 /*
@@ -19,26 +21,43 @@ The given SavedModel SignatureDef contains the following output(s):
 	  shape: (-1, 2)
 	  name: StatefulPartitionedCall:0
 Method name is: tensorflow/serving/predict
+
+Streaming with TensorFlow uses the step model of model/model.py create_step_model:
+  inputs  serving_default_step_frame (1, 5, 3), serving_default_step_h (1, units), serving_default_step_c (1, units)
+  outputs StatefulPartitionedCall:0 = step_c, :1 = step_h, :2 = step_probs
 */
 
 
 /* Helper function */
-template <typename T, typename A>
-int argmax(std::vector<T, A> const& vec) {
-	return static_cast<int>(std::distance(vec.begin(), max_element(vec.begin(), vec.end())));
+// index of the largest of the probabilities that have a label, -1 without any
+static int argmaxLabel(const float* probs, int num_outputs, int num_labels) {
+	const int n = std::min(num_outputs, num_labels);
+	return n > 0 ? std::max_element(probs, probs + n) - probs : -1;
+}
+
+// a reading at its place in a (sensors, features) frame, windows are timesteps of these frames back to back
+static inline void putReading(float* frame, int sensor, const ClassificationDataPoint& point) {
+	frame[sensor * CLASSIFICATION_NUM_FEATURES + 0] = point.X;
+	frame[sensor * CLASSIFICATION_NUM_FEATURES + 1] = point.Y;
+	frame[sensor * CLASSIFICATION_NUM_FEATURES + 2] = point.Z;
 }
 
 /* ClassificationWorker */
 ClassificationWorker::ClassificationWorker(QObject* parent) : QObject(parent) {
+#ifdef WITH_TENSORFLOW
 	this->graph = nullptr;
 	this->session = nullptr;
+	this->input_op = {nullptr, 0};
+	this->output_op = {nullptr, 0};
 	this->status = TF_NewStatus();
 	this->run_options = TF_NewBuffer();
 	this->run_metadata = TF_NewBuffer();
+#endif
 	this->labels.clear();
 	this->labels.reserve(10);
 
 	connect(this, &ClassificationWorker::sig_classify, this, &ClassificationWorker::classify, Qt::QueuedConnection);
+	connect(this, &ClassificationWorker::sig_step, this, &ClassificationWorker::step, Qt::QueuedConnection);
 
 	this->data_queue[0].reserve(max_data_size);
 	this->data_queue[1].reserve(max_data_size);
@@ -46,6 +65,7 @@ ClassificationWorker::ClassificationWorker(QObject* parent) : QObject(parent) {
 }
 
 ClassificationWorker::~ClassificationWorker() {
+#ifdef WITH_TENSORFLOW
 	if (this->session) {
 		TF_CloseSession(this->session, this->status);
 		TF_DeleteSession(this->session, this->status);
@@ -53,35 +73,40 @@ ClassificationWorker::~ClassificationWorker() {
 	if (this->graph) {
 		TF_DeleteGraph(this->graph);
 	}
+	for (TF_Tensor* tensor : this->input_tensors) {
+		TF_DeleteTensor(tensor);
+	}
+	for (TF_Tensor* tensor : this->batch_tensors) {
+		TF_DeleteTensor(tensor);
+	}
+	for (TF_Tensor* tensor : {this->step_frame, this->step_state[0], this->step_state[1]}) {
+		if (tensor) {
+			TF_DeleteTensor(tensor);
+		}
+	}
 	TF_DeleteStatus(this->status);
 	TF_DeleteBuffer(this->run_options);
 	TF_DeleteBuffer(this->run_metadata);
+#endif
 }
 
-void ClassificationWorker::init(std::string model_path, std::string label_path) {
-	const char* tags[] = {"serve"};
-
-	this->graph = TF_NewGraph();
-	if (!this->graph) {
-		qDebug() << "Failed to create graph";
-		return;
-	}
-	TF_SessionOptions* session_options = TF_NewSessionOptions();
-	if (!session_options) {
-		qDebug() << "Failed to create session options";
-		return;
-	}
-	TF_SetConfig(session_options, nullptr, 0, this->status);
-	if (TF_GetCode(this->status) != TF_OK) {
-		qDebug() << "Failed to set session options: " << TF_Message(this->status);
-		return;
-	}
-	this->session = TF_LoadSessionFromSavedModel(session_options, this->run_options, model_path.c_str(), tags, 1,
-												 this->graph, this->run_metadata, this->status);
-	if (TF_GetCode(this->status) != TF_OK) {
-		qDebug() << "Failed to load model: " << TF_Message(this->status);
-		TF_DeleteSessionOptions(session_options);
+void ClassificationWorker::init(std::string model_path, std::string label_path, ClassificationMode mode,
+								ClassificationBackend backend) {
+	this->m_mode = mode;
+	this->m_backend = backend;
+	if (backend == CLASSIFICATION_BACKEND_NATIVE) {
+		if (!this->initNative(model_path)) {
+			return;
+		}
+	} else {
+#ifdef WITH_TENSORFLOW
+		if (!this->initTensorflow(model_path)) {
+			return;
+		}
+#else
+		qDebug() << "Built without TensorFlow, use the native backend";
 		return;
+#endif
 	}
 
 	std::ifstream label_file(label_path);
@@ -94,105 +119,556 @@ void ClassificationWorker::init(std::string model_path, std::string label_path)
 		this->labels.push_back(QString::fromStdString(line));
 	}
 	label_file.close();
+	if (this->engine.isLoaded() && this->engine.outputSize() != this->labels.size()) {
+		qDebug() << "Model has " << this->engine.outputSize() << " outputs for " << this->labels.size() << " labels";
+	}
+}
+
+bool ClassificationWorker::initNative(const std::string& weights_path) {
+	if (!this->engine.load(QString::fromStdString(weights_path))) {
+		qDebug() << "Failed to load weights: " << this->engine.errorString();
+		return false;
+	}
+	if (this->engine.inputSize() != CLASSIFICATION_NUM_SENSORS * CLASSIFICATION_NUM_FEATURES) {
+		qDebug() << "Weights expect " << this->engine.inputSize() << " inputs per timestep, expected: "
+				 << CLASSIFICATION_NUM_SENSORS * CLASSIFICATION_NUM_FEATURES;
+		this->engine = LstmEngine();
+		return false;
+	}
+	// reused by every run, the window size covers a single frame too
+	this->native_input.assign(this->max_data_size * this->engine.inputSize(), 0.0f);
+	this->native_probs.assign(this->engine.outputSize(), 0.0f);
+	this->native_h.assign(this->engine.units(), 0.0f);
+	this->native_c.assign(this->engine.units(), 0.0f);
+	this->stream_pending.reserve(this->max_data_size * CLASSIFICATION_NUM_SENSORS);
+	this->stream_work.reserve(this->max_data_size * CLASSIFICATION_NUM_SENSORS);
+	qDebug() << "Native classification, kernel: " << LstmEngine::kernelName(this->engine.kernel());
+	return true;
 }
 
+bool ClassificationWorker::isReady() const {
+	if (this->labels.isEmpty()) {
+		return false;
+	}
+	if (this->m_backend == CLASSIFICATION_BACKEND_NATIVE) {
+		return this->engine.isLoaded();
+	}
+#ifdef WITH_TENSORFLOW
+	const bool ops =
+		this->m_mode == CLASSIFICATION_MODE_STREAMING ? this->step_frame != nullptr : this->input_op.oper != nullptr;
+	return this->graph && this->session && ops;
+#else
+	return false;
+#endif
+}
+
+ClassificationMode ClassificationWorker::mode() const { return this->m_mode; }
+
+ClassificationBackend ClassificationWorker::backend() const { return this->m_backend; }
+
+bool ClassificationWorker::setNativeCheck(const std::string& weights_path) {
+	if (this->m_backend != CLASSIFICATION_BACKEND_TENSORFLOW) {
+		qDebug() << "Native check needs the TensorFlow backend";
+		return false;
+	}
+	this->native_check = this->initNative(weights_path);
+	this->native_check_max_diff = 0;
+	this->native_check_runs = this->native_check_mismatches = 0;
+	return this->native_check;
+}
+
+float ClassificationWorker::nativeCheckMaxDiff() const { return this->native_check_max_diff; }
+
+int ClassificationWorker::nativeCheckRuns() const { return this->native_check_runs; }
+
+int ClassificationWorker::nativeCheckMismatches() const { return this->native_check_mismatches; }
+
 void ClassificationWorker::addData(QString key, float X, float Y, float Z) {
+	if (this->m_mode == CLASSIFICATION_MODE_STREAMING) {
+		this->addStreamData(key, X, Y, Z);
+		return;
+	}
 	bool is_avaliable = __atomic_load_n(&this->data_queue_available[this->data_queue_index], std::memory_order_acquire);
 	if (!is_avaliable) {
 		return;
 	}
-	ClassificationDataPoint data = {X, Y, Z};
-	if (this->data_queue[this->data_queue_index].contains(key)) {
-		this->data_queue[this->data_queue_index][key].push_back(data);
-	} else {
-		this->data_queue[this->data_queue_index][key] = {data};
-	}
-	if (this->data_queue[this->data_queue_index][key].size() >= this->max_data_size) {
+	// emptied in place by classify, so the vectors keep their capacity between windows
+	QVector<ClassificationDataPoint>& samples = this->data_queue[this->data_queue_index][key];
+	samples.push_back({X, Y, Z});
+	if (samples.size() >= this->max_data_size) {
 		emit sig_classify(this->data_queue_index);
 		this->data_queue_index = (this->data_queue_index + 1) % 2;
 	}
 }
 
 void ClassificationWorker::classify(int index) {
-	if (!this->graph || !this->session) {
-		qDebug() << "Graph or session is not initialized";
+	if (!this->isReady()) {
+		qDebug() << "Classification backend is not initialized";
 		return;
 	}
 	__atomic_store_n(&this->data_queue_available[index], false, std::memory_order_release);
-	if (this->data_queue[index].size() == 0) {
+	ClassificationQueue& queue = this->data_queue[index];
+	const int num_sessions = this->collectSessions(queue);
+	if (num_sessions == 0) {
 		qDebug() << "No data to classify";
+	}
+
+	/*
+	All insoles of this slot go through the model together, one batch per group of similar window lengths. A
+	session gives up at most CLASSIFICATION_BUCKET_SLACK of its newest timesteps to join a batch, the windows of a
+	batch are cut to the shortest one.
+	*/
+	this->result_sessions.clear();
+	this->result_labels.clear();
+	auto start_time = std::chrono::high_resolution_clock::now();
+	for (int first = 0, last; first < num_sessions; first = last) {
+		last = first + 1;
+		while (last < num_sessions
+			   && this->sessions[last].timesteps >= this->sessions[first].timesteps - CLASSIFICATION_BUCKET_SLACK) {
+			last++;
+		}
+		const int batch = last - first;
+		const int timesteps = this->sessions[last - 1].timesteps;
+		const int frame_size = CLASSIFICATION_NUM_SENSORS * CLASSIFICATION_NUM_FEATURES;
+		float* input_data = this->windowInput(batch, timesteps);
+		for (int b = 0; b < batch; b++) {
+			const ClassificationSession& session = this->sessions[first + b];
+			// (timesteps, sensors, features) like the samples of model/train.py and the streaming frames
+			float* window = input_data + b * timesteps * frame_size;
+			for (int i = 0; i < CLASSIFICATION_NUM_SENSORS; i++) {
+				const ClassificationDataPoint* samples = session.sensors[i].value().constData();
+				for (int j = 0; j < timesteps; j++) {
+					putReading(window + j * frame_size, i, samples[j]);
+				}
+			}
+		}
+		// qDebug() << "batch: " << batch << " timesteps: " << timesteps;
+		this->batch_results.resize(batch);
+		if (!this->runWindow(input_data, batch, timesteps, this->batch_results.data())) {
+			continue;
+		}
+		for (int b = 0; b < batch; b++) {
+			if (this->batch_results[b] >= 0) {
+				const QString& result = this->labels[this->batch_results[b]];
+				this->result_sessions.append(this->sessions[first + b].id.toString());
+				this->result_labels.append(result);
+				emit sig_classificationResult(result);
+				// qDebug() << "Classification result: " << this->sessions[first + b].id << result;
+			}
+		}
+	}
+	auto end_time = std::chrono::high_resolution_clock::now();
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+	// qDebug() << "Classification time: " << duration << " us, " << num_sessions << " sessions";
+	if (!this->result_labels.isEmpty()) {
+		emit sig_classificationResults(this->result_sessions, this->result_labels);
+	}
+
+	// clear data queue, sensors that reported keep their capacity for the next window and silent ones are dropped
+	for (auto it = queue.begin(); it != queue.end();) {
+		if (it.value().isEmpty()) {
+			it = queue.erase(it);
+		} else {
+			it.value().clear();
+			++it;
+		}
+	}
+	__atomic_store_n(&this->data_queue_available[index], true, std::memory_order_release);
+}
+
+// groups the sensors of the queue into this->sessions, longest window first, and returns the usable ones
+int ClassificationWorker::collectSessions(ClassificationQueue& queue) {
+	this->sessions.clear();
+	for (auto it = queue.begin(); it != queue.end(); ++it) {
+		if (it.value().isEmpty()) {
+			continue; // kept from an earlier window, the sensor did not report in this one
+		}
+		const int separator = it.key().lastIndexOf('_');
+		const QStringView id = separator < 0 ? QStringView() : QStringView(it.key()).left(separator);
+		auto session = std::find_if(this->sessions.begin(), this->sessions.end(),
+									[&id](const ClassificationSession& s) { return s.id == id; });
+		if (session == this->sessions.end()) {
+			this->sessions.push_back({id, {}, 0, this->max_data_size});
+			session = this->sessions.end() - 1;
+		}
+		// sensors in key order without copying the keys, the n-th sensor of every insole is the same input
+		if (session->num_sensors < CLASSIFICATION_NUM_SENSORS) {
+			int i = session->num_sensors;
+			for (; i > 0 && it.key() < session->sensors[i - 1].key(); i--) {
+				session->sensors[i] = session->sensors[i - 1];
+			}
+			session->sensors[i] = it;
+		}
+		session->num_sensors++;
+		session->timesteps = std::min(session->timesteps, (int)it.value().size());
+	}
+
+	auto unusable = [this](const ClassificationSession& session) {
+		if (session.num_sensors != CLASSIFICATION_NUM_SENSORS) {
+			qDebug() << "Invalid sensor number: " << session.num_sensors << " of " << session.id
+					 << ", expected: " << CLASSIFICATION_NUM_SENSORS;
+			return true;
+		}
+		return session.timesteps == 0;
+	};
+	this->sessions.erase(std::remove_if(this->sessions.begin(), this->sessions.end(), unusable),
+						 this->sessions.end());
+	std::sort(this->sessions.begin(), this->sessions.end(),
+			  [](const ClassificationSession& a, const ClassificationSession& b) {
+				  return a.timesteps != b.timesteps ? a.timesteps > b.timesteps : a.id < b.id;
+			  });
+	return this->sessions.size();
+}
+
+void ClassificationWorker::classifyCurrentSlot() {
+	if (this->m_mode == CLASSIFICATION_MODE_STREAMING) {
 		return;
 	}
-	TF_Output input_op = {TF_GraphOperationByName(this->graph, "serving_default_tb_input"), 0};
-	TF_Output output_op = {TF_GraphOperationByName(this->graph, "StatefulPartitionedCall"), 0};
-	if (input_op.oper == nullptr || output_op.oper == nullptr) {
-		qDebug() << "Failed to get input/output operations";
+	// every sensor that reported in this window needs a few readings, empty entries are left over from the last one
+	bool ready = false;
+	const ClassificationQueue& queue = this->data_queue[this->data_queue_index];
+	for (auto it = queue.begin(); it != queue.end(); ++it) {
+		if (it.value().isEmpty()) {
+			continue;
+		}
+		if (it.value().size() < 5) {
+			return;
+		}
+		ready = true;
+	}
+	if (ready) {
+		emit sig_classify(this->data_queue_index);
+		this->data_queue_index = (this->data_queue_index + 1) % 2;
+	}
+}
+
+/*
+A frame is complete once every sensor reported since the previous one, a sensor reporting twice only keeps its
+latest reading. This lines up the n-th readings of all sensors the same way a window does.
+
+Streaming follows the sensors of one insole. A new sensor of that insole, or another insole once this one went
+max_data_size readings without completing a frame, starts over with new keys and a fresh LSTM state.
+*/
+void ClassificationWorker::addStreamData(const QString& key, float X, float Y, float Z) {
+	this->stream_stalled++;
+	int sensor = this->stream_keys.indexOf(key);
+	if (sensor < 0) {
+		const int separator = key.lastIndexOf('_');
+		const QStringView id = separator < 0 ? QStringView() : QStringView(key).left(separator);
+		if (this->stream_keys.isEmpty() || id != this->stream_id) {
+			if (!this->stream_keys.isEmpty() && this->stream_stalled < this->max_data_size) {
+				return; // another insole while this one is still streaming
+			}
+			this->stream_keys.clear();
+			this->stream_id = id.toString();
+		} else if (this->stream_keys.size() >= CLASSIFICATION_NUM_SENSORS) {
+			// a sensor was replaced, its successor is collected from scratch with the other ones
+			this->stream_keys.clear();
+		}
+		// sensor order changes, the frames and the LSTM state so far no longer line up
+		this->stream_keys.append(key);
+		std::sort(this->stream_keys.begin(), this->stream_keys.end());
+		sensor = this->stream_keys.indexOf(key);
+		this->stream_seen = 0;
+		this->stream_stalled = 0;
+		QMutexLocker locker(&this->stream_mutex);
+		this->stream_pending.clear();
+		this->stream_reset = true;
+	}
+	this->stream_frame[sensor] = {X, Y, Z};
+	this->stream_seen |= 1 << sensor;
+	if (this->stream_seen != (1 << CLASSIFICATION_NUM_SENSORS) - 1) {
 		return;
 	}
+	this->stream_seen = 0;
+	this->stream_stalled = 0;
+
+	QMutexLocker locker(&this->stream_mutex);
+	this->stream_pending.insert(this->stream_pending.end(), this->stream_frame,
+								this->stream_frame + CLASSIFICATION_NUM_SENSORS);
+	if (!this->stream_posted) {
+		this->stream_posted = true;
+		locker.unlock();
+		emit sig_step();
+	}
+}
 
-	// prepare input data
-	const int num_sensors = 5;
-	const int num_features = 3;
-	if (this->data_queue[index].size() != num_sensors) {
-		qDebug() << "Invalid sensor number: " << this->data_queue[index].size() << ", expected: " << num_sensors;
+void ClassificationWorker::step() {
+	if (!this->isReady()) {
 		return;
 	}
-	int timesteps = INT_MAX;
-	for (auto it : this->data_queue[index]) {
-		timesteps = std::min(timesteps, (int)it.size());
+	// frames keep arriving while the LSTM runs, only the swap is under the lock
+	bool reset;
+	this->stream_work.clear();
+	this->stream_mutex.lock();
+	std::swap(this->stream_work, this->stream_pending);
+	reset = this->stream_reset;
+	this->stream_reset = false;
+	this->stream_posted = false;
+	this->stream_mutex.unlock();
+
+	if (reset) {
+		this->resetState();
 	}
-	if (timesteps == INT_MAX) {
-		qDebug() << "No data to classify";
+	const int num_frames = this->stream_work.size() / CLASSIFICATION_NUM_SENSORS;
+	if (num_frames == 0) {
 		return;
 	}
-	// qDebug() << "timesteps: " << timesteps;
-	const int64_t dims[] = {1, timesteps, num_sensors, num_features};
-	TF_Tensor* input_tensor =
-		TF_AllocateTensor(TF_FLOAT, dims, 4, sizeof(float) * timesteps * num_sensors * num_features);
-	float* input_data = static_cast<float*>(TF_TensorData(input_tensor));
-	auto keys = this->data_queue[index].keys();
-	std::sort(keys.begin(), keys.end());
-	for (int i = 0; i < num_sensors; i++) {
-		auto key = keys[i];
-		for (int j = 0; j < timesteps; j++) {
-			input_data[i * timesteps * num_features + j * num_features + 0] = this->data_queue[index][key][j].X;
-			input_data[i * timesteps * num_features + j * num_features + 1] = this->data_queue[index][key][j].Y;
-			input_data[i * timesteps * num_features + j * num_features + 2] = this->data_queue[index][key][j].Z;
-		}
-	}
-	TF_Tensor* output_tensor = TF_AllocateTensor(TF_FLOAT, nullptr, 0, sizeof(float) * this->labels.size());
+
+	int result = -1;
+	float* frame = this->stepInput();
 	auto start_time = std::chrono::high_resolution_clock::now();
-	TF_SessionRun(this->session, this->run_options, &input_op, &input_tensor, 1, &output_op, &output_tensor, 1, nullptr,
-				  0, nullptr, this->status);
+	for (int i = 0; i < num_frames; i++) {
+		const ClassificationDataPoint* samples = this->stream_work.data() + i * CLASSIFICATION_NUM_SENSORS;
+		for (int sensor = 0; sensor < CLASSIFICATION_NUM_SENSORS; sensor++) {
+			putReading(frame, sensor, samples[sensor]);
+		}
+		result = this->runStep(frame);
+		if (result < 0) {
+			return;
+		}
+	}
 	auto end_time = std::chrono::high_resolution_clock::now();
-	auto duration = std::chrono::duration_cast<std::chrono::milliseconds>(end_time - start_time).count();
-	// qDebug() << "Classification time: " << duration << " ms";
+	auto duration = std::chrono::duration_cast<std::chrono::microseconds>(end_time - start_time).count();
+	// qDebug() << "Step time: " << duration / num_frames << " us x " << num_frames;
+
+	// only the newest frame is worth showing, older ones were already superseded while the LSTM ran
+	emit sig_classificationResult(this->labels[result]);
+	this->result_sessions.clear();
+	this->result_labels.clear();
+	this->result_sessions.append(QString());
+	this->result_labels.append(this->labels[result]);
+	emit sig_classificationResults(this->result_sessions, this->result_labels);
+}
+
+/* backends */
+float* ClassificationWorker::windowInput(int batch, int timesteps) {
+#ifdef WITH_TENSORFLOW
+	if (this->m_backend == CLASSIFICATION_BACKEND_TENSORFLOW) {
+		if (batch == 1) {
+			return static_cast<float*>(TF_TensorData(this->input_tensors[timesteps - 1]));
+		}
+		// every batch shape is allocated once and kept, like the single window tensors
+		TF_Tensor*& tensor = this->batch_tensors[batch * 256 + timesteps];
+		if (!tensor) {
+			const int64_t dims[] = {batch, timesteps, CLASSIFICATION_NUM_SENSORS, CLASSIFICATION_NUM_FEATURES};
+			tensor = TF_AllocateTensor(TF_FLOAT, dims, 4,
+									   sizeof(float) * batch * timesteps * CLASSIFICATION_NUM_SENSORS
+										   * CLASSIFICATION_NUM_FEATURES);
+		}
+		return static_cast<float*>(TF_TensorData(tensor));
+	}
+#endif
+	const size_t size = (size_t)batch * timesteps * CLASSIFICATION_NUM_SENSORS * CLASSIFICATION_NUM_FEATURES;
+	if (this->native_input.size() < size) {
+		this->native_input.resize(size);
+	}
+	return this->native_input.data();
+}
+
+float* ClassificationWorker::stepInput() {
+#ifdef WITH_TENSORFLOW
+	if (this->m_backend == CLASSIFICATION_BACKEND_TENSORFLOW) {
+		return static_cast<float*>(TF_TensorData(this->step_frame));
+	}
+#endif
+	return this->native_input.data();
+}
+
+// batch windows of timesteps frames, every frame sensors * features floats as putReading writes them
+bool ClassificationWorker::runWindow(const float* input, int batch, int timesteps, int* results) {
+#ifdef WITH_TENSORFLOW
+	if (this->m_backend == CLASSIFICATION_BACKEND_TENSORFLOW) {
+		return this->runTensorflowWindow(input, batch, timesteps, results);
+	}
+#endif
+	// the weights stay in cache across the windows, so one window after the other is as good as a batch here
+	const int window_size = timesteps * this->engine.inputSize();
+	for (int b = 0; b < batch; b++) {
+		this->engine.run(input + b * window_size, timesteps, this->native_probs.data());
+		results[b] = argmaxLabel(this->native_probs.data(), this->native_probs.size(), this->labels.size());
+	}
+	return true;
+}
+
+int ClassificationWorker::runStep(const float* frame) {
+#ifdef WITH_TENSORFLOW
+	if (this->m_backend == CLASSIFICATION_BACKEND_TENSORFLOW) {
+		return this->runTensorflowStep(frame);
+	}
+#endif
+	this->engine.step(frame, this->native_h.data(), this->native_c.data());
+	this->engine.classify(this->native_h.data(), this->native_probs.data());
+	return argmaxLabel(this->native_probs.data(), this->native_probs.size(), this->labels.size());
+}
+
+void ClassificationWorker::resetState() {
+	std::fill(this->native_h.begin(), this->native_h.end(), 0.0f);
+	std::fill(this->native_c.begin(), this->native_c.end(), 0.0f);
+#ifdef WITH_TENSORFLOW
+	for (TF_Tensor* state : this->step_state) {
+		if (state) {
+			memset(TF_TensorData(state), 0, TF_TensorByteSize(state));
+		}
+	}
+#endif
+}
+
+// probs came from TensorFlow, native_probs holds LstmEngine's answer to the same input
+int ClassificationWorker::compareNative(const float* probs, int num_outputs) {
+	const int result = argmaxLabel(probs, num_outputs, this->labels.size());
+	const int n = std::min(num_outputs, (int)this->native_probs.size());
+	for (int i = 0; i < n; i++) {
+		this->native_check_max_diff = std::max(this->native_check_max_diff, std::abs(probs[i] - this->native_probs[i]));
+	}
+	this->native_check_runs++;
+	if (result != argmaxLabel(this->native_probs.data(), this->native_probs.size(), this->labels.size())) {
+		this->native_check_mismatches++;
+	}
+	return result;
+}
+
+#ifdef WITH_TENSORFLOW
+bool ClassificationWorker::initTensorflow(const std::string& model_path) {
+	const char* tags[] = {"serve"};
+
+	this->graph = TF_NewGraph();
+	if (!this->graph) {
+		qDebug() << "Failed to create graph";
+		return false;
+	}
+	TF_SessionOptions* session_options = TF_NewSessionOptions();
+	if (!session_options) {
+		qDebug() << "Failed to create session options";
+		return false;
+	}
+	TF_SetConfig(session_options, nullptr, 0, this->status);
 	if (TF_GetCode(this->status) != TF_OK) {
-		qDebug() << "Failed to run session: " << TF_Message(this->status);
-		TF_DeleteTensor(input_tensor);
-		TF_DeleteTensor(output_tensor);
-		return;
+		qDebug() << "Failed to set session options: " << TF_Message(this->status);
+		TF_DeleteSessionOptions(session_options);
+		return false;
+	}
+	this->session = TF_LoadSessionFromSavedModel(session_options, this->run_options, model_path.c_str(), tags, 1,
+												 this->graph, this->run_metadata, this->status);
+	TF_DeleteSessionOptions(session_options);
+	if (TF_GetCode(this->status) != TF_OK) {
+		qDebug() << "Failed to load model: " << TF_Message(this->status);
+		this->session = nullptr;
+		return false;
 	}
+	return this->m_mode == CLASSIFICATION_MODE_STREAMING ? this->initTensorflowStreaming()
+														 : this->initTensorflowWindow();
+}
 
-	// get output
-	std::vector<float> output_data(this->labels.size());
-	memcpy(output_data.data(), TF_TensorData(output_tensor), this->labels.size() * sizeof(float));
-	QString result = this->labels[argmax(output_data)];
-	emit sig_classificationResult(result);
-	// qDebug() << "Classification result: " << result;
+bool ClassificationWorker::initTensorflowWindow() {
+	this->input_op = {TF_GraphOperationByName(this->graph, "serving_default_tb_input"), 0};
+	this->output_op = {TF_GraphOperationByName(this->graph, "StatefulPartitionedCall"), 0};
+	if (this->input_op.oper == nullptr || this->output_op.oper == nullptr) {
+		qDebug() << "Failed to get input/output operations";
+		return false;
+	}
+	// TF_SessionRun leaves the inputs to the caller, so every timestep count keeps its tensor for good
+	for (int timesteps = 1; timesteps <= this->max_data_size; timesteps++) {
+		const int64_t dims[] = {1, timesteps, CLASSIFICATION_NUM_SENSORS, CLASSIFICATION_NUM_FEATURES};
+		this->input_tensors.push_back(TF_AllocateTensor(
+			TF_FLOAT, dims, 4, sizeof(float) * timesteps * CLASSIFICATION_NUM_SENSORS * CLASSIFICATION_NUM_FEATURES));
+	}
+	return true;
+}
 
-	TF_DeleteTensor(input_tensor);
-	TF_DeleteTensor(output_tensor);
+bool ClassificationWorker::initTensorflowStreaming() {
+	const char* input_names[] = {"serving_default_step_frame", "serving_default_step_h", "serving_default_step_c"};
+	for (int i = 0; i < 3; i++) {
+		this->step_inputs[i] = {TF_GraphOperationByName(this->graph, input_names[i]), 0};
+		this->step_outputs[i] = {TF_GraphOperationByName(this->graph, "StatefulPartitionedCall"), i};
+		if (this->step_inputs[i].oper == nullptr || this->step_outputs[i].oper == nullptr) {
+			qDebug() << "Failed to get step input/output operations, is this model_step.pb?";
+			return false;
+		}
+	}
+	int64_t state_dims[2];
+	TF_GraphGetTensorShape(this->graph, this->step_inputs[1], state_dims, 2, this->status);
+	if (TF_GetCode(this->status) != TF_OK || state_dims[1] <= 0) {
+		qDebug() << "Failed to get LSTM state size: " << TF_Message(this->status);
+		return false;
+	}
+	const int64_t frame_dims[] = {1, CLASSIFICATION_NUM_SENSORS, CLASSIFICATION_NUM_FEATURES};
+	this->step_frame = TF_AllocateTensor(TF_FLOAT, frame_dims, 3,
+										 sizeof(float) * CLASSIFICATION_NUM_SENSORS * CLASSIFICATION_NUM_FEATURES);
+	state_dims[0] = 1;
+	for (int i = 0; i < 2; i++) {
+		this->step_state[i] = TF_AllocateTensor(TF_FLOAT, state_dims, 2, sizeof(float) * state_dims[1]);
+		memset(TF_TensorData(this->step_state[i]), 0, TF_TensorByteSize(this->step_state[i]));
+	}
+	this->stream_pending.reserve(this->max_data_size * CLASSIFICATION_NUM_SENSORS);
+	this->stream_work.reserve(this->max_data_size * CLASSIFICATION_NUM_SENSORS);
+	return true;
+}
 
-	// clear data queue
-	this->data_queue[index].clear();
-	__atomic_store_n(&this->data_queue_available[index], true, std::memory_order_release);
+bool ClassificationWorker::runTensorflowWindow(const float* input, int batch, int timesteps, int* results) {
+	// the C API always hands back a tensor it allocated itself, there is no way to run into a preallocated one
+	TF_Tensor* input_tensor = batch == 1 ? this->input_tensors[timesteps - 1]
+										 : this->batch_tensors.value(batch * 256 + timesteps);
+	TF_Tensor* output_tensor = nullptr;
+	TF_SessionRun(this->session, this->run_options, &this->input_op, &input_tensor, 1, &this->output_op,
+				  &output_tensor, 1, nullptr, 0, nullptr, this->status);
+	if (TF_GetCode(this->status) != TF_OK) {
+		qDebug() << "Failed to run session: " << TF_Message(this->status);
+		if (output_tensor) {
+			TF_DeleteTensor(output_tensor);
+		}
+		return false;
+	}
+
+	// get output, read in place and scattered back per window
+	const float* output_data = static_cast<const float*>(TF_TensorData(output_tensor));
+	const int num_outputs = TF_TensorByteSize(output_tensor) / sizeof(float) / batch;
+	const int window_size = timesteps * CLASSIFICATION_NUM_SENSORS * CLASSIFICATION_NUM_FEATURES;
+	for (int b = 0; b < batch; b++) {
+		const float* probs = output_data + b * num_outputs;
+		if (this->native_check) {
+			this->engine.run(input + b * window_size, timesteps, this->native_probs.data());
+			results[b] = this->compareNative(probs, num_outputs);
+		} else {
+			results[b] = argmaxLabel(probs, num_outputs, this->labels.size());
+		}
+	}
+	TF_DeleteTensor(output_tensor);
+	return true;
 }
 
-void ClassificationWorker::classifyCurrentSlot() {
-	if (this->data_queue[this->data_queue_index].size() > 0
-		&& this->data_queue[this->data_queue_index].begin()->size() >= 5) {
-		emit sig_classify(this->data_queue_index);
-		this->data_queue_index = (this->data_queue_index + 1) % 2;
+int ClassificationWorker::runTensorflowStep(const float* frame) {
+	TF_Tensor* inputs[3] = {this->step_frame, this->step_state[0], this->step_state[1]};
+	TF_Tensor* outputs[3] = {nullptr, nullptr, nullptr};
+	TF_SessionRun(this->session, this->run_options, this->step_inputs, inputs, 3, this->step_outputs, outputs, 3,
+				  nullptr, 0, nullptr, this->status);
+	if (TF_GetCode(this->status) != TF_OK) {
+		qDebug() << "Failed to run step: " << TF_Message(this->status);
+		for (TF_Tensor* output : outputs) {
+			if (output) {
+				TF_DeleteTensor(output);
+			}
+		}
+		return -1;
+	}
+
+	// the new state becomes the next input, TF allocated it so it is released like any other tensor
+	TF_DeleteTensor(this->step_state[0]);
+	TF_DeleteTensor(this->step_state[1]);
+	this->step_state[0] = outputs[1];
+	this->step_state[1] = outputs[0];
+
+	const float* probs = static_cast<const float*>(TF_TensorData(outputs[2]));
+	const int num_outputs = TF_TensorByteSize(outputs[2]) / sizeof(float);
+	int result;
+	if (this->native_check) {
+		this->engine.step(frame, this->native_h.data(), this->native_c.data());
+		this->engine.classify(this->native_h.data(), this->native_probs.data());
+		result = this->compareNative(probs, num_outputs);
+	} else {
+		result = argmaxLabel(probs, num_outputs, this->labels.size());
 	}
+	TF_DeleteTensor(outputs[2]);
+	return result;
 }
+#endif
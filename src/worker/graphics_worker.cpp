@@ -9,22 +9,20 @@ GraphicsWorker::~GraphicsWorker() {}
 void GraphicsWorker::updateGraphicsData() {
 	MainWindow* main_window = (MainWindow*)this->main_window;
 
-	std::vector<std::tuple<QString, qreal>> heatmap_data;
+	// reused every frame, arrows, heatmap and center of pressure are all computed from it on the render thread
+	this->samples.clear();
 
-	main_window->graphics_mutex.lock();
-	for (auto key : main_window->graphics_data.keys()) {
-		auto data = main_window->graphics_data[key];
-		data = std::make_tuple(std::get<0>(data) / 600, std::get<1>(data) / 600, std::get<2>(data) / 600);
-		auto num = main_window->graphics_data_num[key];
-		if (num > 0) {
-			main_window->graphicsManager->setArrowPointingToScalar(key, std::get<0>(data) / num,
-																   std::get<1>(data) / num);
-			// main_window->graphicsManager->setDefaultSphereColorScalar(key, std::get<2>(data) / num);
-			heatmap_data.emplace_back(key, std::get<2>(data) / num);
+	SensorAccumulators& accumulators = main_window->graphics_accumulators;
+	const int num_of_sensors = accumulators.size();
+	for (int slot = 0; slot < num_of_sensors; slot++) {
+		qreal x, y, z;
+		if (accumulators.take(slot, x, y, z)) {
+			this->samples.push_back(
+				{accumulators.key(slot), x / SENSOR_VALUE_SCALE, y / SENSOR_VALUE_SCALE, z / SENSOR_VALUE_SCALE});
 		}
-		main_window->graphics_data[key] = std::make_tuple(0.0, 0.0, 0.0);
-		main_window->graphics_data_num[key] = 0;
 	}
-	main_window->graphics_mutex.unlock();
-	main_window->graphicsManager->setDefaultSphereColorScalarBatch(heatmap_data);
+	main_window->graphicsManager->submitSamples(this->samples);
+	if (main_window->graphicsManager->isHeatmapSettling()) {
+		main_window->frame_scheduler->markDirty(FRAME_VIEW_GRAPHICS);
+	}
 }
\ No newline at end of file
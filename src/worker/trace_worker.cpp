@@ -0,0 +1,186 @@
+#include "worker/trace_worker.hpp"
+
+#include <QPainter>
+#include <QtMath>
+#include <QtMinMax>
+
+
+static const QRgb trace_background = qRgb(0, 0, 0);
+static const QRgb trace_grid = qRgb(60, 60, 60);
+static const QRgb trace_axis_colors[3] = {qRgb(255, 0, 0), qRgb(0, 255, 0), qRgb(0, 128, 255)}; // same as the charts
+
+TraceWorker::TraceWorker(TraceStore* store, QObject* parent) : QObject(parent), store(store) {}
+
+TraceWorker::~TraceWorker() {}
+
+void TraceWorker::render(QSize size, int layout, qint64 window_ms) {
+	if (size.isEmpty() || window_ms <= 0) {
+		return;
+	}
+	QImage image(size, QImage::Format_RGB32);
+	image.fill(trace_background);
+	// traces are written straight into the pixels, the painter only adds grid and labels once they are all done
+	QPainter painter;
+
+	if (layout == TRACE_LAYOUT_OVERLAY) {
+		const int row_height = size.height() / 3;
+		this->reduce(size.width(), window_ms);
+		const int num_sensors = this->keys.size();
+		for (int axis = 0; axis < 3; axis++) {
+			const QRect rect(0, axis * row_height, size.width(), row_height - 1);
+			int lo = 0, hi = 0;
+			bool any = false;
+			for (int s = 0; s < num_sensors; s++) {
+				const TraceColumns& trace = this->columns[s * 3 + axis];
+				if (trace.any) {
+					lo = any ? qMin(lo, (int)trace.lo) : trace.lo;
+					hi = any ? qMax(hi, (int)trace.hi) : trace.hi;
+					any = true;
+				}
+			}
+			for (int s = 0; s < num_sensors; s++) {
+				const QRgb color = QColor::fromHsv(s * 360 / qMax(1, num_sensors), 200, 255).rgb();
+				this->drawTrace(image, rect, this->columns[s * 3 + axis], lo, hi, color);
+			}
+		}
+		painter.begin(&image);
+		painter.setFont(QFont("Arial", 8));
+		for (int axis = 0; axis < 3; axis++) {
+			const QRect rect(0, axis * row_height, size.width(), row_height - 1);
+			painter.setPen(QColor(trace_grid));
+			painter.drawLine(rect.bottomLeft(), rect.bottomRight());
+			painter.setPen(QColor(trace_axis_colors[axis]));
+			painter.drawText(rect.adjusted(4, 2, 0, 0), Qt::AlignLeft | Qt::AlignTop,
+							 QString("Value %1").arg(QChar("XYZ"[axis])));
+		}
+		painter.end();
+		emit frameReady(image);
+		return;
+	}
+
+	// small multiples, grid shaped after the image aspect ratio
+	int num_sensors;
+	{
+		QMutexLocker locker(&this->store->mutex);
+		num_sensors = this->store->keys.size();
+	}
+	const int grid_cols = qMax(1, qCeil(qSqrt(qMax(1, num_sensors) * (qreal)size.width() / size.height())));
+	const int grid_rows = qMax(1, (qMax(1, num_sensors) + grid_cols - 1) / grid_cols);
+	const int cell_width = size.width() / grid_cols, cell_height = size.height() / grid_rows;
+	this->reduce(qMax(1, cell_width - 2), window_ms);
+	// a sensor added after counting waits for the next frame
+	const int num_cells = qMin((int)this->keys.size(), grid_cols * grid_rows);
+	for (int s = 0; s < num_cells; s++) {
+		const QRect cell((s % grid_cols) * cell_width, (s / grid_cols) * cell_height, cell_width, cell_height);
+		const QRect rect = cell.adjusted(1, 1, -1, -1);
+		int lo = 0, hi = 0;
+		bool any = false;
+		for (int axis = 0; axis < 3; axis++) {
+			const TraceColumns& trace = this->columns[s * 3 + axis];
+			if (trace.any) {
+				lo = any ? qMin(lo, (int)trace.lo) : trace.lo;
+				hi = any ? qMax(hi, (int)trace.hi) : trace.hi;
+				any = true;
+			}
+		}
+		for (int axis = 0; axis < 3; axis++) {
+			this->drawTrace(image, rect, this->columns[s * 3 + axis], lo, hi, trace_axis_colors[axis]);
+		}
+	}
+	painter.begin(&image);
+	painter.setFont(QFont("Arial", 8));
+	for (int s = 0; s < num_cells; s++) {
+		const QRect cell((s % grid_cols) * cell_width, (s / grid_cols) * cell_height, cell_width, cell_height);
+		painter.setPen(QColor(trace_grid));
+		painter.drawRect(cell.adjusted(0, 0, -1, -1));
+		painter.setPen(Qt::white);
+		painter.drawText(cell.adjusted(4, 2, -1, -1), Qt::AlignLeft | Qt::AlignTop, this->keys[s]);
+	}
+	painter.end();
+	emit frameReady(image);
+}
+
+void TraceWorker::reduce(int width, qint64 window_ms) {
+	// only the column reduction runs under the lock, rasterizing works on the reduced columns
+	QMutexLocker locker(&this->store->mutex);
+	this->keys = this->store->keys;
+	this->columns.resize(this->keys.size() * 3);
+
+	for (int s = 0; s < this->keys.size(); s++) {
+		const TraceRing* ring = this->store->rings.value(this->keys[s]);
+		// every sensor ends at its own latest sample, a late clock or a recalibrated one would fall out of the window
+		const qint64 start_time = ring ? ring->latest_time - window_ms : 0;
+		for (int axis = 0; axis < 3; axis++) {
+			TraceColumns& trace = this->columns[s * 3 + axis];
+			trace.min.resize(width);
+			trace.max.resize(width);
+			trace.has.fill(false, width);
+			trace.any = false;
+			if (!ring) {
+				continue;
+			}
+			const int capacity = ring->timestamps.size();
+			// newest to oldest, stop at the start of the window
+			for (int i = 0; i < ring->count; i++) {
+				int idx = ring->head - 1 - i;
+				if (idx < 0) {
+					idx += capacity;
+				}
+				const qint64 t = ring->timestamps[idx];
+				if (t < start_time) {
+					break;
+				}
+				const int col = qMin(width - 1, (int)((t - start_time) * width / window_ms));
+				const int16_t v = ring->values[axis][idx];
+				if (!trace.has[col]) {
+					trace.min[col] = trace.max[col] = v;
+					trace.has[col] = true;
+				} else {
+					trace.min[col] = qMin(trace.min[col], v);
+					trace.max[col] = qMax(trace.max[col], v);
+				}
+				trace.lo = trace.any ? qMin(trace.lo, v) : v;
+				trace.hi = trace.any ? qMax(trace.hi, v) : v;
+				trace.any = true;
+			}
+		}
+	}
+}
+
+void TraceWorker::drawTrace(QImage& image, QRect rect, const TraceColumns& trace, int lo, int hi, QRgb color) const {
+	rect = rect.intersected(image.rect());
+	if (!trace.any || rect.height() < 2) {
+		return;
+	}
+	// 10% padding like the charts, at least one unit so a flat trace sits in the middle
+	const int padding = qMax(1, (hi - lo) / 10);
+	lo -= padding;
+	hi += padding;
+	const qreal scale = (qreal)(rect.height() - 1) / (hi - lo);
+	const int bottom = rect.bottom();
+	const int columns = qMin((int)trace.has.size(), rect.width());
+	const qsizetype stride = image.bytesPerLine() / sizeof(QRgb);
+	QRgb* bits = (QRgb*)image.bits();
+
+	int prev_top = -1, prev_bottom = -1;
+	for (int c = 0; c < columns; c++) {
+		if (!trace.has[c]) {
+			continue;
+		}
+		int top = bottom - qRound((trace.max[c] - lo) * scale);
+		int bot = bottom - qRound((trace.min[c] - lo) * scale);
+		// stretch the span to touch the previous column so the trace stays connected
+		if (prev_top >= 0) {
+			top = qMin(top, prev_bottom);
+			bot = qMax(bot, prev_top);
+		}
+		prev_top = bottom - qRound((trace.max[c] - lo) * scale);
+		prev_bottom = bottom - qRound((trace.min[c] - lo) * scale);
+		top = qMax(top, rect.top());
+		bot = qMin(bot, bottom);
+		QRgb* pixel = bits + top * stride + rect.left() + c;
+		for (int y = top; y <= bot; y++, pixel += stride) {
+			*pixel = color;
+		}
+	}
+}
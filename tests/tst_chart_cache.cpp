@@ -0,0 +1,119 @@
+#include "chart_cache.hpp"
+
+#include <QTemporaryDir>
+#include <QtTest>
+
+
+class TestChartCache : public QObject {
+	Q_OBJECT
+
+private:
+	QTemporaryDir dir;
+
+	static ChartCacheConfig config(int capacity, int display_target) {
+		ChartCacheConfig config;
+		config.capacity = capacity;
+		config.display_target = display_target;
+		config.fixed_lo = -SENSOR_VALUE_SCALE;
+		config.fixed_hi = SENSOR_VALUE_SCALE;
+		config.percentile = 1;
+		for (int i = 0; i < 3; i++) {
+			config.decimation[i] = CHART_DECIMATION_MINMAX;
+			config.autoscale[i] = CHART_AUTOSCALE_WINDOWED;
+		}
+		return config;
+	}
+
+private slots:
+	void initTestCase() { QVERIFY(dir.isValid()); }
+
+	void configDefaults() {
+		Settings settings(dir.filePath("missing.json"), true);
+		const ChartCacheConfig config = loadChartCacheConfig(&settings);
+		QCOMPARE(config.capacity, CHART_DEFAULT_WINDOW_SIZE);
+		QCOMPARE(config.fixed_lo, (qreal)-SENSOR_VALUE_SCALE);
+		QCOMPARE(config.fixed_hi, (qreal)SENSOR_VALUE_SCALE);
+		QCOMPARE(config.percentile, 1.0);
+		for (int i = 0; i < 3; i++) {
+			QCOMPARE(config.decimation[i], CHART_DECIMATION_MINMAX);
+			QCOMPARE(config.autoscale[i], CHART_AUTOSCALE_WINDOWED);
+		}
+	}
+
+	// one value for all charts or one per X/Y/Z chart
+	void configPerChart() {
+		Settings settings(dir.filePath("missing.json"), true);
+		settings.set("chart_window_size", 1);
+		settings.set("chart_decimation", QJsonArray({"lttb", "none", "bogus"}));
+		settings.set("chart_autoscale", "percentile");
+		settings.set("chart_fixed_range", QJsonArray({-5, 5}));
+		settings.set("chart_percentile", 2.5);
+		const ChartCacheConfig config = loadChartCacheConfig(&settings);
+		QCOMPARE(config.capacity, 2);
+		QCOMPARE(config.decimation[0], CHART_DECIMATION_LTTB);
+		QCOMPARE(config.decimation[1], CHART_DECIMATION_NONE);
+		QCOMPARE(config.decimation[2], CHART_DECIMATION_MINMAX);
+		for (int i = 0; i < 3; i++) {
+			QCOMPARE(config.autoscale[i], CHART_AUTOSCALE_PERCENTILE);
+		}
+		QCOMPARE(config.fixed_lo, -5.0);
+		QCOMPARE(config.fixed_hi, 5.0);
+		QCOMPARE(config.percentile, 2.5);
+	}
+
+	// a late sample is dropped instead of restarting the window of every chart
+	void appendKeepsTimeOrder() {
+		ChartSensorCache cache(config(4, 0));
+		QVERIFY(cache.isEmpty());
+		for (int i = 0; i < 6; i++) {
+			QVERIFY(cache.append(i * 0.01, i, -i, 10 * i));
+		}
+		QVERIFY(!cache.append(0.05, 0, 0, 1000));
+		QVERIFY(!cache.append(0.03, 0, 0, 1000));
+		QCOMPARE(cache.series(2).size(), 4);
+		QCOMPARE(cache.firstTime(), 0.02);
+		QCOMPARE(cache.lastTime(), 0.05);
+
+		qreal lo, hi;
+		QVERIFY(cache.range(1).range(lo, hi));
+		QCOMPARE(lo, -5.0);
+		QCOMPARE(hi, -2.0);
+		QVERIFY(cache.range(2).range(lo, hi));
+		QCOMPARE(lo, 20.0);
+		QCOMPARE(hi, 50.0);
+	}
+
+	void clearResetsRanges() {
+		ChartSensorCache cache(config(10, 0));
+		cache.append(1, 1, 2, 3);
+		cache.clear();
+		QVERIFY(cache.isEmpty());
+		qreal lo, hi;
+		for (int i = 0; i < 3; i++) {
+			QVERIFY(!cache.range(i).range(lo, hi));
+		}
+		// times start over after a clear, e.g. a new recording
+		QVERIFY(cache.append(0, 1, 2, 3));
+	}
+
+	void displayTargetPerChart() {
+		ChartCacheConfig decimated = config(1000, 0);
+		decimated.decimation[1] = CHART_DECIMATION_NONE;
+		ChartSensorCache cache(decimated);
+		cache.setDisplayTarget(50);
+		for (int i = 0; i < 1000; i++) {
+			cache.append(i * 0.001, i % 13, i % 13, i % 13);
+		}
+		QVERIFY(cache.series(0).displaySize() <= 50);
+		QCOMPARE(cache.series(1).displaySize(), 1000);
+		QVERIFY(cache.series(2).displaySize() <= 50);
+
+		// a wider chart gets more points
+		cache.setDisplayTarget(200);
+		QVERIFY(cache.series(0).displaySize() > 50);
+		QVERIFY(cache.series(0).displaySize() <= 200);
+	}
+};
+
+QTEST_APPLESS_MAIN(TestChartCache)
+#include "tst_chart_cache.moc"
@@ -0,0 +1,109 @@
+#include "chart_decimation.hpp"
+
+#include <QtTest>
+
+
+class TestChartDecimation : public QObject {
+	Q_OBJECT
+
+private:
+	// deterministic noise with a few spikes, one point per ms
+	static QList<QPointF> signal(int n) {
+		QList<QPointF> points;
+		quint32 state = 1;
+		for (int i = 0; i < n; i++) {
+			state = state * 1664525u + 1013904223u;
+			points.append(QPointF(i, (int)(state >> 22) - 512));
+		}
+		points[n / 3].setY(20000);
+		points[2 * n / 3].setY(-20000);
+		return points;
+	}
+
+	static bool sortedByX(const QList<QPointF>& points) {
+		for (int i = 1; i < points.size(); i++) {
+			if (points[i].x() < points[i - 1].x()) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+private slots:
+	void fromString() {
+		QCOMPARE(chartDecimationFromString("LTTB"), CHART_DECIMATION_LTTB);
+		QCOMPARE(chartDecimationFromString("none"), CHART_DECIMATION_NONE);
+		QCOMPARE(chartDecimationFromString("bogus", CHART_DECIMATION_NONE), CHART_DECIMATION_NONE);
+	}
+
+	void fewPointsAreCopied() {
+		const QList<QPointF> points = signal(50);
+		QList<QPointF> out;
+		decimateMinMax(points.constData(), points.size(), 100, out);
+		QCOMPARE(out, points);
+		decimateLttb(points.constData(), points.size(), 100, out);
+		QCOMPARE(out, points);
+	}
+
+	void minMaxKeepsExtremes() {
+		const QList<QPointF> points = signal(10000);
+		QList<QPointF> out;
+		decimateMinMax(points.constData(), points.size(), 200, out);
+		QVERIFY(out.size() <= 200);
+		QVERIFY(sortedByX(out));
+		QVERIFY(out.contains(points[10000 / 3]));
+		QVERIFY(out.contains(points[2 * 10000 / 3]));
+		// every output point is an input point, nothing is interpolated
+		for (const QPointF& point : out) {
+			QCOMPARE(points[(int)point.x()], point);
+		}
+	}
+
+	// buckets follow x, not the index, so a gap in time is not filled by the neighbours
+	void minMaxKeepsGaps() {
+		QList<QPointF> points;
+		for (int i = 0; i < 500; i++) {
+			points.append(QPointF(i, i % 7));
+		}
+		for (int i = 0; i < 500; i++) {
+			points.append(QPointF(9500 + i, i % 5));
+		}
+		QList<QPointF> out;
+		decimateMinMax(points.constData(), points.size(), 100, out);
+		QVERIFY(out.size() <= 100);
+		int inside_gap = 0;
+		for (const QPointF& point : out) {
+			inside_gap += point.x() >= 500 && point.x() < 9500;
+		}
+		QCOMPARE(inside_gap, 0);
+		// the two short runs get the few buckets that cover them
+		QVERIFY(out.size() <= 12);
+	}
+
+	void lttbKeepsEndpoints() {
+		const QList<QPointF> points = signal(10000);
+		QList<QPointF> out;
+		decimateLttb(points.constData(), points.size(), 300, out);
+		QCOMPARE(out.size(), (qsizetype)300);
+		QVERIFY(sortedByX(out));
+		QCOMPARE(out.first(), points.first());
+		QCOMPARE(out.last(), points.last());
+		// a spike is the largest triangle of its bucket
+		QVERIFY(out.contains(points[10000 / 3]));
+		QVERIFY(out.contains(points[2 * 10000 / 3]));
+	}
+
+	void reusesOutput() {
+		const QList<QPointF> points = signal(1000);
+		QList<QPointF> out;
+		decimate(CHART_DECIMATION_MINMAX, points, 100, out);
+		const qsizetype capacity = out.capacity();
+		decimate(CHART_DECIMATION_MINMAX, points, 100, out);
+		QCOMPARE(out.capacity(), capacity);
+		decimate(CHART_DECIMATION_NONE, points.mid(0, 50), 100, out);
+		QCOMPARE(out.size(), (qsizetype)50);
+	}
+};
+
+QTEST_APPLESS_MAIN(TestChartDecimation)
+#include "tst_chart_decimation.moc"
@@ -0,0 +1,138 @@
+#include "chart_series_buffer.hpp"
+
+#include <QtTest>
+
+
+class TestChartSeriesBuffer : public QObject {
+	Q_OBJECT
+
+private:
+	// everything the renderer would show after a full resync
+	static QList<QPointF> shown(ChartSeriesBuffer& buffer) {
+		int removed;
+		QList<QPointF> points;
+		buffer.resyncDisplay();
+		buffer.takeDisplayChanges(removed, points);
+		return points;
+	}
+
+private slots:
+	void windowSlides() {
+		ChartSeriesBuffer buffer(5);
+		for (int i = 0; i < 8; i++) {
+			buffer.append(i, i * 10);
+		}
+		QCOMPARE(buffer.size(), 5);
+		QCOMPARE(buffer.first(), QPointF(3, 30));
+		QCOMPARE(buffer.last(), QPointF(7, 70));
+		QCOMPARE(buffer.at(2), QPointF(5, 50));
+	}
+
+	void xRegressionStartsOver() {
+		ChartSeriesBuffer buffer(5);
+		for (int i = 0; i < 4; i++) {
+			buffer.append(10 + i, i);
+		}
+		QVERIFY(buffer.append(14, 4));
+		QVERIFY(!buffer.append(0, 1));
+		QCOMPARE(buffer.size(), 1);
+		QCOMPARE(buffer.first(), QPointF(0, 1));
+	}
+
+	void incrementalChanges() {
+		ChartSeriesBuffer buffer(4);
+		int removed;
+		QList<QPointF> appended;
+		for (int i = 0; i < 4; i++) {
+			buffer.append(i, i);
+		}
+		QVERIFY(!buffer.takeDisplayChanges(removed, appended));
+		QCOMPARE(appended.size(), (qsizetype)4);
+
+		buffer.append(4, 4);
+		buffer.append(5, 5);
+		QVERIFY(buffer.takeDisplayChanges(removed, appended));
+		QCOMPARE(removed, 2);
+		QCOMPARE(appended, QList<QPointF>({QPointF(4, 4), QPointF(5, 5)}));
+	}
+
+	void minMaxKeepsSpikes() {
+		ChartSeriesBuffer buffer(100);
+		buffer.setDecimation(CHART_DECIMATION_MINMAX, 10);
+		for (int i = 0; i < 100; i++) {
+			buffer.append(i, i == 37 ? 1000 : i == 61 ? -1000 : 0);
+		}
+		const QList<QPointF> points = shown(buffer);
+		QVERIFY(points.size() <= 2 * 10);
+		QVERIFY(points.contains(QPointF(37, 1000)));
+		QVERIFY(points.contains(QPointF(61, -1000)));
+	}
+
+	// without a usable target the raw points stream through, nothing is rebuilt per append
+	void smallTargetStaysIncremental() {
+		for (int target : {0, 3}) {
+			ChartSeriesBuffer buffer(8);
+			buffer.setDecimation(CHART_DECIMATION_MINMAX, target);
+			int removed;
+			QList<QPointF> appended;
+			for (int i = 0; i < 20; i++) {
+				buffer.append(i, i);
+			}
+			buffer.takeDisplayChanges(removed, appended);
+			buffer.append(20, 20);
+			QVERIFY(buffer.takeDisplayChanges(removed, appended));
+			QCOMPARE(removed, 1);
+			QCOMPARE(appended, QList<QPointF>({QPointF(20, 20)}));
+		}
+		// the same holds for a window without a time span yet
+		ChartSeriesBuffer buffer(100);
+		buffer.setDecimation(CHART_DECIMATION_LTTB, 10);
+		int removed;
+		QList<QPointF> appended;
+		for (int i = 0; i < 20; i++) {
+			buffer.append(0, i);
+		}
+		buffer.takeDisplayChanges(removed, appended);
+		buffer.append(0, 20);
+		QVERIFY(buffer.takeDisplayChanges(removed, appended));
+		QCOMPARE(appended.size(), (qsizetype)1);
+	}
+
+	// a bucket that gets more points than the window holds must not read the evicted ones back
+	void minMaxBucketLargerThanCapacity() {
+		ChartSeriesBuffer buffer(16);
+		buffer.setDecimation(CHART_DECIMATION_MINMAX, 4);
+		for (int i = 0; i < 8; i++) {
+			buffer.append(i, 0);
+		}
+		// all in one bucket, the minimum is the first point and is long gone when the bucket closes
+		for (int i = 0; i < 40; i++) {
+			buffer.append(40, i == 0 ? -5 : i == 20 ? 7 : 1);
+		}
+		buffer.append(50, 0);
+		QCOMPARE(buffer.first().x(), 40.0);
+		QCOMPARE(shown(buffer), QList<QPointF>({QPointF(40, -5), QPointF(40, 7)}));
+	}
+
+	void lttbBucketLargerThanCapacity() {
+		ChartSeriesBuffer buffer(16);
+		buffer.setDecimation(CHART_DECIMATION_LTTB, 4);
+		for (int i = 0; i < 8; i++) {
+			buffer.append(i, i);
+		}
+		for (int i = 0; i < 40; i++) {
+			buffer.append(40, i);
+		}
+		for (int i = 0; i < 40; i++) {
+			buffer.append(60, -i);
+		}
+		buffer.append(80, 0);
+		for (const QPointF& point : shown(buffer)) {
+			QVERIFY(point.x() >= buffer.first().x());
+			QVERIFY(point.x() <= buffer.last().x());
+		}
+	}
+};
+
+QTEST_APPLESS_MAIN(TestChartSeriesBuffer)
+#include "tst_chart_series_buffer.moc"
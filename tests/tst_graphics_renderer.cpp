@@ -0,0 +1,94 @@
+#include "graphics_renderer.hpp"
+
+#include <QtTest>
+#include <algorithm>
+
+
+class TestGraphicsRenderer : public QObject {
+	Q_OBJECT
+
+private:
+	static bool blank(const GraphicsFrame& frame) {
+		const uint32_t zero = HEATMAP_COLORMAP_TABLES[HEATMAP_COLORMAP_YELLOW_RED][0];
+		const uint32_t* pixels = (const uint32_t*)frame.heatmap.constBits();
+		return std::all_of(pixels, pixels + frame.heatmap.width() * frame.heatmap.height(),
+						   [zero](uint32_t pixel) { return pixel == zero; });
+	}
+
+private slots:
+	void configDefaults() {
+		const GraphicsRendererConfig config = loadGraphicsRendererConfig(nullptr);
+		QCOMPARE(config.blur_radius, 0);
+		QCOMPARE(config.temporal, HEATMAP_TEMPORAL_NONE);
+		QCOMPARE(config.field, HEATMAP_FIELD_OFF);
+		QCOMPARE(config.cop_trail_length, COP_DEFAULT_TRAIL_LENGTH);
+	}
+
+	void snapshotCopiesFrame() {
+		GraphicsRenderer renderer(200, 100);
+		renderer.addSensor("a", 20, 50, 20, 50, true);
+		GraphicsFrame frame;
+		renderer.snapshot(frame);
+		QCOMPARE(frame.heatmap.width(), 200 / GRAPHICS_CELL_SIZE);
+		QCOMPARE(frame.heatmap.height(), 100 / GRAPHICS_CELL_SIZE);
+
+		renderer.process({{"a", 0.5, -2, 1}, {"unknown", 1, 1, 1}}, 16);
+		renderer.snapshot(frame);
+		QCOMPARE(frame.arrows.size(), (size_t)1);
+		QCOMPARE(frame.arrows[0], QLineF(20, 50, 20 + GRAPHICS_ARROW_LENGTH / 2, 50 - GRAPHICS_ARROW_LENGTH));
+		QVERIFY(frame.dirty.contains(20 / GRAPHICS_CELL_SIZE, 50 / GRAPHICS_CELL_SIZE));
+		QVERIFY(!blank(frame));
+		QVERIFY(frame.cop_valid[COP_FOOT_LEFT]);
+		QVERIFY(!frame.cop_valid[COP_FOOT_RIGHT]);
+		QCOMPARE(frame.cop[COP_FOOT_LEFT].size(), (size_t)1);
+		QCOMPARE(frame.cop[COP_FOOT_LEFT][0], QPointF(20, 50));
+
+		// nothing changed since the frame the GUI took
+		renderer.snapshot(frame);
+		QVERIFY(frame.dirty.isEmpty());
+	}
+
+	// the dot goes away with the data, the trail stays
+	void emptyFrameEndsCop() {
+		GraphicsRenderer renderer(200, 100);
+		renderer.addSensor("a", 20, 50, 20, 50, true);
+		renderer.process({{"a", 0, 0, 1}}, 16);
+		QVERIFY(renderer.isSettling());
+
+		renderer.process({}, 16);
+		QVERIFY(!renderer.isSettling());
+		GraphicsFrame frame;
+		renderer.snapshot(frame);
+		QVERIFY(!frame.cop_valid[COP_FOOT_LEFT]);
+		QCOMPARE(frame.cop[COP_FOOT_LEFT].size(), (size_t)1);
+	}
+
+	// the field falls back to 0 without data and then stops rewriting the heatmap
+	void fieldRestsWithoutData() {
+		GraphicsRenderer renderer(200, 100);
+		renderer.setHeatmapField(HEATMAP_FIELD_IDW, HEATMAP_FIELD_DEFAULT_RADIUS, HEATMAP_FIELD_DEFAULT_POWER);
+		renderer.setHeatmapTemporal(HEATMAP_TEMPORAL_DECAY, 100, 0);
+		renderer.addSensor("left", 20, 50, 20, 50, true);
+		renderer.addSensor("right", 20, 50, 20, 50, false);
+		renderer.process({{"left", 0, 0, 1}, {"right", 0, 0, 0.5}}, 16);
+		GraphicsFrame frame;
+		renderer.snapshot(frame);
+		QVERIFY(!blank(frame));
+
+		int frames = 0;
+		while (renderer.isSettling() && frames < 1000) {
+			renderer.process({}, 16);
+			frames++;
+		}
+		QVERIFY(frames < 1000);
+		renderer.snapshot(frame);
+		QVERIFY(blank(frame));
+
+		renderer.process({}, 16);
+		renderer.snapshot(frame);
+		QVERIFY(frame.dirty.isEmpty());
+	}
+};
+
+QTEST_APPLESS_MAIN(TestGraphicsRenderer)
+#include "tst_graphics_renderer.moc"
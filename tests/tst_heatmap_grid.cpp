@@ -0,0 +1,76 @@
+#include "heatmap_grid.hpp"
+
+#include <QtTest>
+#include <algorithm>
+#include <functional>
+
+
+class TestHeatmapGrid : public QObject {
+	Q_OBJECT
+
+private:
+	static bool allZero(const HeatmapGrid& grid) {
+		const int* cells = grid.cells(HEATMAP_FRAME_NEXT);
+		return std::all_of(cells, cells + grid.columns() * grid.rows(), [](int cell) { return cell == 0; });
+	}
+
+	// frames of 16 ms until the grid settles, -1 if it did not within a minute
+	static int framesToSettle(HeatmapGrid& grid, const std::function<void()>& frame) {
+		for (int i = 0; i < 60 * 1000 / 16; i++) {
+			frame();
+			if (!grid.isSettling()) {
+				return i;
+			}
+		}
+		return -1;
+	}
+
+private slots:
+	void batchReplacesFrame() {
+		HeatmapGrid grid(100, 100, 5, 50);
+		const int stride = grid.columns();
+		grid.setCellScalarBatch({{10, 10, HEATMAP_SCALAR_MAX}});
+		QVERIFY(grid.cells(HEATMAP_FRAME_NEXT)[2 * stride + 2] > 0);
+		grid.takeDirtyCells();
+
+		grid.setCellScalarBatch({{90, 90, HEATMAP_SCALAR_MAX}});
+		QCOMPARE(grid.cells(HEATMAP_FRAME_NEXT)[2 * stride + 2], 0);
+		QVERIFY(grid.cells(HEATMAP_FRAME_NEXT)[18 * stride + 18] > 0);
+		const QRect dirty = grid.takeDirtyCells();
+		QVERIFY(dirty.contains(2, 2));
+		QVERIFY(dirty.contains(18, 18));
+		QVERIFY(!grid.isSettling());
+	}
+
+	// every temporal mode has to reach exactly 0 once the data stops, or the renderer keeps redrawing
+	void temporalSettlesAfterRelease() {
+		for (HeatmapTemporal mode : {HEATMAP_TEMPORAL_SMOOTH, HEATMAP_TEMPORAL_DECAY, HEATMAP_TEMPORAL_PEAK_HOLD}) {
+			HeatmapGrid grid(100, 100, 5, 50);
+			grid.setTemporal(mode, 300, 500);
+			for (int i = 0; i < 30; i++) {
+				grid.setCellScalarBatch({{50, 50, 400}}, 16);
+			}
+			QVERIFY(grid.isSettling());
+			const int frames = framesToSettle(grid, [&grid]() { grid.setCellScalarBatch({}, 16); });
+			QVERIFY(frames > 0);
+			QVERIFY(allZero(grid));
+		}
+	}
+
+	void fieldSettlesAfterRelease() {
+		HeatmapGrid grid(100, 100, 5);
+		grid.buildField(HEATMAP_FIELD_IDW, {{20, 50, 0}, {80, 50, 1}}, 10);
+		QVERIFY(grid.hasField());
+		grid.setTemporal(HEATMAP_TEMPORAL_SMOOTH, 300, 500);
+		for (int i = 0; i < 30; i++) {
+			grid.setFieldValues({400, 300}, 16);
+		}
+		QVERIFY(grid.isSettling());
+		const int frames = framesToSettle(grid, [&grid]() { grid.setFieldValues({0, 0}, 16); });
+		QVERIFY(frames > 0);
+		QVERIFY(allZero(grid));
+	}
+};
+
+QTEST_APPLESS_MAIN(TestHeatmapGrid)
+#include "tst_heatmap_grid.moc"
@@ -0,0 +1,117 @@
+#include "json_recording_parser.hpp"
+
+#include <QTemporaryDir>
+#include <QtTest>
+
+
+class TestJsonRecordingParser : public QObject {
+	Q_OBJECT
+
+private:
+	QTemporaryDir dir;
+
+	static bool parse(JsonRecordingParser& parser, const QByteArray& json, RecordingColumnsBuilder& builder) {
+		return parser.parse(json.constData(), json.constData() + json.size(), builder);
+	}
+
+	// error offset of a document the parser has to reject, -1 if it was accepted
+	static qint64 rejectedAt(const QByteArray& json) {
+		JsonRecordingParser parser;
+		RecordingColumnsBuilder builder;
+		return parse(parser, json, builder) ? -1 : parser.errorOffset();
+	}
+
+private slots:
+	void initTestCase() { QVERIFY(dir.isValid()); }
+
+	void parsesRecording() {
+		const QByteArray json = "{\"init_time\": 1700000000123,\n"
+								" \"esp_1\": [[1700000000200, 25, -3, 4, 1000], [1700000000210,25,-2,5,1001]],\n"
+								" \"esp_2\" : [ [ 1700000000205 , 26 , 0 , 0 , -32768 ] ]\n"
+								"}\n";
+		JsonRecordingParser parser;
+		RecordingColumnsBuilder builder;
+		QVERIFY2(parse(parser, json, builder), qPrintable(parser.errorString()));
+		QCOMPARE(parser.sampleCount(), (qint64)3);
+		QCOMPARE(builder.getInitTime(), (qint64)1700000000123);
+		QCOMPARE(builder.keys(), QStringList({"esp_1", "esp_2"}));
+
+		QList<RecordingColumns*> columns = builder.takeColumns();
+		QCOMPARE(columns.size(), (qsizetype)2);
+		QCOMPARE(columns[0]->timestamps, QVector<qint64>({1700000000200, 1700000000210}));
+		QCOMPARE(columns[0]->X, QVector<int16_t>({-3, -2}));
+		QCOMPARE(columns[0]->Z, QVector<int16_t>({1000, 1001}));
+		QCOMPARE(columns[1]->Z, QVector<int16_t>({-32768}));
+		qDeleteAll(columns);
+	}
+
+	// json.dump of python floats and escaped keys of the old recorder
+	void parsesFloatsAndEscapes() {
+		const QByteArray json = "{\"init_time\": 1.5e3, \"a\\\"b\\u00e9\": [[12.6, 1.0, -2.4, 0, 3e2]]}";
+		JsonRecordingParser parser;
+		RecordingColumnsBuilder builder;
+		QVERIFY2(parse(parser, json, builder), qPrintable(parser.errorString()));
+		QCOMPARE(builder.getInitTime(), (qint64)1500);
+		QCOMPARE(builder.keys(), QStringList({QString("a\"b") + QChar(0xe9)}));
+		QList<RecordingColumns*> columns = builder.takeColumns();
+		QCOMPARE(columns[0]->timestamps[0], (qint64)13);
+		QCOMPARE(columns[0]->X[0], (int16_t)-2);
+		QCOMPARE(columns[0]->Z[0], (int16_t)300);
+		qDeleteAll(columns);
+	}
+
+	void emptyRecording() {
+		JsonRecordingParser parser;
+		RecordingColumnsBuilder builder;
+		QVERIFY(parse(parser, " { } ", builder));
+		QVERIFY(builder.keys().isEmpty());
+	}
+
+	void rejectsOtherSchemas() {
+		QCOMPARE(rejectedAt("{\"a\": [[1, 2, 3, 4]]}"), (qint64)18);		// row of 4
+		QCOMPARE(rejectedAt("{\"a\": [[1, 2, 3, 4, 5, 6]]}"), (qint64)21);	// row of 6
+		QCOMPARE(rejectedAt("{\"a\": [[1, 2, 3, 4, 40000]]}"), (qint64)26);	// not int16, after the row
+		QCOMPARE(rejectedAt("{\"a\": []}"), (qint64)7);
+		QCOMPARE(rejectedAt("{\"a\": {}}"), (qint64)6);
+		QCOMPARE(rejectedAt("{\"a\": [[1, 2, \"3\", 4, 5]]}"), (qint64)14);
+		QCOMPARE(rejectedAt("{\"a\": [[1, 2, 3, 4, 5]]"), (qint64)23); // truncated
+		QCOMPARE(rejectedAt("{} {}"), (qint64)3);
+		QCOMPARE(rejectedAt("[]"), (qint64)0);
+	}
+
+	void convertsToBinary() {
+		const QString json_path = dir.filePath("legacy.json");
+		const QString binary_path = dir.filePath("legacy." RECORDING_FILE_SUFFIX);
+		QFile file(json_path);
+		QVERIFY(file.open(QIODevice::WriteOnly));
+		file.write("{\"init_time\": 5, \"b\": [[10, 1, 2, 3, 4], [20, 1, 2, 3, 5]], \"a\": [[15, 0, 0, 0, 7]]}");
+		file.close();
+
+		QString error;
+		qint64 samples = 0;
+		QVERIFY2(convertJsonRecording(json_path, binary_path, &error, &samples), qPrintable(error));
+		QCOMPARE(samples, (qint64)3);
+
+		RecordingReader reader;
+		QVERIFY(reader.open(binary_path));
+		QCOMPARE(reader.initTime(), (qint64)5);
+		QCOMPARE(reader.sensorCount(), 2);
+		QCOMPARE(reader.sensorKey(0), QString("b"));
+		QCOMPARE(reader.sampleCount(0), (qint64)2);
+		QCOMPARE(reader.firstTimestamp(), (qint64)10);
+		QCOMPARE(reader.lastTimestamp(), (qint64)20);
+		const RecordingBlockView view = reader.block(reader.sensorBlocks(1).first());
+		QCOMPARE(view.Z[0], (int16_t)7);
+		reader.close();
+
+		// a file that fails to parse leaves no half written recording behind
+		QVERIFY(file.open(QIODevice::WriteOnly | QIODevice::Truncate));
+		file.write("{\"a\": [[1, 2, 3]]}");
+		file.close();
+		QVERIFY(!convertJsonRecording(json_path, binary_path, &error));
+		QVERIFY(!QFile::exists(binary_path));
+	}
+};
+
+QTEST_APPLESS_MAIN(TestJsonRecordingParser)
+#include "tst_json_recording_parser.moc"
@@ -0,0 +1,92 @@
+#include "lstm_engine.hpp"
+
+#include <QFile>
+#include <QtTest>
+#include <cstring>
+#include <vector>
+
+
+// data/lstm_reference.bin, written by write_reference in model/export_weights.py
+typedef struct {
+	char magic[4];
+	quint32 windows;
+	quint32 timesteps;
+	quint32 frame_size; // 5 sensors * 3 features, flattened like TimeDistributed(Flatten())
+	quint32 classes;
+	quint32 reserved[3];
+} LstmReferenceHeader;
+
+class TestLstmEngine : public QObject {
+	Q_OBJECT
+
+private:
+	LstmReferenceHeader header;
+	std::vector<float> frames; // (windows, timesteps, 5, 3)
+	std::vector<float> probs;  // (windows, classes)
+
+	void compare(const float* actual, const float* expected, int n) {
+		for (int i = 0; i < n; i++) {
+			QVERIFY2(qAbs(actual[i] - expected[i]) < 1e-5f,
+					 qPrintable(QString("%1 vs %2 at %3").arg(actual[i]).arg(expected[i]).arg(i)));
+		}
+	}
+
+private slots:
+	void initTestCase() {
+		QFile file("data/lstm_reference.bin");
+		QVERIFY(file.open(QIODevice::ReadOnly));
+		const QByteArray bytes = file.readAll();
+		QVERIFY(bytes.size() >= (qsizetype)sizeof(header));
+		memcpy(&header, bytes.constData(), sizeof(header));
+		QVERIFY(memcmp(header.magic, "ISLR", sizeof(header.magic)) == 0);
+		frames.resize(header.windows * header.timesteps * header.frame_size);
+		probs.resize(header.windows * header.classes);
+		QCOMPARE((size_t)bytes.size(), sizeof(header) + (frames.size() + probs.size()) * sizeof(float));
+		memcpy(frames.data(), bytes.constData() + sizeof(header), frames.size() * sizeof(float));
+		memcpy(probs.data(), bytes.constData() + sizeof(header) + frames.size() * sizeof(float),
+			   probs.size() * sizeof(float));
+	}
+
+	void load() {
+		LstmEngine engine;
+		QVERIFY2(engine.load("data/lstm_reference.islm"), qPrintable(engine.errorString()));
+		QCOMPARE(engine.inputSize(), (int)header.frame_size);
+		QCOMPARE(engine.outputSize(), (int)header.classes);
+		QVERIFY(!engine.load("data/lstm_reference.bin"));
+		QVERIFY(!engine.isLoaded());
+	}
+
+	// every kernel this CPU has against the Keras probabilities
+	void runMatchesKeras() {
+		for (LstmKernel kernel : {LSTM_KERNEL_SCALAR, LstmEngine::bestKernel()}) {
+			LstmEngine engine;
+			QVERIFY(engine.load("data/lstm_reference.islm"));
+			engine.setKernel(kernel);
+			QCOMPARE(engine.kernel(), kernel);
+			std::vector<float> out(header.classes);
+			for (quint32 w = 0; w < header.windows; w++) {
+				engine.run(frames.data() + w * header.timesteps * header.frame_size, header.timesteps, out.data());
+				compare(out.data(), probs.data() + w * header.classes, header.classes);
+			}
+		}
+	}
+
+	// the streaming path, one step per frame from zero state, ends where the whole window does
+	void stepMatchesKeras() {
+		LstmEngine engine;
+		QVERIFY(engine.load("data/lstm_reference.islm"));
+		std::vector<float> h(engine.units()), c(engine.units()), out(header.classes);
+		for (quint32 w = 0; w < header.windows; w++) {
+			std::fill(h.begin(), h.end(), 0.0f);
+			std::fill(c.begin(), c.end(), 0.0f);
+			for (quint32 t = 0; t < header.timesteps; t++) {
+				engine.step(frames.data() + (w * header.timesteps + t) * header.frame_size, h.data(), c.data());
+			}
+			engine.classify(h.data(), out.data());
+			compare(out.data(), probs.data() + w * header.classes, header.classes);
+		}
+	}
+};
+
+QTEST_APPLESS_MAIN(TestLstmEngine)
+#include "tst_lstm_engine.moc"
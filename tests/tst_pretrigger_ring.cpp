@@ -0,0 +1,100 @@
+#include "pretrigger_ring.hpp"
+
+#include <QTemporaryDir>
+#include <QtTest>
+
+
+class TestPretriggerRing : public QObject {
+	Q_OBJECT
+
+private:
+	QTemporaryDir dir;
+
+	// spills the ring into a recording and returns the timestamps of every sensor as read back
+	QHash<QString, QVector<qint64>> spilled(PretriggerRing& ring, qint64& written) {
+		const QString path = dir.filePath("pretrigger." RECORDING_FILE_SUFFIX);
+		RecordingWriter writer;
+		if (!writer.open(path, 0)) {
+			return {};
+		}
+		written = ring.spill(writer);
+		writer.close();
+
+		QHash<QString, QVector<qint64>> timestamps;
+		RecordingReader reader;
+		if (!reader.open(path)) {
+			return {};
+		}
+		for (int sensor = 0; sensor < reader.sensorCount(); sensor++) {
+			QVector<qint64>& column = timestamps[reader.sensorKey(sensor)];
+			for (const RecordingBlockIndex& index : reader.sensorBlocks(sensor)) {
+				const RecordingBlockView view = reader.block(index);
+				column.append(QVector<qint64>(view.timestamps, view.timestamps + view.count));
+			}
+		}
+		return timestamps;
+	}
+
+private slots:
+	void initTestCase() { QVERIFY(dir.isValid()); }
+
+	void disabledDropsSamples() {
+		PretriggerRing ring;
+		ring.configure(1000, 0);
+		QVERIFY(!ring.isEnabled());
+		ring.push("a", 10, 0, 0, 0, 0);
+		qint64 written = -1;
+		QVERIFY(spilled(ring, written).isEmpty());
+		QCOMPARE(written, (qint64)0);
+	}
+
+	void keepsWindowOldestFirst() {
+		PretriggerRing ring;
+		ring.configure(100, 64);
+		for (qint64 t = 0; t <= 300; t += 10) {
+			ring.push("a", t, 1, 2, 3, 4);
+		}
+		qint64 written = 0;
+		const QHash<QString, QVector<qint64>> timestamps = spilled(ring, written);
+		QCOMPARE(written, (qint64)11);
+		QCOMPARE(timestamps.value("a"), QVector<qint64>({200, 210, 220, 230, 240, 250, 260, 270, 280, 290, 300}));
+	}
+
+	void capacityBoundsRing() {
+		PretriggerRing ring;
+		ring.configure(10000, 4);
+		for (qint64 t = 1; t <= 10; t++) {
+			ring.push("a", t, 0, 0, 0, 0);
+		}
+		qint64 written = 0;
+		QCOMPARE(spilled(ring, written).value("a"), QVector<qint64>({7, 8, 9, 10}));
+	}
+
+	// the window of a sensor ends at its own latest sample, an insole with a late clock keeps its samples
+	void windowPerSensor() {
+		PretriggerRing ring;
+		ring.configure(100, 64);
+		for (qint64 t = 0; t <= 200; t += 50) {
+			ring.push("left", 100000 + t, 0, 0, 0, 0);
+			ring.push("right", t, 0, 0, 0, 0);
+		}
+		qint64 written = 0;
+		const QHash<QString, QVector<qint64>> timestamps = spilled(ring, written);
+		QCOMPARE(timestamps.value("left"), QVector<qint64>({100100, 100150, 100200}));
+		QCOMPARE(timestamps.value("right"), QVector<qint64>({100, 150, 200}));
+	}
+
+	void spillEmptiesRing() {
+		PretriggerRing ring;
+		ring.configure(100, 8);
+		ring.push("a", 5, 0, 0, 0, 0);
+		qint64 written = 0;
+		spilled(ring, written);
+		QCOMPARE(written, (qint64)1);
+		QVERIFY(spilled(ring, written).isEmpty());
+		QCOMPARE(written, (qint64)0);
+	}
+};
+
+QTEST_APPLESS_MAIN(TestPretriggerRing)
+#include "tst_pretrigger_ring.moc"
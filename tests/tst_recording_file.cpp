@@ -0,0 +1,162 @@
+#include "recording_file.hpp"
+
+#include <QTemporaryDir>
+#include <QtTest>
+#include <cstring>
+
+
+class TestRecordingFile : public QObject {
+	Q_OBJECT
+
+private:
+	QTemporaryDir dir;
+
+	// every sample of a sensor as read back through a cursor over its blocks
+	static QVector<qint64> readTimestamps(const RecordingReader& reader, int sensor, QVector<int16_t>& Z) {
+		QVector<RecordingBlockView> views;
+		for (const RecordingBlockIndex& index : reader.sensorBlocks(sensor)) {
+			views.append(reader.block(index));
+		}
+		RecordingCursor cursor(reader.sensorKey(sensor), views);
+		QVector<qint64> timestamps;
+		Z.clear();
+		while (cursor.hasNext()) {
+			qint64 timestamp;
+			int16_t T, X, Y, z;
+			cursor.next(timestamp, T, X, Y, z);
+			timestamps.append(timestamp);
+			Z.append(z);
+		}
+		return timestamps;
+	}
+
+	static bool writeBytes(const QString& path, const QByteArray& bytes) {
+		QFile file(path);
+		return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(bytes) == bytes.size();
+	}
+
+private slots:
+	void initTestCase() { QVERIFY(dir.isValid()); }
+
+	void roundTrip() {
+		const QString path = dir.filePath("round_trip." RECORDING_FILE_SUFFIX);
+		RecordingWriter writer;
+		QVERIFY(writer.open(path, 1000));
+		// more than one block for "a", interleaved with "b" like live data
+		const int n = RECORDING_BLOCK_SAMPLES * 2 + 10;
+		for (int i = 0; i < n; i++) {
+			writer.append("a", 1000 + i, 1, 2, 3, (int16_t)i);
+			if (i % 4 == 0) {
+				writer.append("b", 1000 + i, 4, 5, 6, (int16_t)-i);
+			}
+		}
+		writer.setInitTime(900);
+		QCOMPARE(writer.sampleCount(), (qint64)(n + (n + 3) / 4));
+		QVERIFY(writer.close());
+
+		RecordingReader reader;
+		QVERIFY2(reader.open(path), qPrintable(reader.errorString()));
+		QCOMPARE(reader.initTime(), (qint64)900);
+		QCOMPARE(reader.firstTimestamp(), (qint64)1000);
+		QCOMPARE(reader.lastTimestamp(), (qint64)(1000 + n - 1));
+		QCOMPARE(reader.sensorCount(), 2);
+		QCOMPARE(reader.sensorKey(0), QString("a"));
+		QCOMPARE(reader.sampleCount(0), (qint64)n);
+		QCOMPARE(reader.sensorBlocks(0).size(), (qsizetype)3);
+
+		QVector<int16_t> Z;
+		const QVector<qint64> timestamps = readTimestamps(reader, 0, Z);
+		QCOMPARE(timestamps.size(), (qsizetype)n);
+		for (int i = 0; i < n; i++) {
+			QCOMPARE(timestamps[i], (qint64)(1000 + i));
+			QCOMPARE(Z[i], (int16_t)i);
+		}
+		readTimestamps(reader, 1, Z);
+		QCOMPARE(Z.size(), (qsizetype)((n + 3) / 4));
+		QCOMPARE(Z.last(), (int16_t)-((n - 1) / 4 * 4));
+	}
+
+	void blockIndexAligned() {
+		const QString path = dir.filePath("aligned." RECORDING_FILE_SUFFIX);
+		RecordingWriter writer;
+		QVERIFY(writer.open(path, 0));
+		// odd block sizes and key lengths, every section still has to start on 8 bytes
+		writer.append("abc", 1, 0, 0, 0, 0);
+		for (int i = 0; i < 3; i++) {
+			writer.append("sensor_with_a_longer_key", i, 0, 0, 0, 0);
+		}
+		QVERIFY(writer.close());
+
+		RecordingReader reader;
+		QVERIFY(reader.open(path));
+		for (int sensor = 0; sensor < reader.sensorCount(); sensor++) {
+			for (const RecordingBlockIndex& index : reader.sensorBlocks(sensor)) {
+				QCOMPARE(index.offset % 8, (quint64)0);
+			}
+		}
+		QCOMPARE(reader.fileSize() % 8, (qint64)0);
+	}
+
+	void rejectsBrokenFiles() {
+		const QString path = dir.filePath("valid." RECORDING_FILE_SUFFIX);
+		RecordingWriter writer;
+		QVERIFY(writer.open(path, 0));
+		for (int i = 0; i < 100; i++) {
+			writer.append("a", i, 0, 0, 0, 0);
+		}
+		QVERIFY(writer.close());
+		QFile file(path);
+		QVERIFY(file.open(QIODevice::ReadOnly));
+		const QByteArray valid = file.readAll();
+		file.close();
+
+		const QString broken = dir.filePath("broken." RECORDING_FILE_SUFFIX);
+		RecordingReader reader;
+
+		// a recording that was never closed has no footer
+		QVERIFY(writeBytes(broken, valid.left(valid.size() - sizeof(RecordingFileFooter))));
+		QVERIFY(!reader.open(broken));
+		QVERIFY(!reader.isOpen());
+
+		QByteArray bad_magic = valid;
+		bad_magic[0] = 'X';
+		QVERIFY(writeBytes(broken, bad_magic));
+		QVERIFY(!reader.open(broken));
+
+		// block pointing past the sensor table
+		QByteArray bad_index = valid;
+		RecordingFileFooter footer;
+		memcpy(&footer, valid.constData() + valid.size() - sizeof(footer), sizeof(footer));
+		RecordingBlockIndex entry;
+		memcpy(&entry, valid.constData() + footer.index_offset, sizeof(entry));
+		entry.count = 100000;
+		memcpy(bad_index.data() + footer.index_offset, &entry, sizeof(entry));
+		QVERIFY(writeBytes(broken, bad_index));
+		QVERIFY(!reader.open(broken));
+
+		// offsets near 2^64 whose end wraps around to a plausible value
+		QByteArray wrapped_block = valid;
+		entry.count = 1;
+		entry.offset = 0 - (quint64)8;
+		memcpy(wrapped_block.data() + footer.index_offset, &entry, sizeof(entry));
+		QVERIFY(writeBytes(broken, wrapped_block));
+		QVERIFY(!reader.open(broken));
+
+		QByteArray wrapped_index = valid;
+		RecordingFileFooter bad_footer = footer;
+		bad_footer.index_offset = footer.index_offset - ((quint64)1 << 32);
+		bad_footer.block_count = footer.block_count + (1 << 27); // 2^27 entries of 32 bytes move the end by 2^32
+		memcpy(wrapped_index.data() + wrapped_index.size() - sizeof(bad_footer), &bad_footer, sizeof(bad_footer));
+		QVERIFY(writeBytes(broken, wrapped_index));
+		QVERIFY(!reader.open(broken));
+
+		QVERIFY(writeBytes(broken, QByteArray(16, '\0')));
+		QVERIFY(!reader.open(broken));
+
+		QVERIFY(reader.open(path));
+		QCOMPARE(reader.sampleCount(0), (qint64)100);
+	}
+};
+
+QTEST_APPLESS_MAIN(TestRecordingFile)
+#include "tst_recording_file.moc"
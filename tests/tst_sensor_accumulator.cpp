@@ -0,0 +1,89 @@
+#include "sensor_accumulator.hpp"
+
+#include <QtTest>
+#include <thread>
+#include <vector>
+
+
+class TestSensorAccumulator : public QObject {
+	Q_OBJECT
+
+private slots:
+	void slotsAreStable() {
+		SensorAccumulators accumulators(2);
+		QCOMPARE(accumulators.size(), 0);
+		QCOMPARE(accumulators.slot("left"), 0);
+		QCOMPARE(accumulators.slot("right"), 1);
+		QCOMPARE(accumulators.slot("left"), 0);
+		QCOMPARE(accumulators.slot("third"), -1);
+		QCOMPARE(accumulators.size(), 2);
+		QCOMPARE(accumulators.key(1), QString("right"));
+		accumulators.accumulate(-1, 1, 1, 1); // unregistered sensors are dropped
+		accumulators.accumulate(2, 1, 1, 1);
+	}
+
+	void meansSinceLastTake() {
+		SensorAccumulators accumulators;
+		const int id = accumulators.slot("a");
+		qreal x = 99, y = 99, z = 99;
+		QVERIFY(!accumulators.take(id, x, y, z));
+		QCOMPARE(x, 99.0);
+
+		accumulators.accumulate(id, -3, 10, 0);
+		accumulators.accumulate(id, -4, 20, 1);
+		QVERIFY(accumulators.take(id, x, y, z));
+		QCOMPARE(x, -3.5);
+		QCOMPARE(y, 15.0);
+		QCOMPARE(z, 0.5);
+		QVERIFY(!accumulators.take(id, x, y, z));
+	}
+
+	// a full slot of the most negative and most positive readings must not carry into the count
+	void extremeReadings() {
+		SensorAccumulators accumulators;
+		const int id = accumulators.slot("a");
+		const int n = 1 << 20;
+		for (int i = 0; i < n; i++) {
+			accumulators.accumulate(id, INT16_MIN, INT16_MAX, i % 2 ? INT16_MIN : INT16_MAX);
+		}
+		qreal x, y, z;
+		QVERIFY(accumulators.take(id, x, y, z));
+		QCOMPARE(x, (qreal)INT16_MIN);
+		QCOMPARE(y, (qreal)INT16_MAX);
+		QCOMPARE(z, -0.5);
+	}
+
+	// every take sees matching count and sum, so constant readings always average to themselves
+	void concurrentAccumulate() {
+		SensorAccumulators accumulators;
+		const int id = accumulators.slot("a");
+		const int n = 200000;
+		std::vector<std::thread> writers;
+		for (int t = 0; t < 4; t++) {
+			writers.emplace_back([&accumulators, id]() {
+				for (int i = 0; i < n; i++) {
+					accumulators.accumulate(id, -1000, 7, 32000);
+				}
+			});
+		}
+		int mismatches = 0;
+		qreal x, y, z;
+		for (int i = 0; i < 1000; i++) {
+			if (accumulators.take(id, x, y, z)) {
+				mismatches += (x != 0 && x != -1000) + (y != 0 && y != 7) + (z != 0 && z != 32000);
+			}
+		}
+		for (std::thread& writer : writers) {
+			writer.join();
+		}
+		QCOMPARE(mismatches, 0);
+		if (accumulators.take(id, x, y, z)) {
+			QCOMPARE(x, -1000.0);
+			QCOMPARE(y, 7.0);
+			QCOMPARE(z, 32000.0);
+		}
+	}
+};
+
+QTEST_APPLESS_MAIN(TestSensorAccumulator)
+#include "tst_sensor_accumulator.moc"
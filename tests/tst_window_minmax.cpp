@@ -0,0 +1,104 @@
+#include "chart_autoscale.hpp"
+#include "window_minmax.hpp"
+
+#include <QtTest>
+#include <algorithm>
+#include <vector>
+
+
+class TestWindowMinMax : public QObject {
+	Q_OBJECT
+
+private:
+	// deterministic int16 noise
+	static std::vector<int16_t> noise(int n) {
+		std::vector<int16_t> values(n);
+		quint32 state = 7;
+		for (int i = 0; i < n; i++) {
+			state = state * 1664525u + 1013904223u;
+			values[i] = (int16_t)(state >> 16);
+		}
+		return values;
+	}
+
+private slots:
+	// against a scan of the window after every push, including monotonic runs that fill a deque
+	void minMaxMatchesScan() {
+		std::vector<int16_t> values = noise(3000);
+		for (int i = 1000; i < 1200; i++) {
+			values[i] = i;
+		}
+		for (int i = 2000; i < 2200; i++) {
+			values[i] = -i;
+		}
+		for (int window : {1, 7, 64}) {
+			WindowMinMax minmax(window);
+			QVERIFY(minmax.isEmpty());
+			for (int i = 0; i < (int)values.size(); i++) {
+				minmax.push(values[i]);
+				const auto first = values.begin() + qMax(0, i - window + 1), last = values.begin() + i + 1;
+				QCOMPARE(minmax.min(), (qreal)*std::min_element(first, last));
+				QCOMPARE(minmax.max(), (qreal)*std::max_element(first, last));
+			}
+			minmax.clear();
+			QVERIFY(minmax.isEmpty());
+		}
+	}
+
+	void histogramMatchesSort() {
+		const std::vector<int16_t> values = noise(2000);
+		const int window = 100;
+		WindowHistogram histogram(window);
+		for (int i = 0; i < (int)values.size(); i++) {
+			histogram.push(values[i]);
+			if (i % 97 != 0) {
+				continue;
+			}
+			std::vector<int16_t> sorted(values.begin() + qMax(0, i - window + 1), values.begin() + i + 1);
+			std::sort(sorted.begin(), sorted.end());
+			QCOMPARE(histogram.size(), (int)sorted.size());
+			for (qreal q : {0.0, 0.01, 0.5, 0.99, 1.0}) {
+				const int rank = qBound(0, (int)(q * (sorted.size() - 1) + 0.5), (int)sorted.size() - 1);
+				QCOMPARE(histogram.quantile(q), sorted[rank]);
+			}
+		}
+	}
+
+	void autoscalerPolicies() {
+		ChartAutoscaler autoscaler(4);
+		qreal lo, hi;
+		QVERIFY(!autoscaler.range(lo, hi));
+		for (qreal value : {5.0, -3.0, 8.0, 2.0, 1.0}) {
+			autoscaler.push(value);
+		}
+		QVERIFY(autoscaler.range(lo, hi));
+		QCOMPARE(lo, -3.0);
+		QCOMPARE(hi, 8.0);
+		autoscaler.push(0);
+		QVERIFY(autoscaler.range(lo, hi));
+		QCOMPARE(lo, 0.0);
+		QCOMPARE(hi, 8.0);
+
+		// a restarted chart window must not keep the old range
+		autoscaler.clear();
+		QVERIFY(!autoscaler.range(lo, hi));
+
+		autoscaler.setPolicy(CHART_AUTOSCALE_PERCENTILE);
+		autoscaler.setPercentile(25);
+		for (qreal value : {100.0, 1.0, 2.0, 3.0}) {
+			autoscaler.push(value);
+		}
+		QVERIFY(autoscaler.range(lo, hi));
+		QCOMPARE(lo, 2.0);
+		QCOMPARE(hi, 3.0);
+
+		autoscaler.setPolicy(CHART_AUTOSCALE_FIXED);
+		autoscaler.setFixedRange(10, -10);
+		QVERIFY(autoscaler.range(lo, hi));
+		QCOMPARE(lo, -10.0);
+		QCOMPARE(hi, 10.0);
+	}
+};
+
+QTEST_APPLESS_MAIN(TestWindowMinMax)
+#include "tst_window_minmax.moc"
@@ -0,0 +1,385 @@
+#include "graphics_renderer.hpp"
+#include "json_recording_parser.hpp"
+#include "recording_file.hpp"
+#include "sensor_pipeline.hpp"
+#include "settings_io.hpp"
+
+#include <QAtomicInteger>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileInfo>
+#include <QImage>
+#include <QPainter>
+#include <QPainterPath>
+#include <QRunnable>
+#include <QSemaphore>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QtMinMax>
+#include <vector>
+
+
+/*
+Offline export of the heatmap view of recordings as image sequences:
+	png  : <output>/<recording>/frame_000000.png, ...
+	rgba : <output>/<recording>.rgba, raw frames back to back, e.g.
+		   ffmpeg -f rawvideo -pix_fmt rgba -s 445x557 -r 30 -i walk.rgba walk.mp4
+
+A recording is replayed as fast as it can be read through GraphicsRenderer, the code the GUI renders with, with frames
+paced by the recording timestamps. That part stays sequential since the temporal accumulation and the center of
+pressure trajectory carry over from frame to frame. Every snapshot is then composed into a full size image and
+encoded by its own QRunnable on a QThreadPool, at most a few frames per thread in flight.
+*/
+
+typedef enum {
+	EXPORT_FORMAT_PNG,
+	EXPORT_FORMAT_RGBA,
+	NUM_OF_EXPORT_FORMAT,
+} ExportFormat;
+
+typedef struct {
+	Settings* settings;
+	GraphicsRendererConfig config;
+	ExportFormat format;
+	qreal fps;
+	int width, height;
+	QImage background; // insole scaled to width x height, null for a plain background
+	QDir output_dir;
+} ExportOptions;
+
+typedef struct {
+	QAtomicInteger<qint64> frames, failed, bytes;
+} ExportTotals;
+
+typedef struct {
+	SensorConfig config;
+	qreal sum_x, sum_y, sum_z;
+	int num;
+} ExportSensor;
+
+// same layers as the scene of GraphicsManager: insole, center line, heatmap with trails, arrows
+static void paintFrame(QImage& image, const GraphicsFrame& frame, const ExportOptions& options) {
+	image.fill(QColor(0xf0, 0xf0, 0xf0));
+	QPainter painter(&image);
+	if (!options.background.isNull()) {
+		QPainterPath clip;
+		clip.addRoundedRect(options.background.rect(), 10, 10);
+		painter.setClipPath(clip);
+		painter.drawImage(0, 0, options.background);
+		painter.setClipping(false);
+	}
+	painter.setPen(QPen(Qt::black, 4));
+	painter.drawLine(QLineF(options.width / 2, 0, options.width / 2, options.height));
+
+	painter.setRenderHint(QPainter::SmoothPixmapTransform, false);
+	const QSize heatmap_size = frame.heatmap.size() * GRAPHICS_CELL_SIZE;
+	painter.drawImage(QRect(QPoint(0, 0), heatmap_size), frame.heatmap);
+
+	const QColor cop_colors[NUM_OF_COP_FOOT] = {QColor(0x1f, 0x77, 0xb4), QColor(0x2c, 0xa0, 0x2c)};
+	for (int foot = 0; foot < NUM_OF_COP_FOOT; foot++) {
+		const std::vector<QPointF>& trail = frame.cop[foot];
+		if (trail.empty()) {
+			continue;
+		}
+		painter.setPen(QPen(cop_colors[foot], 2));
+		painter.setBrush(Qt::NoBrush);
+		painter.drawPolyline(trail.data(), (int)trail.size());
+		if (frame.cop_valid[foot]) {
+			painter.setBrush(cop_colors[foot]);
+			painter.drawEllipse(trail.back(), 4, 4);
+		}
+	}
+
+	painter.setPen(QPen(QBrush(Qt::black), 2));
+	painter.drawLines(frame.arrows.data(), (int)frame.arrows.size());
+	painter.setPen(Qt::NoPen);
+	for (const QLineF& arrow : frame.arrows) {
+		QPointF head[3];
+		QColor color;
+		graphicsArrowHead(arrow, head, color);
+		painter.setBrush(color);
+		painter.drawPolygon(head, 3);
+	}
+}
+
+class ExportTask : public QRunnable {
+public:
+	ExportTask(GraphicsFrame* frame_, const QString& path_, qint64 offset_, const ExportOptions* options_,
+			   ExportTotals* totals_, QSemaphore* in_flight_)
+		: frame(frame_), path(path_), offset(offset_), options(options_), totals(totals_), in_flight(in_flight_) {}
+
+	void run() override {
+		QImage image(options->width, options->height, QImage::Format_ARGB32_Premultiplied);
+		paintFrame(image, *frame, *options);
+		delete frame;
+
+		bool ok = false;
+		qint64 bytes = 0;
+		if (options->format == EXPORT_FORMAT_PNG) {
+			ok = image.save(path, "PNG");
+			bytes = ok ? QFileInfo(path).size() : 0;
+		} else {
+			// every task writes its own slice of the one file
+			const QImage rgba = image.convertToFormat(QImage::Format_RGBA8888);
+			QFile file(path);
+			ok = file.open(QIODevice::ReadWrite) && file.seek(offset) &&
+				 file.write((const char*)rgba.constBits(), rgba.sizeInBytes()) == rgba.sizeInBytes();
+			bytes = ok ? rgba.sizeInBytes() : 0;
+		}
+		if (ok) {
+			totals->frames++;
+			totals->bytes += bytes;
+		} else {
+			totals->failed++;
+		}
+		in_flight->release();
+	}
+
+private:
+	GraphicsFrame* frame;
+	QString path;
+	qint64 offset; // of the frame in a rgba file
+	const ExportOptions* options;
+	ExportTotals* totals;
+	QSemaphore* in_flight;
+};
+
+static bool exportRecording(const QString& path, const ExportOptions& options, QThreadPool& pool,
+							QSemaphore& in_flight, ExportTotals& totals, qint64& frames, qint64& span_ms,
+							QString& error) {
+	RecordingReader reader;
+	QList<RecordingColumns*> columns;
+	QList<RecordingCursor*> cursors;
+	if (!loadRecordingCursors(path, reader, columns, cursors, error)) {
+		qDeleteAll(columns);
+		qDeleteAll(cursors);
+		return false;
+	}
+
+	const QString name = QFileInfo(path).completeBaseName();
+	QString frame_path;
+	if (options.format == EXPORT_FORMAT_PNG) {
+		frame_path = options.output_dir.filePath(name);
+		if (!QDir().mkpath(frame_path)) {
+			error = "couldn't create " + frame_path;
+			qDeleteAll(cursors);
+			qDeleteAll(columns);
+			return false;
+		}
+	} else {
+		frame_path = options.output_dir.filePath(name + ".rgba");
+		QFile file(frame_path);
+		if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+			error = "couldn't create " + frame_path;
+			qDeleteAll(cursors);
+			qDeleteAll(columns);
+			return false;
+		}
+	}
+	const qint64 frame_bytes = (qint64)options.width * options.height * 4;
+
+	GraphicsRenderer renderer(options.width, options.height);
+	renderer.setConfig(options.config);
+	std::vector<ExportSensor> sensors;
+	sensors.reserve(cursors.size());
+	for (auto cursor : cursors) {
+		ExportSensor sensor;
+		sensor.config = options.settings ? loadSensorConfig(options.settings, cursor->getKey())
+										 : SensorConfig{true, 0, 0, ROT_0};
+		sensor.sum_x = sensor.sum_y = sensor.sum_z = 0;
+		sensor.num = 0;
+		sensors.push_back(sensor);
+		renderer.addSensor(cursor->getKey(), sensor.config.x, sensor.config.y, sensor.config.x, sensor.config.y,
+						   sensor.config.is_left);
+	}
+
+	// same averaging as GraphicsWorker::updateGraphicsData, data time instead of wall clock
+	const qreal frame_ms = 1000.0 / options.fps;
+	std::vector<GraphicsSample> samples;
+	samples.reserve(sensors.size());
+	frames = 0;
+	auto emitFrame = [&]() {
+		samples.clear();
+		for (int i = 0; i < (int)sensors.size(); i++) {
+			ExportSensor& sensor = sensors[i];
+			if (sensor.num > 0) {
+				const qreal scale = SENSOR_VALUE_SCALE * sensor.num;
+				samples.push_back({cursors[i]->getKey(), sensor.sum_x / scale, sensor.sum_y / scale,
+								   sensor.sum_z / scale});
+			}
+			sensor.sum_x = sensor.sum_y = sensor.sum_z = 0;
+			sensor.num = 0;
+		}
+		renderer.process(samples, qRound(frame_ms));
+
+		GraphicsFrame* frame = new GraphicsFrame;
+		renderer.snapshot(*frame);
+		const QString file = options.format == EXPORT_FORMAT_PNG
+								 ? QDir(frame_path).filePath(QString("frame_%1.png").arg(frames, 6, 10, QChar('0')))
+								 : frame_path;
+		in_flight.acquire();
+		pool.start(new ExportTask(frame, file, frames * frame_bytes, &options, &totals, &in_flight));
+		frames++;
+	};
+
+	qint64 first_ts = 0, last_ts = 0;
+	bool started = false;
+	qint64 timestamp;
+	int16_t T, X, Y, Z;
+	while (true) {
+		int best = -1;
+		for (int i = 0; i < cursors.size(); i++) {
+			if (cursors[i]->hasNext() && (best < 0 || cursors[i]->peekTimestamp() < cursors[best]->peekTimestamp())) {
+				best = i;
+			}
+		}
+		if (best < 0) {
+			break;
+		}
+		cursors[best]->next(timestamp, T, X, Y, Z);
+		if (!started) {
+			first_ts = timestamp;
+			started = true;
+		}
+		last_ts = timestamp;
+		while (timestamp >= first_ts + (frames + 1) * frame_ms) {
+			emitFrame();
+		}
+
+		ExportSensor& sensor = sensors[best];
+		orientSensorData(X, Y, sensor.config.is_left, sensor.config.rot);
+		sensor.sum_x += X;
+		sensor.sum_y += Y;
+		sensor.sum_z += Z;
+		sensor.num++;
+	}
+	if (started) {
+		emitFrame();
+	}
+	span_ms = last_ts - first_ts;
+
+	// the tasks only hold their own frames, the cursors can go before they finish
+	qDeleteAll(cursors);
+	qDeleteAll(columns);
+	return true;
+}
+
+static QStringList collectRecordings(const QStringList& args) {
+	QStringList files;
+	for (const QString& arg : args) {
+		QFileInfo info(arg);
+		if (info.isDir()) {
+			QDir dir(arg);
+			const QStringList entries = dir.entryList({"*." RECORDING_FILE_SUFFIX, "*.json"}, QDir::Files, QDir::Name);
+			for (const QString& entry : entries) {
+				files.append(dir.filePath(entry));
+			}
+		} else {
+			files.append(arg);
+		}
+	}
+	return files;
+}
+
+int main(int argc, char* argv[]) {
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("shoepad_export");
+
+	QCommandLineParser cli;
+	cli.setApplicationDescription("Render the heatmap view of recordings into png or raw rgba frames");
+	cli.addHelpOption();
+	cli.addPositionalArgument("recordings", "Recording files or directories (*." RECORDING_FILE_SUFFIX ", *.json)");
+	QCommandLineOption settings_opt("settings", "Sensor placement and heatmap options.", "path", "settings.json");
+	QCommandLineOption output_opt({"o", "output"}, "Output directory.", "dir", "export");
+	QCommandLineOption format_opt("format", "png or rgba.", "format", "png");
+	QCommandLineOption fps_opt("fps", "Frames per second of data time.", "fps", "30");
+	QCommandLineOption size_opt("size", "Frame size without a background image.", "WxH", "445x557");
+	QCommandLineOption background_opt("background", "Insole image, the frame takes its size scaled into --size.",
+									  "path", "images/insole.jpg");
+	QCommandLineOption jobs_opt({"j", "jobs"}, "Number of frames encoded in parallel, 0 for one per core.", "N", "0");
+	cli.addOptions({settings_opt, output_opt, format_opt, fps_opt, size_opt, background_opt, jobs_opt});
+	cli.process(app);
+
+	QTextStream out(stdout);
+	const QStringList files = collectRecordings(cli.positionalArguments());
+	if (files.isEmpty()) {
+		cli.showHelp(1);
+	}
+
+	Settings* settings = nullptr;
+	if (QFileInfo::exists(cli.value(settings_opt))) {
+		settings = new Settings(cli.value(settings_opt), true);
+	} else {
+		out << "no " << cli.value(settings_opt) << ", all sensors placed at (0, 0)\n";
+	}
+
+	const QString format = cli.value(format_opt).toLower();
+	if (format != "png" && format != "rgba") {
+		out << "unknown format " << format << "\n";
+		return 1;
+	}
+
+	const QStringList size = cli.value(size_opt).split('x');
+	ExportOptions options;
+	options.settings = settings;
+	options.config = loadGraphicsRendererConfig(settings);
+	options.format = format == "png" ? EXPORT_FORMAT_PNG : EXPORT_FORMAT_RGBA;
+	options.fps = qMax(1.0, cli.value(fps_opt).toDouble());
+	options.width = size.size() == 2 ? qMax(10, size[0].toInt()) : 445;
+	options.height = size.size() == 2 ? qMax(10, size[1].toInt()) : 557;
+	// like GraphicsManager::createBackground, the scene is the insole scaled into the view
+	QImage background(cli.value(background_opt));
+	if (!background.isNull()) {
+		options.background = background.scaled(options.width, options.height, Qt::KeepAspectRatio)
+								 .convertToFormat(QImage::Format_ARGB32_Premultiplied);
+		options.width = options.background.width();
+		options.height = options.background.height();
+	} else {
+		out << "no " << cli.value(background_opt) << ", plain background\n";
+	}
+	options.output_dir = QDir(cli.value(output_opt));
+	if (!options.output_dir.mkpath(".")) {
+		out << "couldn't create " << cli.value(output_opt) << "\n";
+		return 1;
+	}
+
+	QThreadPool pool;
+	const int jobs = cli.value(jobs_opt).toInt();
+	pool.setMaxThreadCount(jobs > 0 ? jobs : QThread::idealThreadCount());
+	QSemaphore in_flight(2 * pool.maxThreadCount()); // bounds the snapshots waiting for a thread
+
+	int failed = 0;
+	ExportTotals totals;
+	QElapsedTimer total_timer;
+	total_timer.start();
+	for (const QString& file : files) {
+		QElapsedTimer timer;
+		timer.start();
+		qint64 frames = 0, span_ms = 0;
+		QString error;
+		if (!exportRecording(file, options, pool, in_flight, totals, frames, span_ms, error)) {
+			out << QFileInfo(file).fileName() << ": " << error << "\n";
+			failed++;
+			continue;
+		}
+		pool.waitForDone();
+		const double s = timer.nsecsElapsed() / 1e9;
+		out << QFileInfo(file).fileName() << ": " << frames << " frames, "
+			<< QString::number(span_ms / 1000.0, 'f', 1) << " s of data in " << QString::number(s, 'f', 2) << " s ("
+			<< QString::number(s > 0 ? frames / s : 0, 'f', 0) << " frames/s)\n";
+		out.flush();
+	}
+	const double total_s = total_timer.nsecsElapsed() / 1e9;
+	out << "total: " << totals.frames.loadRelaxed() << " frames, " << totals.failed.loadRelaxed()
+		<< " failed frames, " << failed << " failed recordings, "
+		<< QString::number(totals.bytes.loadRelaxed() / 1024.0 / 1024.0, 'f', 1) << " MB in "
+		<< QString::number(total_s, 'f', 2) << " s, " << options.width << "x" << options.height << " @ "
+		<< options.fps << " fps, " << pool.maxThreadCount() << " threads\n";
+
+	delete settings;
+	return failed || totals.failed.loadRelaxed() ? 1 : 0;
+}
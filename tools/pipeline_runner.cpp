@@ -0,0 +1,376 @@
+#include "data_container.hpp"
+#include "heatmap_grid.hpp"
+#include "json_recording_parser.hpp"
+#include "recording_file.hpp"
+#include "sensor_pipeline.hpp"
+#include "settings_io.hpp"
+#include "worker/classification_worker.hpp"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QMap>
+#include <QTextStream>
+#include <QtMinMax>
+#include <vector>
+
+// clang-format off
+#ifdef _WIN32
+	#include <windows.h>
+	#include <psapi.h>
+#else
+	#include <sys/resource.h>
+#endif
+// clang-format on
+
+
+/*
+Headless run of recordings through the non-GUI pipeline:
+	parse -> orient + DataContainer (ingest) -> per frame averaged heatmap -> ClassificationWorker
+
+Frames and classification slots are paced by the recording timestamps instead of wall clock, so a run is
+deterministic and as fast as the machine allows.
+*/
+
+typedef struct {
+	SensorConfig config;
+	DataContainer* data;
+	qreal sum_x, sum_y, sum_z;
+	int num;
+} RunnerSensor;
+
+typedef struct {
+	qint64 samples = 0, sensors = 0, frames = 0, classifications = 0;
+	qint64 file_bytes = 0, data_span_ms = 0;
+	qint64 parse_ns = 0, ingest_ns = 0, heatmap_ns = 0, classify_ns = 0, total_ns = 0;
+	QMap<QString, int> results;
+	QStringList result_sequence;
+} RunnerStats;
+
+typedef struct {
+	Settings* settings;
+	ClassificationWorker* classifier;
+	int frame_ms, classify_ms, window_size;
+	int heatmap_width, heatmap_height, heatmap_cell, heatmap_decay;
+} RunnerOptions;
+
+static qint64 peakMemoryBytes() {
+#ifdef _WIN32
+	PROCESS_MEMORY_COUNTERS pmc;
+	if (GetProcessMemoryInfo(GetCurrentProcess(), &pmc, sizeof(pmc))) {
+		return pmc.PeakWorkingSetSize;
+	}
+	return -1;
+#else
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) != 0) {
+		return -1;
+	}
+	#ifdef __APPLE__
+	return usage.ru_maxrss;
+	#else
+	return usage.ru_maxrss * 1024;
+	#endif
+#endif
+}
+
+static double nsToMs(qint64 ns) { return ns / 1000.0 / 1000.0; }
+
+static bool runRecording(const QString& path, const RunnerOptions& options, RunnerStats& stats, QString& error) {
+	QElapsedTimer total_timer, stage_timer;
+	total_timer.start();
+
+	RecordingReader reader;
+	QList<RecordingColumns*> columns;
+	QList<RecordingCursor*> cursors;
+	stage_timer.start();
+	const bool loaded = loadRecordingCursors(path, reader, columns, cursors, error);
+	stats.parse_ns = stage_timer.nsecsElapsed();
+	stats.file_bytes = QFileInfo(path).size();
+	if (!loaded) {
+		qDeleteAll(columns);
+		qDeleteAll(cursors);
+		return false;
+	}
+
+	std::vector<RunnerSensor> sensors;
+	sensors.reserve(cursors.size());
+	for (auto cursor : cursors) {
+		RunnerSensor sensor;
+		sensor.config = options.settings ? loadSensorConfig(options.settings, cursor->getKey())
+										 : SensorConfig{true, 0, 0, ROT_0};
+		sensor.data = new DataContainer(options.window_size);
+		sensor.sum_x = sensor.sum_y = sensor.sum_z = 0;
+		sensor.num = 0;
+		sensors.push_back(sensor);
+	}
+	stats.sensors = sensors.size();
+
+	HeatmapGrid heatmap(options.heatmap_width, options.heatmap_height, options.heatmap_cell, options.heatmap_decay);
+	std::vector<std::tuple<int, int, int>> cells;
+	cells.reserve(sensors.size());
+
+	ClassificationWorker* classifier = options.classifier;
+	bool classify_pending = false;
+	QString last_result;
+	QMetaObject::Connection pending_conn, step_conn, result_conn;
+	if (classifier) {
+		pending_conn = QObject::connect(classifier, &ClassificationWorker::sig_classify,
+										[&classify_pending](int) { classify_pending = true; });
+		step_conn = QObject::connect(classifier, &ClassificationWorker::sig_step,
+									 [&classify_pending]() { classify_pending = true; });
+		result_conn = QObject::connect(classifier, &ClassificationWorker::sig_classificationResult,
+									   [&stats](const QString& result) {
+										   stats.classifications++;
+										   stats.results[result]++;
+										   stats.result_sequence.append(result);
+									   });
+	}
+	// classify() runs through a queued connection, drain it inside the classify stage
+	auto runPendingClassification = [&]() {
+		if (!classify_pending) {
+			return;
+		}
+		classify_pending = false;
+		stage_timer.start();
+		QCoreApplication::processEvents();
+		stats.classify_ns += stage_timer.nsecsElapsed();
+	};
+
+	auto renderFrame = [&]() {
+		stage_timer.start();
+		cells.clear();
+		for (RunnerSensor& sensor : sensors) {
+			if (sensor.num > 0) {
+				const qreal z = sensor.sum_z / SENSOR_VALUE_SCALE / sensor.num;
+				const int x = sensorSceneX(sensor.config.x, sensor.config.is_left, options.heatmap_width);
+				cells.emplace_back(x, sensor.config.y, qBound(0.0, z, 1.0) * HEATMAP_SCALAR_MAX);
+			}
+			sensor.sum_x = sensor.sum_y = sensor.sum_z = 0;
+			sensor.num = 0;
+		}
+		if (!cells.empty()) {
+			heatmap.setCellScalarBatch(cells);
+		}
+		stats.heatmap_ns += stage_timer.nsecsElapsed();
+		stats.frames++;
+	};
+
+	QElapsedTimer loop_timer;
+	loop_timer.start();
+	qint64 first_ts = 0, last_ts = 0, next_frame_ts = 0, next_classify_ts = 0;
+	bool started = false;
+	qint64 timestamp;
+	int16_t T, X, Y, Z;
+	while (true) {
+		int best = -1;
+		for (int i = 0; i < cursors.size(); i++) {
+			if (cursors[i]->hasNext() && (best < 0 || cursors[i]->peekTimestamp() < cursors[best]->peekTimestamp())) {
+				best = i;
+			}
+		}
+		if (best < 0) {
+			break;
+		}
+		cursors[best]->next(timestamp, T, X, Y, Z);
+		if (!started) {
+			first_ts = timestamp;
+			next_frame_ts = timestamp + options.frame_ms;
+			next_classify_ts = timestamp + options.classify_ms;
+			started = true;
+		}
+		last_ts = timestamp;
+		while (timestamp >= next_frame_ts) {
+			renderFrame();
+			next_frame_ts += options.frame_ms;
+		}
+		if (classifier && timestamp >= next_classify_ts) {
+			classifier->classifyCurrentSlot();
+			runPendingClassification();
+			next_classify_ts = timestamp + options.classify_ms;
+		}
+
+		RunnerSensor& sensor = sensors[best];
+		if (classifier) {
+			classifier->addData(cursors[best]->getKey(), X, Y, Z);
+			runPendingClassification();
+		}
+		orientSensorData(X, Y, sensor.config.is_left, sensor.config.rot);
+		sensor.data->append(timestamp, X, Y, Z);
+		sensor.sum_x += X;
+		sensor.sum_y += Y;
+		sensor.sum_z += Z;
+		sensor.num++;
+		stats.samples++;
+	}
+	renderFrame();
+	const qint64 loop_ns = loop_timer.nsecsElapsed();
+	stats.ingest_ns = loop_ns - stats.heatmap_ns - stats.classify_ns;
+	stats.data_span_ms = last_ts - first_ts;
+
+	if (classifier) {
+		QObject::disconnect(pending_conn);
+		QObject::disconnect(step_conn);
+		QObject::disconnect(result_conn);
+	}
+	for (RunnerSensor& sensor : sensors) {
+		delete sensor.data;
+	}
+	qDeleteAll(cursors);
+	qDeleteAll(columns);
+	stats.total_ns = total_timer.nsecsElapsed();
+	return true;
+}
+
+static void printStats(QTextStream& out, const QString& path, const RunnerStats& stats) {
+	const double total_s = stats.total_ns / 1e9;
+	out << QFileInfo(path).fileName() << ": " << stats.samples << " samples, " << stats.sensors << " sensors, "
+		<< QString::number(stats.data_span_ms / 1000.0, 'f', 1) << " s of data, "
+		<< QString::number(stats.file_bytes / 1024.0 / 1024.0, 'f', 2) << " MB\n";
+	out << "  throughput     : " << QString::number(total_s > 0 ? stats.samples / total_s : 0, 'f', 0)
+		<< " samples/s (" << QString::number(nsToMs(stats.total_ns), 'f', 2) << " ms total)\n";
+	out << "  parse          : " << QString::number(nsToMs(stats.parse_ns), 'f', 2) << " ms\n";
+	out << "  ingest         : " << QString::number(nsToMs(stats.ingest_ns), 'f', 2) << " ms\n";
+	out << "  heatmap        : " << QString::number(nsToMs(stats.heatmap_ns), 'f', 2) << " ms, " << stats.frames
+		<< " frames\n";
+	out << "  classification : " << QString::number(nsToMs(stats.classify_ns), 'f', 2) << " ms, "
+		<< stats.classifications << " results";
+	for (auto it = stats.results.constBegin(); it != stats.results.constEnd(); ++it) {
+		out << ", " << it.key() << " x" << it.value();
+	}
+	out << "\n";
+	if (!stats.result_sequence.isEmpty()) {
+		out << "  results        : " << stats.result_sequence.join(' ') << "\n";
+	}
+	out << "  peak memory    : " << QString::number(peakMemoryBytes() / 1024.0 / 1024.0, 'f', 1) << " MB\n";
+	out.flush();
+}
+
+static QStringList collectRecordings(const QStringList& args) {
+	QStringList files;
+	for (const QString& arg : args) {
+		QFileInfo info(arg);
+		if (info.isDir()) {
+			QDir dir(arg);
+			const QStringList entries = dir.entryList({"*." RECORDING_FILE_SUFFIX, "*.json"}, QDir::Files, QDir::Name);
+			for (const QString& entry : entries) {
+				files.append(dir.filePath(entry));
+			}
+		} else {
+			files.append(arg);
+		}
+	}
+	return files;
+}
+
+int main(int argc, char* argv[]) {
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("shoepad_runner");
+
+	QCommandLineParser cli;
+	cli.setApplicationDescription("Run recordings through the shoepad pipeline without GUI");
+	cli.addHelpOption();
+	cli.addPositionalArgument("recordings", "Recording files or directories (*." RECORDING_FILE_SUFFIX ", *.json)");
+	QCommandLineOption settings_opt("settings", "Sensor placement file.", "path", "settings.json");
+	QCommandLineOption model_opt("model", "SavedModel directory, classification is skipped if missing.", "path",
+								 "model.pb");
+	QCommandLineOption labels_opt("labels", "Class names file.", "path", "class_names.txt");
+	QCommandLineOption streaming_opt("streaming", "Step the LSTM on every aligned frame, --model is model_step.pb.");
+	QCommandLineOption native_opt("native", "Classify with the native LstmEngine, --model is model.islm.");
+	QCommandLineOption check_opt("check-native", "Repeat every TensorFlow run on these native weights and compare.",
+								 "path");
+	QCommandLineOption tolerance_opt("tolerance", "Largest probability difference --check-native accepts.", "value",
+									 "0.0001");
+	QCommandLineOption frame_opt("frame-ms", "Heatmap frame interval in data time.", "ms", "50");
+	QCommandLineOption classify_opt("classify-ms", "Classification slot interval in data time.", "ms", "1500");
+	QCommandLineOption window_opt("window", "DataContainer capacity per sensor.", "samples", "200");
+	QCommandLineOption size_opt("heatmap-size", "Heatmap size in scene pixels.", "WxH", "445x557");
+	QCommandLineOption repeat_opt("repeat", "Run every recording N times, for profiling.", "N", "1");
+	cli.addOptions({settings_opt, model_opt, labels_opt, streaming_opt, native_opt, check_opt, tolerance_opt, frame_opt,
+					classify_opt, window_opt, size_opt, repeat_opt});
+	cli.process(app);
+
+	QTextStream out(stdout);
+	const QStringList files = collectRecordings(cli.positionalArguments());
+	if (files.isEmpty()) {
+		cli.showHelp(1);
+	}
+
+	Settings* settings = nullptr;
+	if (QFileInfo::exists(cli.value(settings_opt))) {
+		settings = new Settings(cli.value(settings_opt), true);
+	} else {
+		out << "no " << cli.value(settings_opt) << ", all sensors placed at (0, 0)\n";
+	}
+
+	int failed = 0;
+	ClassificationWorker* classifier = nullptr;
+	if (QFileInfo::exists(cli.value(model_opt)) && QFileInfo::exists(cli.value(labels_opt))) {
+		classifier = new ClassificationWorker();
+		classifier->init(QFileInfo(cli.value(model_opt)).absoluteFilePath().toStdString(),
+						 QFileInfo(cli.value(labels_opt)).absoluteFilePath().toStdString(),
+						 cli.isSet(streaming_opt) ? CLASSIFICATION_MODE_STREAMING : CLASSIFICATION_MODE_WINDOW,
+						 cli.isSet(native_opt) ? CLASSIFICATION_BACKEND_NATIVE : CLASSIFICATION_DEFAULT_BACKEND);
+		if (!classifier->isReady()) {
+			out << "failed to load " << cli.value(model_opt) << ", classification disabled\n";
+			delete classifier;
+			classifier = nullptr;
+		} else if (cli.isSet(check_opt) && !classifier->setNativeCheck(cli.value(check_opt).toStdString())) {
+			out << "failed to load " << cli.value(check_opt) << " for --check-native\n";
+			failed++;
+		}
+	} else {
+		out << "no model, classification disabled\n";
+	}
+
+	const QStringList size = cli.value(size_opt).split('x');
+	RunnerOptions options;
+	options.settings = settings;
+	options.classifier = classifier;
+	options.frame_ms = qMax(1, cli.value(frame_opt).toInt());
+	options.classify_ms = qMax(1, cli.value(classify_opt).toInt());
+	options.window_size = qMax(1, cli.value(window_opt).toInt());
+	options.heatmap_width = size.size() == 2 ? qMax(10, size[0].toInt()) : 445;
+	options.heatmap_height = size.size() == 2 ? qMax(10, size[1].toInt()) : 557;
+	options.heatmap_cell = 5;  // same as GraphicsManager::createBackground
+	options.heatmap_decay = 50;
+	const int repeat = qMax(1, cli.value(repeat_opt).toInt());
+
+	qint64 all_samples = 0, all_ns = 0;
+	for (int r = 0; r < repeat; r++) {
+		for (const QString& file : files) {
+			RunnerStats stats;
+			QString error;
+			if (!runRecording(file, options, stats, error)) {
+				out << QFileInfo(file).fileName() << ": " << error << "\n";
+				failed++;
+				continue;
+			}
+			printStats(out, file, stats);
+			all_samples += stats.samples;
+			all_ns += stats.total_ns;
+		}
+	}
+	if (files.size() * repeat > 1) {
+		out << "total: " << all_samples << " samples in " << QString::number(nsToMs(all_ns), 'f', 2) << " ms, "
+			<< QString::number(all_ns > 0 ? all_samples / (all_ns / 1e9) : 0, 'f', 0) << " samples/s, " << failed
+			<< " failed\n";
+	}
+	if (classifier && cli.isSet(check_opt) && classifier->nativeCheckRuns() > 0) {
+		const float tolerance = cli.value(tolerance_opt).toFloat();
+		const bool within = classifier->nativeCheckMaxDiff() <= tolerance;
+		out << "native check: " << classifier->nativeCheckRuns() << " runs, max |diff| "
+			<< QString::number(classifier->nativeCheckMaxDiff(), 'g', 3) << ", "
+			<< classifier->nativeCheckMismatches() << " label mismatches, " << (within ? "within" : "OUTSIDE")
+			<< " tolerance " << tolerance << "\n";
+		if (!within) {
+			failed++;
+		}
+	}
+
+	delete classifier;
+	delete settings;
+	return failed ? 1 : 0;
+}
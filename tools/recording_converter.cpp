@@ -0,0 +1,199 @@
+#include "json_recording_parser.hpp"
+#include "recording_file.hpp"
+
+#include <QAtomicInteger>
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QDir>
+#include <QDirIterator>
+#include <QElapsedTimer>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QRunnable>
+#include <QTextStream>
+#include <QThread>
+#include <QThreadPool>
+#include <QVector>
+#include <algorithm>
+
+
+/*
+Bulk conversion of legacy json recordings into the binary format (*.isrec).
+
+Every file is an independent QRunnable on a QThreadPool, each one streams the json through JsonRecordingParser into a
+RecordingWriter, so memory stays bounded by the writer's pending blocks regardless of the file size. The output is
+written to a temporary file and renamed on success, an interrupted run never leaves a truncated recording behind.
+*/
+
+typedef struct {
+	QAtomicInteger<qint64> converted, skipped, failed;
+	QAtomicInteger<qint64> samples, input_bytes, output_bytes;
+} ConvertTotals;
+
+class ConvertTask : public QRunnable {
+public:
+	ConvertTask(const QString& src_, const QString& dst_, ConvertTotals* totals_, QTextStream* out_, QMutex* out_lock_)
+		: src(src_), dst(dst_), totals(totals_), out(out_), out_lock(out_lock_) {}
+
+	void run() override {
+		QElapsedTimer timer;
+		timer.start();
+
+		const QString tmp = dst + ".part";
+		QString error;
+		qint64 samples = 0;
+		bool ok = convertJsonRecording(src, tmp, &error, &samples);
+		if (ok) {
+			QFile::remove(dst);
+			if (!QFile::rename(tmp, dst)) {
+				QFile::remove(tmp);
+				error = "Couldn't rename " + tmp + " to " + dst;
+				ok = false;
+			}
+		}
+		const qint64 ns = timer.nsecsElapsed();
+
+		QMutexLocker locker(out_lock);
+		if (!ok) {
+			totals->failed++;
+			*out << QFileInfo(src).fileName() << ": " << error << "\n";
+			out->flush();
+			return;
+		}
+		const qint64 in_bytes = QFileInfo(src).size();
+		const qint64 out_bytes = QFileInfo(dst).size();
+		totals->converted++;
+		totals->samples += samples;
+		totals->input_bytes += in_bytes;
+		totals->output_bytes += out_bytes;
+		*out << QFileInfo(src).fileName() << " -> " << QFileInfo(dst).fileName() << ": " << samples << " samples, "
+			 << QString::number(in_bytes / 1024.0 / 1024.0, 'f', 2) << " MB -> "
+			 << QString::number(out_bytes / 1024.0 / 1024.0, 'f', 2) << " MB ("
+			 << QString::number(in_bytes > 0 ? 100.0 * out_bytes / in_bytes : 0, 'f', 1) << "%), "
+			 << QString::number(ns / 1000.0 / 1000.0, 'f', 1) << " ms\n";
+		out->flush();
+	}
+
+private:
+	QString src, dst;
+	ConvertTotals* totals;
+	QTextStream* out;
+	QMutex* out_lock;
+};
+
+typedef struct {
+	QString path;
+	QString relative; // to the directory argument it was found in, the file name for a file argument
+} JsonRecording;
+
+static QVector<JsonRecording> collectJsonRecordings(const QStringList& args, bool recursive) {
+	QVector<JsonRecording> files;
+	for (const QString& arg : args) {
+		QFileInfo info(arg);
+		if (info.isDir()) {
+			const QDir root(arg);
+			QDirIterator it(arg, {"*.json"}, QDir::Files,
+							recursive ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags);
+			while (it.hasNext()) {
+				const QString path = it.next();
+				files.append({path, root.relativeFilePath(path)});
+			}
+		} else {
+			files.append({arg, info.fileName()});
+		}
+	}
+	std::sort(files.begin(), files.end(),
+			  [](const JsonRecording& a, const JsonRecording& b) { return a.path < b.path; });
+	return files;
+}
+
+int main(int argc, char* argv[]) {
+	QCoreApplication app(argc, argv);
+	QCoreApplication::setApplicationName("shoepad_convert");
+
+	QCommandLineParser cli;
+	cli.setApplicationDescription("Convert json recordings to the binary *." RECORDING_FILE_SUFFIX " format");
+	cli.addHelpOption();
+	cli.addPositionalArgument("recordings", "Json recordings or directories containing them");
+	QCommandLineOption output_opt({"o", "output"}, "Output directory keeping input subdirectories, or next to inputs.",
+								  "dir");
+	QCommandLineOption jobs_opt({"j", "jobs"}, "Number of files converted in parallel, 0 for one per core.", "N", "0");
+	QCommandLineOption recursive_opt({"r", "recursive"}, "Descend into subdirectories.");
+	QCommandLineOption force_opt({"f", "force"}, "Convert even if an up to date output already exists.");
+	cli.addOptions({output_opt, jobs_opt, recursive_opt, force_opt});
+	cli.process(app);
+
+	QTextStream out(stdout);
+	const QVector<JsonRecording> files = collectJsonRecordings(cli.positionalArguments(), cli.isSet(recursive_opt));
+	if (files.isEmpty()) {
+		cli.showHelp(1);
+	}
+
+	QDir output_dir;
+	const bool has_output_dir = cli.isSet(output_opt);
+	if (has_output_dir) {
+		output_dir = QDir(cli.value(output_opt));
+		if (!output_dir.mkpath(".")) {
+			out << "couldn't create " << cli.value(output_opt) << "\n";
+			return 1;
+		}
+	}
+
+	// the output directory mirrors the subdirectories of the inputs, files that would still share an output (and its
+	// .part file) are refused before anything runs
+	QStringList outputs;
+	QHash<QString, QString> output_sources;
+	for (const JsonRecording& file : files) {
+		const QFileInfo src(file.path);
+		const QString name = src.completeBaseName() + "." RECORDING_FILE_SUFFIX;
+		const QString dst = has_output_dir ? output_dir.filePath(QFileInfo(file.relative).path() + "/" + name)
+										   : src.dir().filePath(name);
+		const QString key = QDir::cleanPath(QFileInfo(dst).absoluteFilePath());
+		if (output_sources.contains(key)) {
+			out << file.path << " and " << output_sources[key] << " both convert to " << dst << "\n";
+			return 1;
+		}
+		output_sources[key] = file.path;
+		outputs.append(QDir::cleanPath(dst));
+	}
+
+	QThreadPool pool;
+	const int jobs = cli.value(jobs_opt).toInt();
+	pool.setMaxThreadCount(jobs > 0 ? jobs : QThread::idealThreadCount());
+
+	ConvertTotals totals;
+	QMutex out_lock;
+	QElapsedTimer timer;
+	timer.start();
+	for (int i = 0; i < files.size(); i++) {
+		const QFileInfo src(files[i].path);
+		const QString& dst = outputs[i];
+		const QFileInfo dst_info(dst);
+		if (!cli.isSet(force_opt) && dst_info.exists() && dst_info.lastModified() >= src.lastModified()) {
+			totals.skipped++;
+			continue;
+		}
+		if (!dst_info.dir().mkpath(".")) {
+			QMutexLocker locker(&out_lock); // tasks started earlier in this loop already write to out
+			out << "couldn't create " << dst_info.path() << "\n";
+			totals.failed++;
+			continue;
+		}
+		pool.start(new ConvertTask(files[i].path, dst, &totals, &out, &out_lock));
+	}
+	pool.waitForDone();
+	const double total_s = timer.nsecsElapsed() / 1e9;
+
+	const qint64 in_bytes = totals.input_bytes.loadRelaxed();
+	const qint64 out_bytes = totals.output_bytes.loadRelaxed();
+	out << "total: " << totals.converted.loadRelaxed() << " converted, " << totals.skipped.loadRelaxed()
+		<< " up to date, " << totals.failed.loadRelaxed() << " failed, " << pool.maxThreadCount() << " threads\n";
+	out << "  " << totals.samples.loadRelaxed() << " samples, " << QString::number(in_bytes / 1024.0 / 1024.0, 'f', 2)
+		<< " MB -> " << QString::number(out_bytes / 1024.0 / 1024.0, 'f', 2) << " MB, compression ratio "
+		<< QString::number(out_bytes > 0 ? (double)in_bytes / out_bytes : 0, 'f', 2) << "x\n";
+	out << "  " << QString::number(total_s, 'f', 2) << " s, "
+		<< QString::number(total_s > 0 ? in_bytes / 1024.0 / 1024.0 / total_s : 0, 'f', 1) << " MB/s, "
+		<< QString::number(total_s > 0 ? totals.samples.loadRelaxed() / total_s : 0, 'f', 0) << " samples/s\n";
+	return totals.failed.loadRelaxed() ? 1 : 0;
+}